@@ -0,0 +1,218 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Decode cost of the ATT codec (ble/AttPdu.h) on a workstation. A
+ * mix of PDUs, as a client and a server would receive them, is encoded once
+ * and then decoded repeatedly into the callback parameter types.
+ *
+ * The codec is header-only; build with the mbed headers on the include path:
+ *
+ *   g++ -O2 -I<mbed> -I. -Ible benchmarks/AttPduBenchmarks.cpp -o att-benchmarks
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "mbed.h"
+#include "ble/BLE.h"
+#include "ble/AttPdu.h"
+
+static const unsigned ROUNDS  = 2000000;
+static const uint16_t ATT_MTU = 247;
+
+static const uint8_t LONG_UUID[UUID::LENGTH_OF_LONG_UUID] = {
+    0x6E, 0x40, 0x00, 0x01, 0xB5, 0xA3, 0xF3, 0x93, 0xE0, 0xA9, 0xE5, 0x0E, 0x24, 0xDC, 0xCA, 0x9E
+};
+
+struct Pdu {
+    uint8_t  data[ATT_MTU];
+    uint16_t length;
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Decoding produces views into the PDU rather than copying it, so the cost
+ * is per PDU; dividing the length of the PDU by it would not be a rate at
+ * which data is moved.
+ */
+static void
+report(const char *name, unsigned count, double seconds, uint16_t length)
+{
+    printf("%-24s %4uB %10u in %7.3fs  %12.0f PDU/s  %6.1f ns/PDU\n",
+           name, length, count, seconds, count / seconds, seconds * 1e9 / count);
+}
+
+/*
+ * Decoders, as the receive path of a port would run them. Each folds what it
+ * decoded into a checksum so that the work can't be optimized away.
+ */
+static unsigned
+decodeWrite(const Pdu &pdu)
+{
+    AttWriteView view(pdu.data, pdu.length);
+    if (!view.isValid()) {
+        return 0;
+    }
+    GattWriteCallbackParams params;
+    view.toParams(0, &params);
+    return params.handle + params.len + params.data[0];
+}
+
+static unsigned
+decodeHandleValue(const Pdu &pdu)
+{
+    AttHandleValueView view(pdu.data, pdu.length);
+    if (!view.isValid()) {
+        return 0;
+    }
+    GattHVXCallbackParams params;
+    view.toParams(0, &params);
+    return params.handle + params.len + params.data[params.len - 1];
+}
+
+static unsigned
+decodeReadResponse(const Pdu &pdu)
+{
+    AttReadResponseView view(pdu.data, pdu.length);
+    if (!view.isValid()) {
+        return 0;
+    }
+    GattReadCallbackParams params;
+    view.toParams(0, 0x0010, 0, &params);
+    return params.len + params.data[0];
+}
+
+static unsigned
+decodeList(const Pdu &pdu)
+{
+    AttListResponseView view(pdu.data, pdu.length);
+    if (!view.isValid()) {
+        return 0;
+    }
+    unsigned sum = 0;
+    for (unsigned i = 0; i < view.getCount(); i++) {
+        sum += view.getHandle(i) + view.getEndHandle(i) + view.getValue(i)[0];
+    }
+    return sum;
+}
+
+static unsigned
+decodeFindInformation(const Pdu &pdu)
+{
+    AttListResponseView view(pdu.data, pdu.length);
+    if (!view.isValid()) {
+        return 0;
+    }
+    unsigned sum = 0;
+    for (unsigned i = 0; i < view.getCount(); i++) {
+        sum += view.getHandle(i) + view.getUUID(i).getShortUUID();
+    }
+    return sum;
+}
+
+typedef unsigned (*Decoder_t)(const Pdu &pdu);
+
+static void
+run(const char *name, Decoder_t decoderIn, const Pdu &pdu)
+{
+    /* Called through a volatile pointer, so each round really decodes. */
+    Decoder_t volatile decoder  = decoderIn;
+    volatile unsigned  checksum = 0;
+    unsigned           sum      = 0;
+    double             start    = now();
+    for (unsigned i = 0; i < ROUNDS; i++) {
+        sum += decoder(pdu);
+    }
+    double seconds = now() - start;
+    checksum = sum;
+    (void)checksum;
+
+    report(name, ROUNDS, seconds, pdu.length);
+}
+
+int
+main(void)
+{
+    uint8_t value[ATT_MTU];
+    for (unsigned i = 0; i < sizeof(value); i++) {
+        value[i] = (uint8_t)i;
+    }
+
+    Pdu writeCommand;
+    writeCommand.length = AttPdu::buildWrite(writeCommand.data, ATT_MTU, AttPdu::WRITE_CMD, 0x0012, value, 20);
+
+    Pdu notification;
+    notification.length = AttPdu::buildHandleValue(notification.data, ATT_MTU, BLE_HVX_NOTIFICATION, 0x0010, value, ATT_MTU - 3);
+
+    Pdu readResponse;
+    readResponse.length = AttPdu::buildReadResponse(readResponse.data, ATT_MTU, AttPdu::READ_RSP, value, ATT_MTU);
+
+    /* Primary services, as a client sees them during discovery. */
+    Pdu services;
+    {
+        AttListResponseBuilder builder(services.data, ATT_MTU, AttPdu::READ_BY_GROUP_TYPE_RSP);
+        uint8_t                uuid[2];
+        for (GattAttribute::Handle_t handle = 1; ; handle += 8) {
+            AttPdu::writeUint16(uuid, 0x1800 + handle);
+            if (!builder.add(handle, handle + 7, uuid, sizeof(uuid))) {
+                break;
+            }
+        }
+        services.length = builder.getLength();
+    }
+
+    /* 128-bit characteristic declarations. */
+    Pdu characteristics;
+    {
+        AttListResponseBuilder builder(characteristics.data, ATT_MTU, AttPdu::READ_BY_TYPE_RSP);
+        uint8_t                declaration[3 + UUID::LENGTH_OF_LONG_UUID];
+        declaration[0] = GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY;
+        AttPdu::encodeUUID(UUID(LONG_UUID), &declaration[3]);
+        for (GattAttribute::Handle_t handle = 2; ; handle += 3) {
+            AttPdu::writeUint16(&declaration[1], handle + 1);
+            if (!builder.add(handle, declaration, sizeof(declaration))) {
+                break;
+            }
+        }
+        characteristics.length = builder.getLength();
+    }
+
+    Pdu descriptors;
+    {
+        AttListResponseBuilder builder(descriptors.data, ATT_MTU, AttPdu::FIND_INFORMATION_RSP);
+        for (GattAttribute::Handle_t handle = 4; builder.add(handle, UUID(BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG)); handle++) {
+            /* fill the PDU */
+        }
+        descriptors.length = builder.getLength();
+    }
+
+    printf("ATT MTU %u\n", ATT_MTU);
+    run("write command",        decodeWrite,           writeCommand);
+    run("notification",         decodeHandleValue,     notification);
+    run("read response",        decodeReadResponse,    readResponse);
+    run("read by group type",   decodeList,            services);
+    run("read by type",         decodeList,            characteristics);
+    run("find information",     decodeFindInformation, descriptors);
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Throughput and latency of the library on a workstation, using the in-memory
+ * host backend: a peripheral and a central instance are linked in-process and
+ * the time taken by the library (GattServer, GattClient, Gap and the attribute
+ * database) is measured, with the simulated radio costing next to nothing.
+ *
+ * Build it together with the sources in source/ and source/host/, with
+ * TARGET_LIKE_LINUX defined and the mbed headers (mbed.h, CallChain.h) on the
+ * include path, for example:
+ *
+ *   g++ -O2 -DTARGET_LIKE_LINUX -I<mbed> -I. -Ible benchmarks/HostBenchmarks.cpp \
+ *       source/AesCmac.cpp source/BLE.cpp source/GapScanningParams.cpp source/GattAttributeDatabase.cpp \
+ *       source/PreparedWriteQueue.cpp source/GattWriteStream.cpp source/GattDiscoveryEngine.cpp source/GattHVXBuffer.cpp \
+ *       source/host/HostBLEInstance.cpp source/host/HostGap.cpp source/host/HostGattServer.cpp \
+ *       source/host/HostGattClient.cpp -o host-benchmarks
+ *
+ * Add -DBLE_GATT_MTU_SIZE_MAX=247 to measure with a larger ATT MTU.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "mbed.h"
+#include "ble/BLE.h"
+#include "ble/GattWriteStream.h"
+#include "ble/GattHVXBuffer.h"
+#include "ble/host/HostBLEInstance.h"
+#include "ble/services/BatteryService.h"
+
+static const unsigned NOTIFICATION_COUNT = 200000;
+static const unsigned WRITE_COMMAND_COUNT = 200000;
+static const unsigned WRITE_REQUEST_COUNT = 50000;
+static const uint32_t STREAM_LENGTH       = 16 * 1024 * 1024;
+static const unsigned DISCOVERY_COUNT     = 20000;
+
+static const uint8_t BENCHMARK_SERVICE_UUID[UUID::LENGTH_OF_LONG_UUID] = {
+    0x6E, 0x40, 0x00, 0x01, 0xB5, 0xA3, 0xF3, 0x93, 0xE0, 0xA9, 0xE5, 0x0E, 0x24, 0xDC, 0xCA, 0x9E
+};
+static const uint8_t BENCHMARK_SOURCE_UUID[UUID::LENGTH_OF_LONG_UUID] = {
+    0x6E, 0x40, 0x00, 0x02, 0xB5, 0xA3, 0xF3, 0x93, 0xE0, 0xA9, 0xE5, 0x0E, 0x24, 0xDC, 0xCA, 0x9E
+};
+static const uint8_t BENCHMARK_SINK_UUID[UUID::LENGTH_OF_LONG_UUID] = {
+    0x6E, 0x40, 0x00, 0x03, 0xB5, 0xA3, 0xF3, 0x93, 0xE0, 0xA9, 0xE5, 0x0E, 0x24, 0xDC, 0xCA, 0x9E
+};
+
+static const uint16_t PAYLOAD_LEN = BLE_GATT_MTU_SIZE_MAX - 3;
+
+static Gap::Handle_t connectionHandle;
+static bool          connected;
+static unsigned      notificationsReceived;
+static unsigned      writesReceived;
+static unsigned      writeResponsesReceived;
+static unsigned      characteristicsDiscovered;
+static bool          streamComplete;
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+report(const char *name, unsigned count, double seconds, const char *unit)
+{
+    printf("%-28s %10u in %7.3fs  %12.0f %s/s  %8.3f us/op\n", name, count, seconds, count / seconds, unit, seconds * 1e6 / count);
+}
+
+static void
+onConnection(const Gap::ConnectionCallbackParams_t *params)
+{
+    if (params->role == Gap::CENTRAL) {
+        connectionHandle = params->handle;
+        connected        = true;
+    }
+}
+
+static BLE *central;
+
+static void
+onAdvertisement(const Gap::AdvertisementCallbackParams_t *params)
+{
+    if (!connected) {
+        central->gap().connect(params->peerAddr, Gap::ADDR_TYPE_RANDOM_STATIC, NULL, NULL);
+    }
+}
+
+static void
+onHVX(const GattHVXCallbackParams *params)
+{
+    (void)params;
+    notificationsReceived++;
+}
+
+static void
+onDataWrittenAtServer(const GattWriteCallbackParams *params)
+{
+    (void)params;
+    writesReceived++;
+}
+
+static void
+onWriteResponse(const GattWriteCallbackParams *params)
+{
+    (void)params;
+    writeResponsesReceived++;
+}
+
+static void
+onStreamComplete(GattWriteStream *stream, ble_error_t status)
+{
+    (void)stream;
+    (void)status;
+    streamComplete = true;
+}
+
+static void
+onCharacteristicDiscovered(const DiscoveredCharacteristic *characteristic)
+{
+    (void)characteristic;
+    characteristicsDiscovered++;
+}
+
+int
+main(void)
+{
+    HostBLEInstance peripheralInstance;
+    HostBLEInstance centralInstance;
+    BLE             peripheral(&peripheralInstance);
+    BLE             centralBLE(&centralInstance);
+    central = &centralBLE;
+
+    peripheral.init();
+    centralBLE.init();
+
+    /* Peripheral: a streaming service and the battery service. */
+    uint8_t            sourceValue[PAYLOAD_LEN] = {0};
+    uint8_t            sinkValue[PAYLOAD_LEN]   = {0};
+    GattCharacteristic source(UUID(BENCHMARK_SOURCE_UUID), sourceValue, PAYLOAD_LEN, PAYLOAD_LEN,
+                              GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY);
+    GattCharacteristic sink(UUID(BENCHMARK_SINK_UUID), sinkValue, 0, PAYLOAD_LEN,
+                            GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE);
+    GattCharacteristic *characteristics[] = {&source, &sink};
+    GattService         service(UUID(BENCHMARK_SERVICE_UUID), characteristics, sizeof(characteristics) / sizeof(GattCharacteristic *));
+    peripheral.gattServer().addService(service);
+    BatteryService      battery(peripheral);
+
+    peripheral.gattServer().onDataWritten(onDataWrittenAtServer);
+    peripheral.gap().accumulateAdvertisingPayload(GapAdvertisingData::BREDR_NOT_SUPPORTED | GapAdvertisingData::LE_GENERAL_DISCOVERABLE);
+    peripheral.gap().startAdvertising();
+
+    /* Central: scan, connect, raise the MTU and subscribe. */
+    centralBLE.gap().onConnection(onConnection);
+    centralBLE.gattClient().onHVX(onHVX);
+    centralBLE.gattClient().onDataWritten(onWriteResponse);
+    centralBLE.gap().startScan(onAdvertisement);
+    HostBLEInstance::processAll();
+    if (!connected) {
+        printf("failed to connect\n");
+        return 1;
+    }
+    centralBLE.gattClient().exchangeMtu(connectionHandle);
+    HostBLEInstance::processAll();
+
+    const uint8_t cccd[2] = {0x01, 0x00};
+    centralBLE.gattClient().write(GattClient::GATT_OP_WRITE_REQ, connectionHandle, source.getValueHandle() + 1, sizeof(cccd), cccd);
+    HostBLEInstance::processAll();
+
+    printf("ATT MTU %u, payload %u bytes\n", centralBLE.gap().getAttMtu(connectionHandle), PAYLOAD_LEN);
+
+    /* Notifications, as fast as transmit buffers allow. */
+    unsigned sent  = 0;
+    double   start = now();
+    while (notificationsReceived < NOTIFICATION_COUNT) {
+        while ((sent < NOTIFICATION_COUNT) &&
+               (peripheral.gattServer().write(source.getValueHandle(), sourceValue, PAYLOAD_LEN) == BLE_ERROR_NONE)) {
+            sourceValue[0] = (uint8_t)++sent;
+        }
+        HostBLEInstance::processAll();
+    }
+    report("notifications", notificationsReceived, now() - start, "notif");
+
+    /* The same, into a subscription's buffer, drained in batches. */
+    static StaticGattHVXBuffer<8192> notificationBuffer;
+    centralBLE.gattClient().onHVX(connectionHandle, source.getValueHandle(), NULL, &notificationBuffer);
+    unsigned drained = 0;
+    sent  = 0;
+    start = now();
+    while (drained + notificationBuffer.getDroppedCount() < NOTIFICATION_COUNT) {
+        while ((sent < NOTIFICATION_COUNT) &&
+               (peripheral.gattServer().write(source.getValueHandle(), sourceValue, PAYLOAD_LEN) == BLE_ERROR_NONE)) {
+            sourceValue[0] = (uint8_t)++sent;
+        }
+        HostBLEInstance::processAll();
+
+        const uint8_t *value;
+        uint16_t       length;
+        while (notificationBuffer.front(&value, &length)) {
+            drained++;
+            notificationBuffer.pop();
+        }
+    }
+    report("buffered notifications", drained, now() - start, "notif");
+    centralBLE.gattClient().detachHVX(connectionHandle, source.getValueHandle());
+
+    /* Write commands. */
+    sent  = 0;
+    start = now();
+    while (writesReceived < WRITE_COMMAND_COUNT) {
+        while ((sent < WRITE_COMMAND_COUNT) &&
+               (centralBLE.gattClient().write(GattClient::GATT_OP_WRITE_CMD, connectionHandle, sink.getValueHandle(), PAYLOAD_LEN, sinkValue) == BLE_ERROR_NONE)) {
+            sinkValue[0] = (uint8_t)++sent;
+        }
+        HostBLEInstance::processAll();
+    }
+    report("write commands", writesReceived, now() - start, "write");
+
+    /* A bulk transfer with write commands, from a buffer. */
+    static uint8_t  blob[STREAM_LENGTH];
+    GattWriteStream stream(centralBLE);
+    writesReceived = 0;
+    start          = now();
+    stream.start(connectionHandle, sink.getValueHandle(), blob, STREAM_LENGTH, onStreamComplete);
+    while (!streamComplete || (writesReceived < stream.getPacketsSent())) {
+        HostBLEInstance::processAll();
+    }
+    double seconds = now() - start;
+    report("write stream", stream.getPacketsSent(), seconds, "write");
+    printf("(%.1f MB/s, %.1f packets per burst)\n",
+           stream.getBytesSent() / seconds / 1e6, (double)stream.getPacketsSent() / stream.getBursts());
+
+    /* Write requests, one at a time. */
+    start = now();
+    for (unsigned i = 0; i < WRITE_REQUEST_COUNT; i++) {
+        centralBLE.gattClient().write(GattClient::GATT_OP_WRITE_REQ, connectionHandle, sink.getValueHandle(), PAYLOAD_LEN, sinkValue);
+        HostBLEInstance::processAll();
+    }
+    report("write requests", writeResponsesReceived - 1 /* the CCCD */, now() - start, "write");
+
+    /* Complete service discovery. */
+    start = now();
+    for (unsigned i = 0; i < DISCOVERY_COUNT; i++) {
+        centralBLE.gattClient().launchServiceDiscovery(connectionHandle, NULL, onCharacteristicDiscovered);
+        HostBLEInstance::processAll();
+    }
+    report("service discovery", DISCOVERY_COUNT, now() - start, "disc");
+    printf("(%u characteristics per discovery)\n", characteristicsDiscovered / DISCOVERY_COUNT);
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __AES_CMAC_H__
+#define __AES_CMAC_H__
+
+#include <stdint.h>
+
+/**
+ * AES-CMAC (RFC 4493), as used by the Bluetooth Core Specification for the
+ * GATT database hash and for signed writes.
+ *
+ * The message may be supplied in pieces through update(), and getMac() may
+ * be called at any point without disturbing the computation; a MAC over a
+ * growing message is thereby kept up to date at the cost of the new data
+ * only. This is a compact software implementation of AES-128; it favours
+ * code size over speed and isn't hardened against side channels, which is
+ * of no concern for hashing public data.
+ */
+class AesCmac {
+public:
+    static const unsigned BLOCK_SIZE = 16;
+    static const unsigned KEY_SIZE   = 16;
+
+public:
+    /**
+     * @param[in] key
+     *              The 128-bit key, in the byte order of RFC 4493 (the most
+     *              significant byte first).
+     */
+    AesCmac(const uint8_t key[KEY_SIZE]);
+
+    /**
+     * Restart with an empty message, keeping the key.
+     */
+    void reset(void);
+
+    /**
+     * Append to the message.
+     */
+    void update(const uint8_t *data, unsigned length);
+
+    /**
+     * The MAC of the message so far, most significant byte first.
+     */
+    void getMac(uint8_t mac[BLOCK_SIZE]) const;
+
+    /**
+     * Encrypt a single block with the key.
+     */
+    void encrypt(const uint8_t in[BLOCK_SIZE], uint8_t out[BLOCK_SIZE]) const;
+
+private:
+    static const unsigned ROUNDS = 10;
+
+    static void deriveSubkey(const uint8_t in[BLOCK_SIZE], uint8_t out[BLOCK_SIZE]);
+
+private:
+    uint8_t  roundKeys[(ROUNDS + 1) * BLOCK_SIZE];
+    uint8_t  subkey1[BLOCK_SIZE];
+    uint8_t  subkey2[BLOCK_SIZE];
+    uint8_t  chain[BLOCK_SIZE];      /* CBC state over the complete blocks processed so far */
+    uint8_t  pending[BLOCK_SIZE];    /* the last, possibly partial, block: it is processed by getMac() */
+    uint8_t  pendingLength;
+};
+
+#endif // ifndef __AES_CMAC_H__
@@ -0,0 +1,755 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ATT_PDU_H__
+#define __ATT_PDU_H__
+
+#include <string.h>
+#include "blecommon.h"
+#include "UUID.h"
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattCallbackParamTypes.h"
+
+/**
+ * ATT protocol data units (Core Specification Vol 3, Part F, Section 3.4).
+ *
+ * This is a codec for ports which implement the attribute protocol on the
+ * host; it neither allocates nor copies. Received PDUs are decoded through
+ * views (AttWriteView, AttHandleValueView, ...) which are constructed over
+ * the PDU as received and interpret it in place; values handed out are
+ * pointers into the PDU. Each view validates the opcode and length in
+ * isValid(), which must be checked before any other accessor is used.
+ * Outgoing PDUs are encoded by the AttPdu::build*() functions and by
+ * AttListResponseBuilder into caller-provided buffers.
+ *
+ * The views for writes, notifications and read responses fill in the
+ * corresponding GattWriteCallbackParams, GattHVXCallbackParams and
+ * GattReadCallbackParams, referring to the PDU for their data.
+ */
+class AttPdu {
+public:
+    enum Opcode_t {
+        ERROR_RSP                 = 0x01,
+        EXCHANGE_MTU_REQ          = 0x02,
+        EXCHANGE_MTU_RSP          = 0x03,
+        FIND_INFORMATION_REQ      = 0x04,
+        FIND_INFORMATION_RSP      = 0x05,
+        FIND_BY_TYPE_VALUE_REQ    = 0x06,
+        FIND_BY_TYPE_VALUE_RSP    = 0x07,
+        READ_BY_TYPE_REQ          = 0x08,
+        READ_BY_TYPE_RSP          = 0x09,
+        READ_REQ                  = 0x0A,
+        READ_RSP                  = 0x0B,
+        READ_BLOB_REQ             = 0x0C,
+        READ_BLOB_RSP             = 0x0D,
+        READ_MULTIPLE_REQ         = 0x0E,
+        READ_MULTIPLE_RSP         = 0x0F,
+        READ_BY_GROUP_TYPE_REQ    = 0x10,
+        READ_BY_GROUP_TYPE_RSP    = 0x11,
+        WRITE_REQ                 = 0x12,
+        WRITE_RSP                 = 0x13,
+        PREPARE_WRITE_REQ         = 0x16,
+        PREPARE_WRITE_RSP         = 0x17,
+        EXECUTE_WRITE_REQ         = 0x18,
+        EXECUTE_WRITE_RSP         = 0x19,
+        HANDLE_VALUE_NTF          = 0x1B,
+        HANDLE_VALUE_IND          = 0x1D,
+        HANDLE_VALUE_CFM          = 0x1E,
+        WRITE_CMD                 = 0x52,
+        SIGNED_WRITE_CMD          = 0xD2
+    };
+
+    static const uint16_t SIGNATURE_LEN            = 12;
+    static const uint8_t  FIND_INFORMATION_FORMAT_16  = 0x01;
+    static const uint8_t  FIND_INFORMATION_FORMAT_128 = 0x02;
+    static const uint8_t  EXECUTE_WRITE_CANCEL     = 0x00;
+    static const uint8_t  EXECUTE_WRITE_COMMIT     = 0x01;
+
+    /* Error codes used in Error Responses to discovery requests. */
+    static const uint8_t  ERROR_REQUEST_NOT_SUPPORTED  = 0x06;
+    static const uint8_t  ERROR_ATTRIBUTE_NOT_FOUND    = 0x0A;
+    static const uint8_t  ERROR_UNSUPPORTED_GROUP_TYPE = 0x10;
+
+public:
+    static uint16_t readUint16(const uint8_t *buffer) {
+        return (uint16_t)(buffer[0] | (buffer[1] << 8));
+    }
+    static void writeUint16(uint8_t *buffer, uint16_t value) {
+        buffer[0] = (uint8_t)(value & 0xFF);
+        buffer[1] = (uint8_t)(value >> 8);
+    }
+
+    /**
+     * Decode a UUID in its over-the-air (little-endian) form.
+     *
+     * @param[in] length
+     *              2 or 16; anything else yields BLE_UUID_UNKNOWN.
+     */
+    static UUID decodeUUID(const uint8_t *buffer, uint16_t length) {
+        if (length == UUID::LENGTH_OF_LONG_UUID) {
+            UUID::LongUUIDBytes_t longUUID;
+            for (unsigned i = 0; i < UUID::LENGTH_OF_LONG_UUID; i++) {
+                longUUID[i] = buffer[UUID::LENGTH_OF_LONG_UUID - 1 - i];
+            }
+            return UUID(longUUID);
+        }
+        if (length == sizeof(UUID::ShortUUIDBytes_t)) {
+            return UUID(readUint16(buffer));
+        }
+        return UUID();
+    }
+
+    /**
+     * Encode a UUID in its over-the-air (little-endian) form.
+     *
+     * @return the number of bytes written: 2 or 16.
+     */
+    static uint8_t encodeUUID(const UUID &uuid, uint8_t *buffer) {
+        if (uuid.shortOrLong() == UUID::UUID_TYPE_SHORT) {
+            writeUint16(buffer, uuid.getShortUUID());
+            return sizeof(UUID::ShortUUIDBytes_t);
+        }
+
+        const uint8_t *longUUID = uuid.getBaseUUID();
+        for (unsigned i = 0; i < UUID::LENGTH_OF_LONG_UUID; i++) {
+            buffer[i] = longUUID[UUID::LENGTH_OF_LONG_UUID - 1 - i];
+        }
+        return UUID::LENGTH_OF_LONG_UUID;
+    }
+
+    /**
+     * The ATT error code for a rejection returned by an authorization
+     * callback or by GattServer::handlePreparedWriteEvent().
+     */
+    static uint8_t getErrorCode(GattAuthCallbackReply_t reply) {
+        return (uint8_t)(reply & 0xFF);
+    }
+
+    /*
+     * Builders. Each writes a complete PDU into the buffer and returns its
+     * length, or 0 if the buffer (typically sized to the ATT MTU) can't hold it.
+     */
+public:
+    /**
+     * Single byte PDUs: WRITE_RSP, EXECUTE_WRITE_RSP and HANDLE_VALUE_CFM.
+     */
+    static uint16_t buildOpcodeOnly(uint8_t *buffer, uint16_t capacity, Opcode_t opcode) {
+        if (capacity < 1) {
+            return 0;
+        }
+        buffer[0] = opcode;
+        return 1;
+    }
+
+    static uint16_t buildErrorResponse(uint8_t                 *buffer,
+                                       uint16_t                 capacity,
+                                       uint8_t                  requestOpcode,
+                                       GattAttribute::Handle_t  handle,
+                                       uint8_t                  errorCode) {
+        if (capacity < 5) {
+            return 0;
+        }
+        buffer[0] = ERROR_RSP;
+        buffer[1] = requestOpcode;
+        writeUint16(&buffer[2], handle);
+        buffer[4] = errorCode;
+        return 5;
+    }
+
+    /**
+     * @param[in] opcode
+     *              EXCHANGE_MTU_REQ or EXCHANGE_MTU_RSP.
+     */
+    static uint16_t buildExchangeMtu(uint8_t *buffer, uint16_t capacity, Opcode_t opcode, uint16_t mtu) {
+        if (capacity < 3) {
+            return 0;
+        }
+        buffer[0] = opcode;
+        writeUint16(&buffer[1], mtu);
+        return 3;
+    }
+
+    static uint16_t buildFindInformationRequest(uint8_t                 *buffer,
+                                                uint16_t                 capacity,
+                                                GattAttribute::Handle_t  startHandle,
+                                                GattAttribute::Handle_t  endHandle) {
+        if (capacity < 5) {
+            return 0;
+        }
+        buffer[0] = FIND_INFORMATION_REQ;
+        writeUint16(&buffer[1], startHandle);
+        writeUint16(&buffer[3], endHandle);
+        return 5;
+    }
+
+    /**
+     * @param[in] opcode
+     *              READ_BY_TYPE_REQ or READ_BY_GROUP_TYPE_REQ.
+     */
+    static uint16_t buildReadByTypeRequest(uint8_t                 *buffer,
+                                           uint16_t                 capacity,
+                                           Opcode_t                 opcode,
+                                           GattAttribute::Handle_t  startHandle,
+                                           GattAttribute::Handle_t  endHandle,
+                                           const UUID              &type) {
+        if (capacity < 5u + type.getLen()) {
+            return 0;
+        }
+        buffer[0] = opcode;
+        writeUint16(&buffer[1], startHandle);
+        writeUint16(&buffer[3], endHandle);
+        return 5 + encodeUUID(type, &buffer[5]);
+    }
+
+    /**
+     * A Read Request, or a Read Blob Request if the offset is non-zero.
+     */
+    static uint16_t buildReadRequest(uint8_t *buffer, uint16_t capacity, GattAttribute::Handle_t handle, uint16_t offset = 0) {
+        uint16_t length = (offset == 0) ? 3 : 5;
+        if (capacity < length) {
+            return 0;
+        }
+        buffer[0] = (offset == 0) ? READ_REQ : READ_BLOB_REQ;
+        writeUint16(&buffer[1], handle);
+        if (offset != 0) {
+            writeUint16(&buffer[3], offset);
+        }
+        return length;
+    }
+
+    /**
+     * @param[in] opcode
+     *              READ_RSP, READ_BLOB_RSP or READ_MULTIPLE_RSP. As the
+     *              protocol requires, a value longer than the buffer allows
+     *              is truncated rather than rejected.
+     */
+    static uint16_t buildReadResponse(uint8_t *buffer, uint16_t capacity, Opcode_t opcode, const uint8_t *value, uint16_t length) {
+        if (capacity < 1) {
+            return 0;
+        }
+        if (length > capacity - 1) {
+            length = capacity - 1;
+        }
+        buffer[0] = opcode;
+        memcpy(&buffer[1], value, length);
+        return 1 + length;
+    }
+
+    /**
+     * @param[in] opcode
+     *              WRITE_REQ or WRITE_CMD.
+     */
+    static uint16_t buildWrite(uint8_t                 *buffer,
+                               uint16_t                 capacity,
+                               Opcode_t                 opcode,
+                               GattAttribute::Handle_t  handle,
+                               const uint8_t           *value,
+                               uint16_t                 length) {
+        if ((unsigned)capacity < 3u + length) {
+            return 0;
+        }
+        buffer[0] = opcode;
+        writeUint16(&buffer[1], handle);
+        memcpy(&buffer[3], value, length);
+        return 3 + length;
+    }
+
+    /**
+     * @param[in] opcode
+     *              PREPARE_WRITE_REQ or PREPARE_WRITE_RSP.
+     */
+    static uint16_t buildPrepareWrite(uint8_t                 *buffer,
+                                      uint16_t                 capacity,
+                                      Opcode_t                 opcode,
+                                      GattAttribute::Handle_t  handle,
+                                      uint16_t                 offset,
+                                      const uint8_t           *value,
+                                      uint16_t                 length) {
+        if ((unsigned)capacity < 5u + length) {
+            return 0;
+        }
+        buffer[0] = opcode;
+        writeUint16(&buffer[1], handle);
+        writeUint16(&buffer[3], offset);
+        memcpy(&buffer[5], value, length);
+        return 5 + length;
+    }
+
+    static uint16_t buildExecuteWriteRequest(uint8_t *buffer, uint16_t capacity, bool commit) {
+        if (capacity < 2) {
+            return 0;
+        }
+        buffer[0] = EXECUTE_WRITE_REQ;
+        buffer[1] = commit ? EXECUTE_WRITE_COMMIT : EXECUTE_WRITE_CANCEL;
+        return 2;
+    }
+
+    static uint16_t buildHandleValue(uint8_t                 *buffer,
+                                     uint16_t                 capacity,
+                                     HVXType_t                type,
+                                     GattAttribute::Handle_t  handle,
+                                     const uint8_t           *value,
+                                     uint16_t                 length) {
+        if ((unsigned)capacity < 3u + length) {
+            return 0;
+        }
+        buffer[0] = (type == BLE_HVX_INDICATION) ? HANDLE_VALUE_IND : HANDLE_VALUE_NTF;
+        writeUint16(&buffer[1], handle);
+        memcpy(&buffer[3], value, length);
+        return 3 + length;
+    }
+
+private:
+    AttPdu(); /* not instantiable: a collection of constants and static functions */
+};
+
+/**
+ * The common part of all views: a received PDU, as a span of bytes.
+ */
+class AttPduView {
+public:
+    AttPduView(const uint8_t *pduIn, uint16_t lengthIn) : pdu(pduIn), length(lengthIn) {
+        /* empty */
+    }
+
+    uint8_t        getOpcode(void) const {return (length != 0) ? pdu[0] : 0;}
+    const uint8_t *getPdu(void)    const {return pdu;                       }
+    uint16_t       getLength(void) const {return length;                    }
+
+protected:
+    uint16_t readUint16(uint16_t offset) const {
+        return AttPdu::readUint16(&pdu[offset]);
+    }
+
+protected:
+    const uint8_t *pdu;
+    uint16_t       length;
+};
+
+class AttErrorResponseView : public AttPduView {
+public:
+    AttErrorResponseView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length == 5) && (getOpcode() == AttPdu::ERROR_RSP);
+    }
+
+    uint8_t                 getRequestOpcode(void) const {return pdu[1];       }
+    GattAttribute::Handle_t getHandle(void)        const {return readUint16(2);}
+    uint8_t                 getErrorCode(void)     const {return pdu[4];       }
+};
+
+/**
+ * EXCHANGE_MTU_REQ and EXCHANGE_MTU_RSP.
+ */
+class AttExchangeMtuView : public AttPduView {
+public:
+    AttExchangeMtuView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length == 3) && ((getOpcode() == AttPdu::EXCHANGE_MTU_REQ) || (getOpcode() == AttPdu::EXCHANGE_MTU_RSP));
+    }
+
+    uint16_t getMtu(void) const {return readUint16(1);}
+};
+
+/**
+ * Requests over a handle range: FIND_INFORMATION_REQ, READ_BY_TYPE_REQ and
+ * READ_BY_GROUP_TYPE_REQ. The latter two carry an attribute type.
+ */
+class AttHandleRangeRequestView : public AttPduView {
+public:
+    AttHandleRangeRequestView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        switch (getOpcode()) {
+            case AttPdu::FIND_INFORMATION_REQ:
+                return length == 5;
+            case AttPdu::READ_BY_TYPE_REQ:
+            case AttPdu::READ_BY_GROUP_TYPE_REQ:
+                return (length == 5 + sizeof(UUID::ShortUUIDBytes_t)) || (length == 5 + UUID::LENGTH_OF_LONG_UUID);
+            default:
+                return false;
+        }
+    }
+
+    GattAttribute::Handle_t getStartHandle(void) const {return readUint16(1);}
+    GattAttribute::Handle_t getEndHandle(void)   const {return readUint16(3);}
+
+    /**
+     * The protocol requires an Error Response with Invalid Handle for
+     * ranges which fail this check.
+     */
+    bool isRangeValid(void) const {
+        return (getStartHandle() != GattAttribute::INVALID_HANDLE) && (getStartHandle() <= getEndHandle());
+    }
+
+    bool hasType(void) const {return length > 5;                           }
+    UUID getType(void) const {return AttPdu::decodeUUID(&pdu[5], length - 5);}
+};
+
+/**
+ * READ_REQ and READ_BLOB_REQ.
+ */
+class AttReadRequestView : public AttPduView {
+public:
+    AttReadRequestView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return ((length == 3) && (getOpcode() == AttPdu::READ_REQ)) ||
+               ((length == 5) && (getOpcode() == AttPdu::READ_BLOB_REQ));
+    }
+
+    GattAttribute::Handle_t getHandle(void) const {return readUint16(1);                              }
+    uint16_t                getOffset(void) const {return (length == 5) ? readUint16(3) : (uint16_t)0;}
+};
+
+/**
+ * READ_RSP, READ_BLOB_RSP and READ_MULTIPLE_RSP. These don't identify the
+ * attribute; the handle and offset come from the outstanding request.
+ */
+class AttReadResponseView : public AttPduView {
+public:
+    AttReadResponseView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length >= 1) &&
+               ((getOpcode() == AttPdu::READ_RSP) || (getOpcode() == AttPdu::READ_BLOB_RSP) || (getOpcode() == AttPdu::READ_MULTIPLE_RSP));
+    }
+
+    const uint8_t *getValue(void)       const {return &pdu[1];   }
+    uint16_t       getValueLength(void) const {return length - 1;}
+
+    void toParams(Gap::Handle_t           connHandle,
+                  GattAttribute::Handle_t handle,
+                  uint16_t                offset,
+                  GattReadCallbackParams *params) const {
+        params->connHandle = connHandle;
+        params->handle     = handle;
+        params->offset     = offset;
+        params->len        = getValueLength();
+        params->data       = getValue();
+    }
+};
+
+/**
+ * WRITE_REQ, WRITE_CMD and SIGNED_WRITE_CMD. The value of a signed write
+ * excludes the trailing authentication signature.
+ */
+class AttWriteView : public AttPduView {
+public:
+    AttWriteView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        switch (getOpcode()) {
+            case AttPdu::WRITE_REQ:
+            case AttPdu::WRITE_CMD:
+                return length >= 3;
+            case AttPdu::SIGNED_WRITE_CMD:
+                return length >= 3 + AttPdu::SIGNATURE_LEN;
+            default:
+                return false;
+        }
+    }
+
+    bool                    isSigned(void)       const {return getOpcode() == AttPdu::SIGNED_WRITE_CMD;}
+    GattAttribute::Handle_t getHandle(void)      const {return readUint16(1);                          }
+    const uint8_t          *getValue(void)       const {return &pdu[3];                                }
+    uint16_t                getValueLength(void) const {return length - 3 - (isSigned() ? AttPdu::SIGNATURE_LEN : 0);}
+    const uint8_t          *getSignature(void)   const {return isSigned() ? &pdu[length - AttPdu::SIGNATURE_LEN] : NULL;}
+
+    GattWriteCallbackParams::WriteOp_t getWriteOp(void) const {
+        switch (getOpcode()) {
+            case AttPdu::WRITE_REQ:        return GattWriteCallbackParams::OP_WRITE_REQ;
+            case AttPdu::WRITE_CMD:        return GattWriteCallbackParams::OP_WRITE_CMD;
+            case AttPdu::SIGNED_WRITE_CMD: return GattWriteCallbackParams::OP_SIGN_WRITE_CMD;
+            default:                       return GattWriteCallbackParams::OP_INVALID;
+        }
+    }
+
+    void toParams(Gap::Handle_t connHandle, GattWriteCallbackParams *params) const {
+        params->connHandle = connHandle;
+        params->handle     = getHandle();
+        params->writeOp    = getWriteOp();
+        params->offset     = 0;
+        params->len        = getValueLength();
+        params->data       = getValue();
+    }
+};
+
+/**
+ * PREPARE_WRITE_REQ and PREPARE_WRITE_RSP (which echoes the request).
+ */
+class AttPrepareWriteView : public AttPduView {
+public:
+    AttPrepareWriteView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length >= 5) && ((getOpcode() == AttPdu::PREPARE_WRITE_REQ) || (getOpcode() == AttPdu::PREPARE_WRITE_RSP));
+    }
+
+    GattAttribute::Handle_t getHandle(void)      const {return readUint16(1);}
+    uint16_t                getOffset(void)      const {return readUint16(3);}
+    const uint8_t          *getValue(void)       const {return &pdu[5];      }
+    uint16_t                getValueLength(void) const {return length - 5;   }
+
+    void toParams(Gap::Handle_t connHandle, GattWriteCallbackParams *params) const {
+        params->connHandle = connHandle;
+        params->handle     = getHandle();
+        params->writeOp    = GattWriteCallbackParams::OP_PREP_WRITE_REQ;
+        params->offset     = getOffset();
+        params->len        = getValueLength();
+        params->data       = getValue();
+    }
+};
+
+class AttExecuteWriteView : public AttPduView {
+public:
+    AttExecuteWriteView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length == 2) && (getOpcode() == AttPdu::EXECUTE_WRITE_REQ) &&
+               ((pdu[1] == AttPdu::EXECUTE_WRITE_CANCEL) || (pdu[1] == AttPdu::EXECUTE_WRITE_COMMIT));
+    }
+
+    bool isCommit(void) const {return pdu[1] == AttPdu::EXECUTE_WRITE_COMMIT;}
+
+    void toParams(Gap::Handle_t connHandle, GattWriteCallbackParams *params) const {
+        params->connHandle = connHandle;
+        params->handle     = GattAttribute::INVALID_HANDLE;
+        params->writeOp    = isCommit() ? GattWriteCallbackParams::OP_EXEC_WRITE_REQ_NOW : GattWriteCallbackParams::OP_EXEC_WRITE_REQ_CANCEL;
+        params->offset     = 0;
+        params->len        = 0;
+        params->data       = NULL;
+    }
+};
+
+/**
+ * HANDLE_VALUE_NTF and HANDLE_VALUE_IND.
+ */
+class AttHandleValueView : public AttPduView {
+public:
+    AttHandleValueView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        return (length >= 3) && ((getOpcode() == AttPdu::HANDLE_VALUE_NTF) || (getOpcode() == AttPdu::HANDLE_VALUE_IND));
+    }
+
+    HVXType_t               getType(void)        const {return (getOpcode() == AttPdu::HANDLE_VALUE_IND) ? BLE_HVX_INDICATION : BLE_HVX_NOTIFICATION;}
+    GattAttribute::Handle_t getHandle(void)      const {return readUint16(1);}
+    const uint8_t          *getValue(void)       const {return &pdu[3];      }
+    uint16_t                getValueLength(void) const {return length - 3;   }
+
+    void toParams(Gap::Handle_t connHandle, GattHVXCallbackParams *params) const {
+        params->connHandle = connHandle;
+        params->handle     = getHandle();
+        params->type       = getType();
+        params->len        = getValueLength();
+        params->data       = getValue();
+    }
+};
+
+/**
+ * The list responses: FIND_INFORMATION_RSP, READ_BY_TYPE_RSP and
+ * READ_BY_GROUP_TYPE_RSP. Each carries a sequence of elements of equal
+ * length, starting with an attribute handle; the group variant follows it
+ * with the group's end handle. The rest of each element is a UUID (for
+ * Find Information) or a value.
+ */
+class AttListResponseView : public AttPduView {
+public:
+    AttListResponseView(const uint8_t *pduIn, uint16_t lengthIn) : AttPduView(pduIn, lengthIn) {
+        /* empty */
+    }
+
+    bool isValid(void) const {
+        unsigned elementLength = getElementLength();
+        return (elementLength > getHeaderLength()) &&
+               (length >= 2 + elementLength) &&
+               (((length - 2) % elementLength) == 0);
+    }
+
+    unsigned getCount(void) const {return (length - 2) / getElementLength();}
+
+    GattAttribute::Handle_t getHandle(unsigned index) const {
+        return readUint16(2 + index * getElementLength());
+    }
+
+    /**
+     * For READ_BY_GROUP_TYPE_RSP: the last handle of the group.
+     */
+    GattAttribute::Handle_t getEndHandle(unsigned index) const {
+        return (getOpcode() == AttPdu::READ_BY_GROUP_TYPE_RSP) ? readUint16(4 + index * getElementLength()) : getHandle(index);
+    }
+
+    const uint8_t *getValue(unsigned index) const {
+        return &pdu[2 + index * getElementLength() + getHeaderLength()];
+    }
+    uint16_t getValueLength(void) const {
+        return getElementLength() - getHeaderLength();
+    }
+
+    /**
+     * For FIND_INFORMATION_RSP: the type of the attribute.
+     */
+    UUID getUUID(unsigned index) const {
+        return AttPdu::decodeUUID(getValue(index), getValueLength());
+    }
+
+private:
+    unsigned getHeaderLength(void) const {
+        return (getOpcode() == AttPdu::READ_BY_GROUP_TYPE_RSP) ? 4 : 2;
+    }
+
+    unsigned getElementLength(void) const {
+        if (length < 2) {
+            return 0;
+        }
+        switch (getOpcode()) {
+            case AttPdu::FIND_INFORMATION_RSP:
+                return (pdu[1] == AttPdu::FIND_INFORMATION_FORMAT_16)  ? 2 + sizeof(UUID::ShortUUIDBytes_t) :
+                       (pdu[1] == AttPdu::FIND_INFORMATION_FORMAT_128) ? 2 + UUID::LENGTH_OF_LONG_UUID : 0;
+            case AttPdu::READ_BY_TYPE_RSP:
+            case AttPdu::READ_BY_GROUP_TYPE_RSP:
+                return pdu[1];
+            default:
+                return 0;
+        }
+    }
+};
+
+/**
+ * Encoder for the list responses (see AttListResponseView). Elements are
+ * appended until one doesn't fit the buffer or differs in length from the
+ * first, which is where the response has to end.
+ */
+class AttListResponseBuilder {
+public:
+    /**
+     * @param[in] opcode
+     *              FIND_INFORMATION_RSP, READ_BY_TYPE_RSP or READ_BY_GROUP_TYPE_RSP.
+     */
+    AttListResponseBuilder(uint8_t *bufferIn, uint16_t capacityIn, AttPdu::Opcode_t opcodeIn) :
+        buffer(bufferIn), capacity(capacityIn), length(0), elementLength(0), opcode(opcodeIn) {
+        if (capacity >= 2) {
+            buffer[0] = opcode;
+            length    = 2;
+        }
+    }
+
+    /**
+     * Append an element of a FIND_INFORMATION_RSP.
+     */
+    bool add(GattAttribute::Handle_t handle, const UUID &type) {
+        uint8_t encodedType[UUID::LENGTH_OF_LONG_UUID];
+        uint8_t typeLength = AttPdu::encodeUUID(type, encodedType);
+        if (!start(2 + typeLength)) {
+            return false;
+        }
+        buffer[1] = (typeLength == sizeof(UUID::ShortUUIDBytes_t)) ? AttPdu::FIND_INFORMATION_FORMAT_16 : AttPdu::FIND_INFORMATION_FORMAT_128;
+        AttPdu::writeUint16(&buffer[length], handle);
+        memcpy(&buffer[length + 2], encodedType, typeLength);
+        length += elementLength;
+        return true;
+    }
+
+    /**
+     * Append an element of a READ_BY_TYPE_RSP. Values are limited to 253
+     * bytes, and to what fits in the buffer; longer ones are truncated.
+     */
+    bool add(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t valueLength) {
+        valueLength = clampValueLength(2, valueLength);
+        if (!start(2 + valueLength)) {
+            return false;
+        }
+        buffer[1] = elementLength;
+        AttPdu::writeUint16(&buffer[length], handle);
+        memcpy(&buffer[length + 2], value, valueLength);
+        length += elementLength;
+        return true;
+    }
+
+    /**
+     * Append an element of a READ_BY_GROUP_TYPE_RSP. Values are limited as
+     * for READ_BY_TYPE_RSP, to 251 bytes.
+     */
+    bool add(GattAttribute::Handle_t handle, GattAttribute::Handle_t endHandle, const uint8_t *value, uint16_t valueLength) {
+        valueLength = clampValueLength(4, valueLength);
+        if (!start(4 + valueLength)) {
+            return false;
+        }
+        buffer[1] = elementLength;
+        AttPdu::writeUint16(&buffer[length], handle);
+        AttPdu::writeUint16(&buffer[length + 2], endHandle);
+        memcpy(&buffer[length + 4], value, valueLength);
+        length += elementLength;
+        return true;
+    }
+
+    unsigned getCount(void) const {return (elementLength != 0) ? (length - 2) / elementLength : 0;}
+
+    /**
+     * @return the length of the PDU, or 0 if no element has been added (a
+     *         list response can't be empty; reply with an Error Response).
+     */
+    uint16_t getLength(void) const {return (elementLength != 0) ? length : 0;}
+
+private:
+    uint16_t clampValueLength(unsigned headerLength, uint16_t valueLength) const {
+        unsigned limit = 0xFF - headerLength;
+        if ((elementLength == 0) && (capacity > 2 + headerLength) && (capacity - 2 - headerLength < limit)) {
+            limit = capacity - 2 - headerLength;
+        }
+        return (valueLength > limit) ? (uint16_t)limit : valueLength;
+    }
+
+    bool start(unsigned newElementLength) {
+        if ((length == 0) || ((elementLength != 0) && (newElementLength != elementLength)) ||
+            ((unsigned)length + newElementLength > capacity)) {
+            return false;
+        }
+        elementLength = (uint8_t)newElementLength;
+        return true;
+    }
+
+private:
+    uint8_t          *buffer;
+    uint16_t          capacity;
+    uint16_t          length;
+    uint8_t           elementLength;
+    AttPdu::Opcode_t  opcode;
+};
+
+#endif // ifndef __ATT_PDU_H__
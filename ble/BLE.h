@@ -1332,6 +1332,15 @@ public:
         /* empty */
     }
 
+    /**
+     * Wrap a given transport instead of the one from createBLEInstance().
+     * This allows several BLE objects in one program, as with the in-memory
+     * host backend (see ble/host/HostBLEInstance.h).
+     */
+    explicit BLE(BLEInstanceBase *transportIn) : transport(transportIn) {
+        /* empty */
+    }
+
 private:
     BLEInstanceBase *const transport; /* the device specific backend */
 };
@@ -0,0 +1,532 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BLE_COROUTINE_H__
+#define __BLE_COROUTINE_H__
+
+/*
+ * An optional facade over the central-role procedures for C++20 coroutines.
+ * Nothing else in the library depends on it; with an older compiler, or
+ * without coroutine support, including it has no effect.
+ *
+ * A BLETask is a coroutine which runs as soon as it is called, up to its
+ * first co_await, and is afterwards resumed from within the event which
+ * completes the awaited operation. Each operation in flight needs nothing
+ * but its coroutine's frame, so a link can have as many outstanding as there
+ * are frames and request queue entries, without thread stacks. Frames come
+ * from a fixed pool; when it is exhausted the coroutine doesn't run at all,
+ * and the task it returns says so.
+ *
+ * The awaitables are meant to be awaited as temporaries, where they are
+ * constructed: they may refer to their arguments rather than copy them.
+ *
+ * @section EXAMPLE
+ *
+ * @code
+ *
+ * BLETask readBatteryLevel(BLE &ble, Gap::Handle_t connection, GattAttribute::Handle_t handle) {
+ *     GattClient::RequestResult_t result = co_await GattReadAwaitable(ble.gattClient(), connection, handle);
+ *     if (result.status == BLE_ERROR_NONE) {
+ *         printf("battery level %u\r\n", result.data[0]);
+ *     }
+ * }
+ *
+ * @endcode
+ */
+
+#if defined(__cpp_impl_coroutine) && (__cplusplus >= 202002L)
+
+#include <stddef.h>
+#include <string.h>
+#include <coroutine>
+#include <exception>
+
+#include "Gap.h"
+#include "GattClient.h"
+#include "UUIDSet.h"
+
+#ifndef BLE_COROUTINE_MAX_FRAMES
+#define BLE_COROUTINE_MAX_FRAMES 8 /**< Coroutines which may be alive at once. */
+#endif
+
+#ifndef BLE_COROUTINE_FRAME_SIZE
+#define BLE_COROUTINE_FRAME_SIZE 384 /**< Bytes per coroutine frame, which holds its locals and the awaitables it uses; a coroutine whose frame is larger can't be started. */
+#endif
+
+#if BLE_COROUTINE_MAX_FRAMES > 32
+#error "the frame pool's free mask holds at most 32 frames"
+#endif
+
+/**
+ * The fixed pool from which coroutine frames are allocated.
+ */
+class BLECoroutineFramePool {
+public:
+    static void *allocate(size_t size) {
+        if (size > BLE_COROUTINE_FRAME_SIZE) {
+            return NULL;
+        }
+        for (unsigned i = 0; i < BLE_COROUTINE_MAX_FRAMES; i++) {
+            if (!(inUse & (1UL << i))) {
+                inUse |= (1UL << i);
+                return frames[i].bytes;
+            }
+        }
+        return NULL;
+    }
+
+    static void release(void *frame) {
+        unsigned index = (unsigned)(((Frame_t *)frame) - frames);
+        inUse &= ~(1UL << index);
+    }
+
+    static unsigned getFreeCount(void) {
+        unsigned count = 0;
+        for (unsigned i = 0; i < BLE_COROUTINE_MAX_FRAMES; i++) {
+            if (!(inUse & (1UL << i))) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Frame_t {
+        alignas(max_align_t) unsigned char bytes[BLE_COROUTINE_FRAME_SIZE];
+    };
+
+    inline static Frame_t  frames[BLE_COROUTINE_MAX_FRAMES];
+    inline static uint32_t inUse = 0;
+};
+
+/**
+ * The return type of a coroutine driving BLE procedures. The coroutine owns
+ * its frame, which is returned to the pool when it finishes; the task is
+ * only a receipt.
+ */
+class BLETask {
+public:
+    struct promise_type {
+        BLETask get_return_object(void) {
+            return BLETask(true);
+        }
+
+        /* Called instead of raising std::bad_alloc, which makes the frame pool usable without exceptions. */
+        static BLETask get_return_object_on_allocation_failure(void) {
+            return BLETask(false);
+        }
+
+        static void *operator new(size_t size) noexcept {
+            return BLECoroutineFramePool::allocate(size);
+        }
+
+        static void operator delete(void *frame) {
+            BLECoroutineFramePool::release(frame);
+        }
+
+        std::suspend_never initial_suspend(void) noexcept {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend(void) noexcept {
+            return std::suspend_never();
+        }
+
+        void return_void(void) {
+            /* empty */
+        }
+
+        /* Nothing awaits a BLETask, so there is no one to rethrow to. */
+        void unhandled_exception(void) {
+            std::terminate();
+        }
+    };
+
+public:
+    /**
+     * @return false if no frame was available, in which case the coroutine
+     * didn't run.
+     */
+    bool isStarted(void) const {
+        return started;
+    }
+
+private:
+    BLETask(bool _started) : started(_started) {
+        /* empty */
+    }
+
+private:
+    bool started;
+};
+
+/**
+ * The part common to the awaitables below: an operation may complete from
+ * within the call which starts it (if the stack rejects a request, for
+ * instance), in which case the coroutine carries on without suspending.
+ */
+class BLEAwaitable {
+public:
+    bool await_ready(void) const {
+        return false;
+    }
+
+protected:
+    BLEAwaitable() : coroutine(), starting(false), completed(false) {
+        /* empty */
+    }
+
+    /**
+     * Start the operation, and suspend unless it has completed already.
+     */
+    template<typename Starter>
+    bool suspendWhile(std::coroutine_handle<> _coroutine, Starter start) {
+        coroutine = _coroutine;
+        starting  = true;
+        bool started = start();
+        starting  = false;
+        return started && !completed;
+    }
+
+    void complete(void) {
+        completed = true;
+        if (!starting) {
+            coroutine.resume();
+        }
+    }
+
+private:
+    std::coroutine_handle<> coroutine;
+    bool                    starting;
+    bool                    completed;
+};
+
+/**
+ * co_await GattReadAwaitable(client, connection, handle) issues a read
+ * through the client's request queue, and resumes with its
+ * GattClient::RequestResult_t once the response arrives. The value it
+ * points to remains valid until the coroutine next suspends.
+ */
+class GattReadAwaitable : public BLEAwaitable {
+public:
+    GattReadAwaitable(GattClient &_client, Gap::Handle_t connHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset = 0) :
+        client(_client), result() {
+        result.connHandle = connHandle;
+        result.handle     = attributeHandle;
+        result.offset     = offset;
+    }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+        return suspendWhile(coroutine, [this]() {
+            ble_error_t error = client.queueRead(result.connHandle, result.handle, result.offset, onResult, this);
+            if (error != BLE_ERROR_NONE) {
+                result.status = error;
+            }
+            return error == BLE_ERROR_NONE;
+        });
+    }
+
+    GattClient::RequestResult_t await_resume(void) const {
+        return result;
+    }
+
+private:
+    static void onResult(const GattClient::RequestResult_t *params) {
+        GattReadAwaitable *awaitable = static_cast<GattReadAwaitable *>(params->context);
+        awaitable->result = *params;
+        awaitable->complete();
+    }
+
+private:
+    GattClient                  &client;
+    GattClient::RequestResult_t  result;
+};
+
+/**
+ * co_await GattWriteAwaitable(client, cmd, connection, handle, length, value)
+ * issues a write through the client's request queue, and resumes with its
+ * GattClient::RequestResult_t once it is acknowledged (or, for a write
+ * command, sent). The value must remain valid until then.
+ */
+class GattWriteAwaitable : public BLEAwaitable {
+public:
+    GattWriteAwaitable(GattClient              &_client,
+                       GattClient::WriteOp_t    _cmd,
+                       Gap::Handle_t            connHandle,
+                       GattAttribute::Handle_t  attributeHandle,
+                       size_t                   _length,
+                       const uint8_t           *_value) :
+        client(_client), cmd(_cmd), length(_length), value(_value), result() {
+        result.connHandle = connHandle;
+        result.handle     = attributeHandle;
+    }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+        return suspendWhile(coroutine, [this]() {
+            ble_error_t error = client.queueWrite(cmd, result.connHandle, result.handle, length, value, onResult, this);
+            if (error != BLE_ERROR_NONE) {
+                result.status = error;
+            }
+            return error == BLE_ERROR_NONE;
+        });
+    }
+
+    GattClient::RequestResult_t await_resume(void) const {
+        return result;
+    }
+
+private:
+    static void onResult(const GattClient::RequestResult_t *params) {
+        GattWriteAwaitable *awaitable = static_cast<GattWriteAwaitable *>(params->context);
+        awaitable->result = *params;
+        awaitable->complete();
+    }
+
+private:
+    GattClient                  &client;
+    GattClient::WriteOp_t        cmd;
+    size_t                       length;
+    const uint8_t               *value;
+    GattClient::RequestResult_t  result;
+};
+
+/**
+ * co_await ServiceDiscoveryAwaitable(client, connection, sc, cc, ...) runs
+ * service discovery on a connection, as launched by
+ * GattClient::launchServiceDiscovery(); services and characteristics are
+ * still reported through sc and cc as they are found. It resumes once
+ * discovery terminates, with BLE_ERROR_NONE, or with the error which kept
+ * it from being launched.
+ */
+class ServiceDiscoveryAwaitable : public BLEAwaitable {
+public:
+    ServiceDiscoveryAwaitable(GattClient                                 &_client,
+                              Gap::Handle_t                               _connHandle,
+                              ServiceDiscovery::ServiceCallback_t         _sc                  = NULL,
+                              ServiceDiscovery::CharacteristicCallback_t  _cc                  = NULL,
+                              const UUID                                 &matchingServiceUUID  = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                              const UUID                                 &matchingCharacteristicUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) :
+        client(_client), connHandle(_connHandle), sc(_sc), cc(_cc),
+        serviceUUID(&matchingServiceUUID), characteristicUUID(&matchingCharacteristicUUID),
+        serviceUUIDs(NULL), characteristicUUIDs(NULL), error(BLE_ERROR_NONE), next(NULL) {
+        /* empty */
+    }
+
+    /**
+     * Discovery matching sets of UUIDs, as for the corresponding overload of
+     * GattClient::launchServiceDiscovery(). The sets must remain valid until
+     * discovery terminates.
+     */
+    ServiceDiscoveryAwaitable(GattClient                                 &_client,
+                              Gap::Handle_t                               _connHandle,
+                              ServiceDiscovery::ServiceCallback_t         _sc,
+                              ServiceDiscovery::CharacteristicCallback_t  _cc,
+                              const UUIDSet                              &matchingServiceUUIDs,
+                              const UUIDSet                              &matchingCharacteristicUUIDs) :
+        client(_client), connHandle(_connHandle), sc(_sc), cc(_cc),
+        serviceUUID(NULL), characteristicUUID(NULL),
+        serviceUUIDs(&matchingServiceUUIDs), characteristicUUIDs(&matchingCharacteristicUUIDs), error(BLE_ERROR_NONE), next(NULL) {
+        /* empty */
+    }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+        /* Registered first, as discovery may terminate before launching returns. */
+        next    = waiting;
+        waiting = this;
+        return suspendWhile(coroutine, [this]() {
+            ble_error_t launchError;
+            if (serviceUUIDs != NULL) {
+                launchError = client.launchServiceDiscovery(connHandle, sc, cc, *serviceUUIDs, *characteristicUUIDs, onTermination);
+            } else {
+                launchError = client.launchServiceDiscovery(connHandle, sc, cc, *serviceUUID, *characteristicUUID, onTermination);
+            }
+            if (launchError != BLE_ERROR_NONE) {
+                unregister();
+                error = launchError;
+            }
+            return launchError == BLE_ERROR_NONE;
+        });
+    }
+
+    ble_error_t await_resume(void) const {
+        return error;
+    }
+
+private:
+    /* Discovery is exclusive per connection, so the connection identifies the awaitable. */
+    static void onTermination(Gap::Handle_t connectionHandle) {
+        for (ServiceDiscoveryAwaitable *awaitable = waiting; awaitable != NULL; awaitable = awaitable->next) {
+            if (awaitable->connHandle == connectionHandle) {
+                awaitable->unregister();
+                awaitable->complete();
+                return;
+            }
+        }
+    }
+
+    void unregister(void) {
+        for (ServiceDiscoveryAwaitable **link = &waiting; *link != NULL; link = &(*link)->next) {
+            if (*link == this) {
+                *link = next;
+                return;
+            }
+        }
+    }
+
+private:
+    GattClient                                 &client;
+    Gap::Handle_t                               connHandle;
+    ServiceDiscovery::ServiceCallback_t         sc;
+    ServiceDiscovery::CharacteristicCallback_t  cc;
+    const UUID                                 *serviceUUID;
+    const UUID                                 *characteristicUUID;
+    const UUIDSet                              *serviceUUIDs;
+    const UUIDSet                              *characteristicUUIDs;
+    ble_error_t                                 error;
+    ServiceDiscoveryAwaitable                  *next;
+
+    inline static ServiceDiscoveryAwaitable    *waiting = NULL;
+};
+
+/**
+ * co_await GapConnectAwaitable(gap, address, type, ...) connects to a peer,
+ * as Gap::connect(), and resumes with the ConnectionCallbackParams_t of the
+ * new connection. Should connecting not start at all, it resumes with the
+ * error; should the attempt time out, with BLE_ERROR_UNSPECIFIED.
+ *
+ * @Note: the application's own connection and timeout callbacks are invoked
+ * as usual; the awaitable attaches to Gap's call chains.
+ */
+class GapConnectAwaitable : public BLEAwaitable {
+public:
+    struct Result_t {
+        ble_error_t                     status;
+        Gap::ConnectionCallbackParams_t params; /**< Valid only if status is BLE_ERROR_NONE. */
+    };
+
+public:
+    GapConnectAwaitable(Gap                          &_gap,
+                        const Gap::Address_t          _peerAddr,
+                        Gap::AddressType_t            peerAddrType,
+                        const Gap::ConnectionParams_t *_connectionParams = NULL,
+                        const GapScanningParams      *_scanParams       = NULL) :
+        gap(_gap), connectionParams(_connectionParams), scanParams(_scanParams),
+        result{BLE_ERROR_NONE, Gap::ConnectionCallbackParams_t(0, Gap::CENTRAL, peerAddrType, _peerAddr, peerAddrType, _peerAddr, NULL)},
+        next(NULL) {
+        /* empty */
+    }
+
+    bool await_suspend(std::coroutine_handle<> coroutine) {
+        return suspendWhile(coroutine, [this]() {
+            if (!attach(gap)) {
+                result.status = BLE_ERROR_NO_MEM;
+                return false;
+            }
+            next    = waiting;
+            waiting = this;
+            ble_error_t error = gap.connect(result.params.peerAddr, result.params.peerAddrType, connectionParams, scanParams);
+            if (error != BLE_ERROR_NONE) {
+                unregister();
+                result.status = error;
+            }
+            return error == BLE_ERROR_NONE;
+        });
+    }
+
+    Result_t await_resume(void) const {
+        return result;
+    }
+
+private:
+    static const unsigned MAX_GAPS = 4;
+
+    /* The handlers for one Gap, so that its events only complete the awaitables connecting through it. */
+    struct Attachment_t {
+        Gap *gap;
+
+        void onConnection(const Gap::ConnectionCallbackParams_t *params) {
+            if (params->role != Gap::CENTRAL) {
+                return;
+            }
+            for (GapConnectAwaitable *awaitable = waiting; awaitable != NULL; awaitable = awaitable->next) {
+                if ((&awaitable->gap == gap) &&
+                    (awaitable->result.params.peerAddrType == params->peerAddrType) &&
+                    (memcmp(awaitable->result.params.peerAddr, params->peerAddr, Gap::ADDR_LEN) == 0)) {
+                    awaitable->unregister();
+                    awaitable->result.params = *params;
+                    awaitable->complete();
+                    return;
+                }
+            }
+        }
+
+        /* The controller makes one connection attempt at a time, so a timeout concerns every awaitable waiting on it. */
+        void onTimeout(Gap::TimeoutSource_t source) {
+            if (source != Gap::TIMEOUT_SRC_CONN) {
+                return;
+            }
+            GapConnectAwaitable *awaitable = waiting;
+            while (awaitable != NULL) {
+                GapConnectAwaitable *following = awaitable->next;
+                if (&awaitable->gap == gap) {
+                    awaitable->unregister();
+                    awaitable->result.status = BLE_ERROR_UNSPECIFIED;
+                    awaitable->complete();
+                }
+                awaitable = following;
+            }
+        }
+    };
+
+    /* The call chains can't be detached from, so each Gap gets the handlers once. */
+    static bool attach(Gap &gap) {
+        for (unsigned i = 0; i < MAX_GAPS; i++) {
+            if (attachments[i].gap == &gap) {
+                return true;
+            }
+            if (attachments[i].gap == NULL) {
+                attachments[i].gap = &gap;
+                gap.addToConnectionCallChain(&attachments[i], &Attachment_t::onConnection);
+                gap.addToTimeoutCallChain(&attachments[i], &Attachment_t::onTimeout);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unregister(void) {
+        for (GapConnectAwaitable **link = &waiting; *link != NULL; link = &(*link)->next) {
+            if (*link == this) {
+                *link = next;
+                return;
+            }
+        }
+    }
+
+private:
+    Gap                           &gap;
+    const Gap::ConnectionParams_t *connectionParams;
+    const GapScanningParams       *scanParams;
+    Result_t                       result;
+    GapConnectAwaitable           *next;
+
+    inline static GapConnectAwaitable *waiting = NULL;
+    inline static Attachment_t         attachments[MAX_GAPS] = {};
+};
+
+#endif // if defined(__cpp_impl_coroutine) && (__cplusplus >= 202002L)
+
+#endif // ifndef __BLE_COROUTINE_H__
@@ -110,6 +110,27 @@ public:
         chainHead = NULL;
     }
 
+    /** Remove a function from the chain, and delete it
+     *
+     *  @param pf The function object, as returned by add()
+     *
+     *  @Note: not to be used from within call() on the same chain.
+     */
+    void remove(pFunctionPointerWithContext_t pf) {
+        pFunctionPointerWithContext_t previous = NULL;
+        for (pFunctionPointerWithContext_t fptr = chainHead; fptr != NULL; previous = fptr, fptr = fptr->getNext()) {
+            if (fptr == pf) {
+                if (previous != NULL) {
+                    previous->chainAsNext(fptr->getNext());
+                } else {
+                    chainHead = fptr->getNext();
+                }
+                delete fptr;
+                return;
+            }
+        }
+    }
+
     bool hasCallbacksAttached(void) const {
         return (chainHead != NULL);
     }
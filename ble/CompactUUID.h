@@ -0,0 +1,110 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __COMPACT_UUID_H__
+#define __COMPACT_UUID_H__
+
+#include "UUID.h"
+
+#ifndef BLE_UUID_MAX_BASES
+#define BLE_UUID_MAX_BASES 8 /**< Distinct vendor base UUIDs interned, shared by all local attributes. */
+#endif
+
+#if BLE_UUID_MAX_BASES > 0x3FFE
+#error "base UUID indices are 14 bits wide"
+#endif
+
+/**
+ * A UUID in 4 bytes, for storage in the attributes of local services.
+ *
+ * A UUID is split into a base, which is its 128-bit form with bytes 2-3
+ * zeroed, and the 16-bit value of bytes 2-3. Bases are interned in a table
+ * shared by the whole application: the Bluetooth Base UUID is always
+ * present, and each vendor base takes an entry the first time it is seen,
+ * so that the characteristics of a vendor service (which conventionally
+ * differ in bytes 2-3 only) share one. A 32-bit UUID has its upper half in
+ * the base; unless it is zero, that takes an entry as well.
+ *
+ * Bases are never released. Once the table is full, a UUID with a new base
+ * is held as invalid, and reads back as BLE_UUID_UNKNOWN; isValid() tells,
+ * and GattAttributeDatabase::addService() refuses such attributes. Discovery
+ * records hold full UUIDs, as the UUIDs of peers aren't bounded.
+ */
+class CompactUUID {
+public:
+    static const unsigned MAX_BASES = BLE_UUID_MAX_BASES;
+
+public:
+    CompactUUID(void) : base(WIDTH_16 << WIDTH_SHIFT), value(BLE_UUID_UNKNOWN) {
+        /* empty */
+    }
+
+    /**
+     * Intern the base of a UUID.
+     */
+    CompactUUID(const UUID &uuid);
+
+    /**
+     * The UUID in full, with the width it was created with.
+     */
+    UUID getUUID(void) const;
+
+    bool isValid(void) const {
+        return (base & INDEX_MASK) != INVALID_INDEX;
+    }
+
+    /**
+     * Equal UUIDs have equal bases and values, whatever their widths, as
+     * for UUID::operator==().
+     */
+    bool operator== (const CompactUUID &other) const {
+        return (((base ^ other.base) & INDEX_MASK) | (value ^ other.value)) == 0;
+    }
+
+    bool operator!= (const CompactUUID &other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * The number of vendor base UUIDs interned so far.
+     */
+    static unsigned getBaseCount(void) {
+        return baseCount;
+    }
+
+private:
+    enum {
+        WIDTH_16  = 0,
+        WIDTH_32  = 1,
+        WIDTH_128 = 2
+    };
+
+    static const unsigned WIDTH_SHIFT   = 14;
+    static const uint16_t INDEX_MASK    = 0x3FFF;
+    static const uint16_t INVALID_INDEX = 0x3FFF;
+    static const uint16_t BLUETOOTH_BASE_INDEX = 0; /* entries of the table are numbered from 1 */
+
+    static uint16_t internBase(const uint8_t *longUUID);
+
+private:
+    uint16_t base;  /* width of the UUID in the top two bits, index of the base below */
+    uint16_t value; /* bytes 2-3 of the 128-bit form */
+
+    static UUID::LongUUIDBytes_t bases[MAX_BASES]; /* bytes 2-3 zeroed */
+    static uint16_t              baseCount;
+};
+
+#endif // ifndef __COMPACT_UUID_H__
@@ -21,6 +21,7 @@
 #include "Gap.h"
 #include "GattAttribute.h"
 #include "GattClient.h"
+#include "DiscoveredDescriptor.h"
 
 /**
  * Structure for holding information about the service and the characteristics
@@ -51,24 +52,13 @@ public:
         operator unsigned() const; /* disallow implicit conversion into an integer */
     };
 
-    /**
-     * Structure for holding information about the service and the characteristics
-     * found during the discovery process.
-     */
-    struct DiscoveredDescriptor {
-        GattAttribute::Handle_t handle; /**< Descriptor Handle. */
-        UUID                    uuid;   /**< Descriptor UUID. */
-    };
+    typedef ::DiscoveredDescriptor DiscoveredDescriptor;
 
     /**
      * Callback type for when a characteristic descriptor is found during descriptor-
-     * discovery. The receiving function is passed in a pointer to a
-     * DiscoveredDescriptor object which will remain valid for the lifetime
-     * of the callback. Memory for this object is owned by the BLE_API eventing
-     * framework. The application can safely make a persistent shallow-copy of
-     * this object in order to work with the characteristic beyond the callback.
+     * discovery; see ServiceDiscovery::DescriptorCallback_t.
      */
-    typedef void (*DescriptorCallback_t)(const DiscoveredDescriptor *);
+    typedef ServiceDiscovery::DescriptorCallback_t DescriptorCallback_t;
 
     /**
      * Initiate (or continue) a read for the value attribute, optionally at a
@@ -111,10 +101,15 @@ public:
      * @param  callback
      * @param  matchingUUID
      *           filter for descriptors. Defaults to wildcard which will discover all descriptors.
+     * @param  tc
+     *           Invoked when the discovery terminates, as for
+     *           GattClient::launchServiceDiscovery(). Taken as NULL by default.
      *
      * @return  BLE_ERROR_NONE if descriptor discovery is launched successfully; else an appropriate error.
      */
-    ble_error_t discoverDescriptors(DescriptorCallback_t callback, const UUID &matchingUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) const;
+    ble_error_t discoverDescriptors(DescriptorCallback_t                     callback,
+                                    const UUID                              &matchingUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                    ServiceDiscovery::TerminationCallback_t  tc           = NULL) const;
 
     /**
      * Perform a write procedure.
@@ -155,6 +150,10 @@ public:
         return valueHandle;
     }
 
+    Gap::Handle_t getConnectionHandle(void) const {
+        return connHandle;
+    }
+
 public:
     DiscoveredCharacteristic() : gattc(NULL),
                                  uuid(UUID::ShortUUIDBytes_t(0)),
@@ -0,0 +1,35 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DISCOVERED_DESCRIPTOR_H__
+#define __DISCOVERED_DESCRIPTOR_H__
+
+#include "UUID.h"
+#include "Gap.h"
+#include "GattAttribute.h"
+
+/**
+ * Structure for holding information about a characteristic descriptor
+ * found during the discovery process.
+ */
+struct DiscoveredDescriptor {
+    GattAttribute::Handle_t handle;      /**< Descriptor Handle. */
+    UUID                    uuid;        /**< Descriptor UUID. */
+    Gap::Handle_t           connHandle;  /**< The connection on which it was found. */
+    GattAttribute::Handle_t valueHandle; /**< Value handle of the characteristic it belongs to. */
+};
+
+#endif /*__DISCOVERED_DESCRIPTOR_H__*/
@@ -23,9 +23,14 @@
 #include "GapEvents.h"
 #include "CallChain.h"
 #include "FunctionPointerWithContext.h"
+#include "CallChainOfFunctionPointersWithContext.h"
 
 using namespace mbed;
 
+#ifndef BLE_GAP_MAX_CONNECTIONS
+#define BLE_GAP_MAX_CONNECTIONS 4 /**< Number of simultaneous connections for which per-connection state is kept. */
+#endif
+
 /* Forward declarations for classes which will only be used for pointers or references in the following. */
 class GapAdvertisingParams;
 class GapScanningParams;
@@ -126,6 +131,28 @@ public:
         }
     };
 
+    struct DisconnectionCallbackParams_t {
+        Handle_t              handle;
+        DisconnectionReason_t reason;
+
+        DisconnectionCallbackParams_t(Handle_t handleIn, DisconnectionReason_t reasonIn) :
+            handle(handleIn),
+            reason(reasonIn) {
+            /* empty */
+        }
+    };
+
+    struct AttMtuChangeCallbackParams_t {
+        Handle_t handle;
+        uint16_t attMtu; /**< The ATT MTU now in effect on the connection. */
+
+        AttMtuChangeCallbackParams_t(Handle_t handleIn, uint16_t attMtuIn) :
+            handle(handleIn),
+            attMtu(attMtuIn) {
+            /* empty */
+        }
+    };
+
     static const uint16_t UNIT_1_25_MS  = 1250; /**< Number of microseconds in 1.25 milliseconds. */
     static uint16_t MSEC_TO_GAP_DURATION_UNITS(uint32_t durationInMillis) {
         return (durationInMillis * 1000) / UNIT_1_25_MS;
@@ -136,6 +163,10 @@ public:
     typedef void (*ConnectionEventCallback_t)(const ConnectionCallbackParams_t *params);
     typedef void (*DisconnectionEventCallback_t)(Handle_t, DisconnectionReason_t);
     typedef FunctionPointerWithContext<bool> RadioNotificationEventCallback_t;
+    typedef CallChainOfFunctionPointersWithContext<const ConnectionCallbackParams_t *>    ConnectionEventCallChain_t;
+    typedef CallChainOfFunctionPointersWithContext<const DisconnectionCallbackParams_t *> DisconnectionEventCallChain_t;
+    typedef CallChainOfFunctionPointersWithContext<const AttMtuChangeCallbackParams_t *>  AttMtuChangeEventCallChain_t;
+    typedef CallChainOfFunctionPointersWithContext<TimeoutSource_t>                       TimeoutEventCallChain_t;
 
     /*
      * The following functions are meant to be overridden in the platform-specific sub-class.
@@ -426,6 +457,64 @@ public:
         return state;
     }
 
+    /**
+     * The ATT MTU in effect on a connection. This starts out at
+     * BLE_GATT_MTU_SIZE_DEFAULT and changes once an MTU exchange completes;
+     * see GattClient::exchangeMtu() and onAttMtuChange().
+     *
+     * @return the ATT MTU, or BLE_GATT_MTU_SIZE_DEFAULT for unknown connections.
+     */
+    uint16_t getAttMtu(Handle_t connectionHandle) const {
+        const ConnectionState_t *connection = findConnection(connectionHandle);
+        return (connection != NULL) ? connection->attMtu : BLE_GATT_MTU_SIZE_DEFAULT;
+    }
+
+    /**
+     * The address of the peer on a connection, as reported when it was
+     * established.
+     *
+     * @return BLE_ERROR_INVALID_PARAM for unknown connections.
+     */
+    ble_error_t getPeerAddress(Handle_t connectionHandle, AddressType_t *typeP, Address_t address) const {
+        const ConnectionState_t *connection = findConnection(connectionHandle);
+        if (connection == NULL) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+
+        *typeP = connection->peerAddrType;
+        memcpy(address, connection->peerAddr, ADDR_LEN);
+        return BLE_ERROR_NONE;
+    }
+
+    /**
+     * The largest attribute value which fits into a single notification,
+     * indication or write on a connection; i.e. the ATT MTU less the
+     * three byte ATT header.
+     */
+    uint16_t getMaxPayload(Handle_t connectionHandle) const {
+        return getAttMtu(connectionHandle) - 3;
+    }
+
+    /**
+     * The largest attribute value which fits into a single notification or
+     * indication on every current connection. This is the size to use for
+     * updates which go out to all subscribed peers.
+     */
+    uint16_t getMaxPayload(void) const {
+        uint16_t attMtu = BLE_GATT_MTU_SIZE_MAX;
+        bool     any    = false;
+        for (unsigned i = 0; i < BLE_GAP_MAX_CONNECTIONS; i++) {
+            if (connections[i].inUse) {
+                any = true;
+                if (connections[i].attMtu < attMtu) {
+                    attMtu = connections[i].attMtu;
+                }
+            }
+        }
+
+        return (any ? attMtu : BLE_GATT_MTU_SIZE_DEFAULT) - 3;
+    }
+
     /**
      * Set the GAP advertising mode to use for this device.
      */
@@ -888,11 +977,28 @@ public:
      */
     void onTimeout(TimeoutEventCallback_t callback) {timeoutCallback = callback;}
 
+    /**
+     * Append to a chain of callbacks to be invoked upon timeout events, after
+     * the one set with onTimeout().
+     */
+    void addToTimeoutCallChain(void (*callback)(TimeoutSource_t)) {timeoutCallChain.add(callback);}
+    template<typename T>
+    void addToTimeoutCallChain(T *tptr, void (T::*mptr)(TimeoutSource_t)) {timeoutCallChain.add(tptr, mptr);}
+
     /**
      * Setup a callback for connection events. Refer to ConnectionEventCallback_t.
      */
     void onConnection(ConnectionEventCallback_t callback) {connectionCallback = callback;}
 
+    /**
+     * Append to a chain of callbacks to be invoked upon connection, after the
+     * one set with onConnection(). This lets services keep per-peer state
+     * without taking the application's callback.
+     */
+    void addToConnectionCallChain(void (*callback)(const ConnectionCallbackParams_t *)) {connectionCallChain.add(callback);}
+    template<typename T>
+    void addToConnectionCallChain(T *tptr, void (T::*mptr)(const ConnectionCallbackParams_t *)) {connectionCallChain.add(tptr, mptr);}
+
     /**
      * Set the application callback for disconnection events.
      * @param callback
@@ -910,6 +1016,41 @@ public:
     template<typename T>
     void addToDisconnectionCallChain(T *tptr, void (T::*mptr)(void)) {disconnectionCallChain.add(tptr, mptr);}
 
+    /**
+     * Append to a chain of callbacks to be invoked upon disconnection; unlike
+     * the above, these callbacks receive the handle of the terminated
+     * connection and the reason for the disconnection. This allows modules
+     * holding per-connection state to release it.
+     *
+     * @return The callback as held in the chain, for
+     *         removeFromDisconnectionCallChain().
+     */
+    DisconnectionEventCallChain_t::pFunctionPointerWithContext_t addToDisconnectionCallChain(void (*callback)(const DisconnectionCallbackParams_t *)) {
+        return disconnectionCallChainWithParams.add(callback);
+    }
+    template<typename T>
+    DisconnectionEventCallChain_t::pFunctionPointerWithContext_t addToDisconnectionCallChain(T *tptr, void (T::*mptr)(const DisconnectionCallbackParams_t *)) {
+        return disconnectionCallChainWithParams.add(tptr, mptr);
+    }
+
+    /**
+     * Remove a callback added by the above, for modules which don't outlive
+     * the Gap; not to be called from within a disconnection callback.
+     */
+    void removeFromDisconnectionCallChain(DisconnectionEventCallChain_t::pFunctionPointerWithContext_t callback) {
+        disconnectionCallChainWithParams.remove(callback);
+    }
+
+    /**
+     * Append to a chain of callbacks to be invoked when the ATT MTU of a
+     * connection changes, typically after an MTU exchange initiated by either
+     * side. Services which size their transfers from getMaxPayload() may use
+     * this to adapt.
+     */
+    void onAttMtuChange(void (*callback)(const AttMtuChangeCallbackParams_t *)) {attMtuChangeCallChain.add(callback);}
+    template<typename T>
+    void onAttMtuChange(T *tptr, void (T::*mptr)(const AttMtuChangeCallbackParams_t *)) {attMtuChangeCallChain.add(tptr, mptr);}
+
     /**
      * Set the application callback for radio-notification events.
      *
@@ -960,7 +1101,12 @@ protected:
         disconnectionCallback(NULL),
         radioNotificationCallback(),
         onAdvertisementReport(),
-        disconnectionCallChain() {
+        connectionCallChain(),
+        disconnectionCallChain(),
+        disconnectionCallChainWithParams(),
+        attMtuChangeCallChain(),
+        timeoutCallChain(),
+        connections() {
         _advPayload.clear();
         _scanResponse.clear();
     }
@@ -975,9 +1121,22 @@ public:
                                 const Address_t           ownAddr,
                                 const ConnectionParams_t *connectionParams) {
         state.connected = 1;
-        if (connectionCallback) {
+        for (unsigned i = 0; i < BLE_GAP_MAX_CONNECTIONS; i++) {
+            if (!connections[i].inUse) {
+                connections[i].inUse        = true;
+                connections[i].handle       = handle;
+                connections[i].attMtu       = BLE_GATT_MTU_SIZE_DEFAULT;
+                connections[i].peerAddrType = peerAddrType;
+                memcpy(connections[i].peerAddr, peerAddr, ADDR_LEN);
+                break;
+            }
+        }
+        if (connectionCallback || connectionCallChain.hasCallbacksAttached()) {
             ConnectionCallbackParams_t callbackParams(handle, role, peerAddrType, peerAddr, ownAddrType, ownAddr, connectionParams);
-            connectionCallback(&callbackParams);
+            if (connectionCallback) {
+                connectionCallback(&callbackParams);
+            }
+            connectionCallChain.call(&callbackParams);
         }
     }
 
@@ -987,6 +1146,38 @@ public:
             disconnectionCallback(handle, reason);
         }
         disconnectionCallChain.call();
+        if (disconnectionCallChainWithParams.hasCallbacksAttached()) {
+            DisconnectionCallbackParams_t callbackParams(handle, reason);
+            disconnectionCallChainWithParams.call(&callbackParams);
+        }
+
+        ConnectionState_t *connection = findConnection(handle);
+        if (connection != NULL) {
+            connection->inUse = false;
+        }
+    }
+
+    /**
+     * Report the ATT MTU negotiated on a connection. Values beyond
+     * BLE_GATT_MTU_SIZE_MAX are capped, as local buffers aren't sized for them.
+     */
+    void processAttMtuChangeEvent(Handle_t handle, uint16_t attMtu) {
+        if (attMtu > BLE_GATT_MTU_SIZE_MAX) {
+            attMtu = BLE_GATT_MTU_SIZE_MAX;
+        }
+        if (attMtu < BLE_GATT_MTU_SIZE_DEFAULT) {
+            attMtu = BLE_GATT_MTU_SIZE_DEFAULT;
+        }
+
+        ConnectionState_t *connection = findConnection(handle);
+        if (connection != NULL) {
+            connection->attMtu = attMtu;
+        }
+
+        if (attMtuChangeCallChain.hasCallbacksAttached()) {
+            AttMtuChangeCallbackParams_t callbackParams(handle, attMtu);
+            attMtuChangeCallChain.call(&callbackParams);
+        }
     }
 
     void processAdvertisementReport(const Address_t    peerAddr,
@@ -1009,6 +1200,7 @@ public:
         if (timeoutCallback) {
             timeoutCallback(source);
         }
+        timeoutCallChain.call(source);
     }
 
 protected:
@@ -1026,7 +1218,34 @@ protected:
     DisconnectionEventCallback_t     disconnectionCallback;
     RadioNotificationEventCallback_t radioNotificationCallback;
     AdvertisementReportCallback_t    onAdvertisementReport;
+    ConnectionEventCallChain_t       connectionCallChain;
     CallChain                        disconnectionCallChain;
+    DisconnectionEventCallChain_t    disconnectionCallChainWithParams;
+    AttMtuChangeEventCallChain_t     attMtuChangeCallChain;
+    TimeoutEventCallChain_t          timeoutCallChain;
+
+private:
+    struct ConnectionState_t {
+        Handle_t      handle;
+        uint16_t      attMtu;
+        AddressType_t peerAddrType;
+        Address_t     peerAddr;
+        bool          inUse;
+    };
+
+    ConnectionState_t *findConnection(Handle_t handle) {
+        for (unsigned i = 0; i < BLE_GAP_MAX_CONNECTIONS; i++) {
+            if (connections[i].inUse && (connections[i].handle == handle)) {
+                return &connections[i];
+            }
+        }
+        return NULL;
+    }
+    const ConnectionState_t *findConnection(Handle_t handle) const {
+        return const_cast<Gap *>(this)->findConnection(handle);
+    }
+
+    ConnectionState_t                connections[BLE_GAP_MAX_CONNECTIONS];
 
 private:
     /* disallow copy and assignment */
@@ -17,7 +17,7 @@
 #ifndef __GATT_ATTRIBUTE_H__
 #define __GATT_ATTRIBUTE_H__
 
-#include "UUID.h"
+#include "CompactUUID.h"
 
 class GattAttribute {
 public:
@@ -54,7 +54,12 @@ public:
 
 public:
     Handle_t    getHandle(void)        const {return _handle;    }
-    const UUID &getUUID(void)          const {return _uuid;      }
+    /**
+     * @Note: the UUID is held as a CompactUUID and rebuilt on each call, so
+     * it is returned by value; code which kept a reference or pointer to
+     * the UUID of an attribute should take a copy, or use getCompactUUID().
+     */
+    UUID        getUUID(void)          const {return _uuid.getUUID();}
     uint16_t    getLength(void)        const {return _len;       }
     uint16_t    getInitialLength(void) const {return _initialLen;}
     uint16_t    getMaxLength(void)     const {return _lenMax;    }
@@ -62,13 +67,19 @@ public:
     void        setHandle(Handle_t id)       {_handle = id;      }
     uint8_t    *getValuePtr(void)            {return _valuePtr;  }
 
+    /**
+     * The UUID as held: 4 bytes, with its base interned. Invalid if the
+     * table of base UUIDs was full.
+     */
+    const CompactUUID &getCompactUUID(void) const {return _uuid;}
+
 private:
-    UUID      _uuid;        /* Characteristic UUID */
-    uint8_t  *_valuePtr;
-    uint16_t  _initialLen;  /* Initial length of the value */
-    uint16_t  _lenMax;      /* Maximum length of the value */
-    uint16_t  _len;         /* Current length of the value */
-    Handle_t  _handle;
+    CompactUUID  _uuid;        /* Characteristic UUID */
+    uint8_t     *_valuePtr;
+    uint16_t     _initialLen;  /* Initial length of the value */
+    uint16_t     _lenMax;      /* Maximum length of the value */
+    uint16_t     _len;         /* Current length of the value */
+    Handle_t     _handle;
 
 private:
     /* disallow copy and assignment */
@@ -0,0 +1,222 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_ATTRIBUTE_CACHE_H__
+#define __GATT_ATTRIBUTE_CACHE_H__
+
+#include "Gap.h"
+#include "UUID.h"
+#include "GattAttribute.h"
+#include "GattClient.h"
+#include "ServiceDiscovery.h"
+#include "DiscoveredService.h"
+#include "DiscoveredCharacteristic.h"
+#include "GattCacheStorage.h"
+
+#ifndef BLE_GATT_CACHE_MAX_ENTRIES
+#define BLE_GATT_CACHE_MAX_ENTRIES    64   /**< Services, characteristics and descriptors in the table of one peer. */
+#endif
+#ifndef BLE_GATT_CACHE_MAX_RECORD_SIZE
+#define BLE_GATT_CACHE_MAX_RECORD_SIZE 1024 /**< Bytes taken by the stored table of one peer. */
+#endif
+
+class BLE;
+
+/**
+ * Client side cache of the attribute tables of peers, so that service
+ * discovery runs once per peer rather than once per connection.
+ *
+ * discover() takes the place of GattClient::launchServiceDiscovery(). The
+ * first time a peer is seen, it runs a complete discovery, passes matching
+ * results on to the application as usual and records all of them. The table
+ * is then kept in a GattCacheStorage, keyed by the peer's address. Later
+ * requests for the same peer are answered from the table, without a round
+ * trip, applying the same filters as GattClient.
+ *
+ * If the peer has a Database Hash characteristic, the stored table carries
+ * its value, and the cache reads it again before answering; a changed hash
+ * leads to a new discovery. Otherwise the table is trusted until it is
+ * dropped with invalidate(), which the application should call when the
+ * peer indicates Service Changed.
+ *
+ * Records are stored in a compact, versioned format:
+ *
+ *   header:         'G' 'C' version(1) flags(1) count(2) hash(16)
+ *   service:        0x01 startHandle(2) endHandle(2) uuidLength(1) uuid
+ *   characteristic: 0x02 declHandle(2) valueHandle(2) properties(1) uuidLength(1) uuid
+ *   descriptor:     0x03 handle(2) uuidLength(1) uuid
+ *
+ * with multi-byte fields little-endian, and UUIDs of 2 or 16 bytes as in ATT
+ * PDUs. Records of another version are ignored, and replaced when the peer
+ * is next discovered.
+ *
+ * @Note: the results of discovery don't identify their connection, so one
+ * discovery at a time is recorded across all caches, even where GattClient
+ * can run several; discover() fails with BLE_STACK_BUSY when it would have to
+ * record while another cache is recording.
+ */
+class GattAttributeCache {
+public:
+    static const unsigned MAX_ENTRIES     = BLE_GATT_CACHE_MAX_ENTRIES;
+    static const unsigned MAX_RECORD_SIZE = BLE_GATT_CACHE_MAX_RECORD_SIZE;
+    static const uint8_t  FORMAT_VERSION  = 1;
+    static const unsigned HASH_SIZE       = 16;
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     * @param[ref] storage
+     *               Where the tables are kept.
+     */
+    GattAttributeCache(BLE &ble, GattCacheStorage &storage);
+
+    /**
+     * Discover services and characteristics, from the cache when possible.
+     * The parameters are those of GattClient::launchServiceDiscovery(). When
+     * answered from the cache, all callbacks may be invoked before this
+     * returns.
+     *
+     * @return BLE_STACK_BUSY if a discovery is in progress, or one has to
+     *         be recorded while another cache is recording; otherwise as
+     *         GattClient::launchServiceDiscovery().
+     */
+    ble_error_t discover(Gap::Handle_t                               connectionHandle,
+                         ServiceDiscovery::ServiceCallback_t         sc                           = NULL,
+                         ServiceDiscovery::CharacteristicCallback_t  cc                           = NULL,
+                         const UUID                                 &matchingServiceUUID          = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                         const UUID                                 &matchingCharacteristicUUID   = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                         ServiceDiscovery::TerminationCallback_t     tc                           = NULL);
+
+    bool isActive(void) const {return state != STATE_IDLE;}
+
+    /**
+     * Stop a discovery in progress; the table being recorded is dropped.
+     */
+    void terminate(void);
+
+    /**
+     * Forget the table of a connected peer, e.g. after it indicates Service
+     * Changed; the next discover() runs a complete discovery.
+     */
+    ble_error_t invalidate(Gap::Handle_t connectionHandle);
+
+    /**
+     * Record a descriptor found through descriptor discovery in the table of
+     * a peer whose services have been discovered.
+     *
+     * @return BLE_ERROR_INVALID_STATE if there is no table for the peer, or
+     *         BLE_ERROR_NO_MEM if the table is full.
+     */
+    ble_error_t addDescriptor(Gap::Handle_t connectionHandle, GattAttribute::Handle_t handle, const UUID &uuid);
+
+    /**
+     * Look up a descriptor of a characteristic in the table of a peer, such as
+     * its Client Characteristic Configuration Descriptor.
+     *
+     * @return the handle of the descriptor; GattAttribute::INVALID_HANDLE if
+     *         it isn't in the table.
+     */
+    GattAttribute::Handle_t findDescriptor(Gap::Handle_t connectionHandle, GattAttribute::Handle_t valueHandle, const UUID &uuid);
+
+    /* Discoveries answered from the cache, and those which went to the peer. */
+    uint32_t getHits(void)   const {return hits;  }
+    uint32_t getMisses(void) const {return misses;}
+
+protected:
+    static void onService(const DiscoveredService *service);
+    static void onCharacteristic(const DiscoveredCharacteristic *characteristic);
+    static void onTermination(Gap::Handle_t connectionHandle);
+    static void onHashRead(const GattClient::RequestResult_t *result);
+
+    void onDisconnection(const Gap::DisconnectionCallbackParams_t *params);
+
+private:
+    enum State_t {
+        STATE_IDLE,
+        STATE_VALIDATING, /* reading the peer's Database Hash before using the stored table */
+        STATE_REPLAYING,  /* answering from the stored table */
+        STATE_RECORDING,  /* running discovery */
+        STATE_HASHING     /* reading the peer's Database Hash before storing the new table */
+    };
+
+    enum EntryKind_t {
+        ENTRY_SERVICE        = 0x01,
+        ENTRY_CHARACTERISTIC = 0x02,
+        ENTRY_DESCRIPTOR     = 0x03
+    };
+
+    struct Entry_t {
+        uint8_t                 kind;       /* EntryKind_t */
+        uint8_t                 properties; /* of characteristics, as in their declaration */
+        GattAttribute::Handle_t handle;     /* start, declaration or descriptor handle */
+        GattAttribute::Handle_t endHandle;  /* end of a service, or value handle of a characteristic */
+        UUID                    uuid;
+    };
+
+    /* DiscoveredCharacteristic keeps its fields to itself; this fills them in. */
+    class CachedCharacteristic : public DiscoveredCharacteristic {
+    public:
+        void setup(GattClient *gattcIn, Gap::Handle_t connHandleIn, const Entry_t &entry);
+    };
+
+    ble_error_t loadTable(Gap::Handle_t connectionHandle);
+    ble_error_t storeTable(void);
+    bool        parse(const uint8_t *record, uint16_t length);
+    uint16_t    serialize(uint8_t *record) const;
+    Entry_t    *appendEntry(EntryKind_t kind, GattAttribute::Handle_t handle, GattAttribute::Handle_t endHandle, const UUID &uuid);
+    GattAttribute::Handle_t findDatabaseHash(void) const;
+
+    ble_error_t record(void);
+    void        replay(void);
+    void        finish(void);
+
+private:
+    static GattAttributeCache                  *discovering; /* the cache whose discovery is in progress */
+
+    BLE                                        &ble;
+    GattCacheStorage                           &storage;
+
+    uint8_t                                     state;       /* State_t */
+    bool                                        aborted;     /* the discovery being recorded was cut short */
+    Gap::Handle_t                               connHandle;
+    ServiceDiscovery::ServiceCallback_t         serviceCallback;
+    ServiceDiscovery::CharacteristicCallback_t  characteristicCallback;
+    ServiceDiscovery::TerminationCallback_t     terminationCallback;
+    UUID                                        matchingServiceUUID;
+    UUID                                        matchingCharacteristicUUID;
+    bool                                        serviceMatched; /* the last service recorded passed the filter */
+
+    /* the table of one peer, as loaded from storage or being recorded */
+    bool                                        tableLoaded;
+    GattCacheStorage::Key_t                     tableKey;
+    bool                                        hasHash;
+    uint8_t                                     hash[HASH_SIZE];
+    uint16_t                                    entryCount;
+    bool                                        overflow;
+    Entry_t                                     entries[MAX_ENTRIES];
+    uint8_t                                     recordBuffer[MAX_RECORD_SIZE];
+
+    uint32_t                                    hits;
+    uint32_t                                    misses;
+
+private:
+    /* disallow copy and assignment */
+    GattAttributeCache(const GattAttributeCache &);
+    GattAttributeCache& operator=(const GattAttributeCache &);
+};
+
+#endif // ifndef __GATT_ATTRIBUTE_CACHE_H__
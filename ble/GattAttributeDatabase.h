@@ -0,0 +1,302 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_ATTRIBUTE_DATABASE_H__
+#define __GATT_ATTRIBUTE_DATABASE_H__
+
+#include "blecommon.h"
+#include "UUID.h"
+#include "GattAttribute.h"
+#include "GattCharacteristic.h"
+#include "GattService.h"
+#include "GattServiceDefinition.h"
+#include "AesCmac.h"
+
+/* The following limits may be overridden from the build configuration. */
+#ifndef BLE_GATT_DATABASE_MAX_ATTRIBUTES
+#define BLE_GATT_DATABASE_MAX_ATTRIBUTES 64   /**< Total number of attributes (declarations, values and descriptors). At most 255. */
+#endif
+#ifndef BLE_GATT_DATABASE_MAX_UUIDS
+#define BLE_GATT_DATABASE_MAX_UUIDS      32   /**< Number of distinct attribute types (UUIDs). At most 255. */
+#endif
+#ifndef BLE_GATT_DATABASE_MAX_SERVICES
+#define BLE_GATT_DATABASE_MAX_SERVICES   12
+#endif
+#ifndef BLE_GATT_DATABASE_VALUE_ARENA_SIZE
+#define BLE_GATT_DATABASE_VALUE_ARENA_SIZE 512 /**< Bytes reserved for attribute values. */
+#endif
+
+/**
+ * A flat, structure-of-arrays representation of a local GATT table.
+ *
+ * addService() lays the declarations, values and descriptors of a GattService
+ * out in handle order. Handles are allocated contiguously starting from
+ * getFirstHandle(), so an attribute's handle is also its index into the
+ * tables; handle based accesses are O(1). Each attribute costs a one byte
+ * index into a table of distinct UUIDs rather than a full UUID object, plus
+ * its value pointer, lengths and properties. Lookups by attribute type use a
+ * binary search over a sorted copy of the UUID table followed by a binary
+ * search over attributes sorted by type. UUIDs are told apart by their
+ * 128-bit form, so a type matches whatever width it was declared with; the
+ * table keeps the width of the first declaration.
+ *
+ * Values are copied into an internal arena when a service is added, in line
+ * with the semantics documented for GattCharacteristic; the application
+ * memory passed in as valuePtr need not remain valid afterwards.
+ *
+ * This is meant to be used by ports (and software ATT layers) as the backing
+ * store for GattServer::addService(), read() and write().
+ */
+class GattAttributeDatabase {
+public:
+    static const unsigned MAX_ATTRIBUTES   = BLE_GATT_DATABASE_MAX_ATTRIBUTES;
+    static const unsigned MAX_UUIDS        = BLE_GATT_DATABASE_MAX_UUIDS;
+    static const unsigned MAX_SERVICES     = BLE_GATT_DATABASE_MAX_SERVICES;
+    static const unsigned VALUE_ARENA_SIZE = BLE_GATT_DATABASE_VALUE_ARENA_SIZE;
+
+    typedef uint8_t UUIDIndex_t;
+    typedef uint8_t AttributeIndex_t;
+
+    static const UUIDIndex_t INVALID_UUID_INDEX = 0xFF;
+
+public:
+    /**
+     * @param[in] firstHandle
+     *              The handle to be assigned to the first attribute added.
+     */
+    GattAttributeDatabase(GattAttribute::Handle_t firstHandle = 1);
+
+    /**
+     * Append a service declaration, its characteristics and their descriptors
+     * to the database. Handles are assigned to the service, to each
+     * characteristic's value attribute and to each descriptor. A Client
+     * Characteristic Configuration Descriptor is added implicitly to
+     * characteristics which permit notifications or indications and don't
+     * declare one explicitly.
+     *
+     * @return BLE_ERROR_NONE on success; BLE_ERROR_NO_MEM if the attribute,
+     *         UUID, service or value tables cannot accommodate the service, or
+     *         an attribute's UUID didn't fit the table of base UUIDs (see
+     *         CompactUUID), in which case the database is left unchanged
+     *         and the service's attributes are left with INVALID_HANDLE.
+     */
+    ble_error_t addService(GattService &service);
+
+    /**
+     * Append a service described by a constant table, laid out as for a
+     * GattService. Values with a maxLength of 0 are not copied: the
+     * definition's initialValue is served as a constant and can't be
+     * written.
+     *
+     * @param[in]  definition
+     *               The service; it isn't referred to after the call, but
+     *               constant values are.
+     * @param[out] valueHandles
+     *               Receives the value handle of each characteristic, in the
+     *               order of the definition; may be NULL. On failure,
+     *               every entry is set to INVALID_HANDLE.
+     *
+     * @return as for the variant above.
+     */
+    ble_error_t addService(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles);
+
+    /**
+     * The Database Hash (Core Specification Vol 3, Part G, Section 7.3): an
+     * AES-CMAC over the declarations and the layout of the database. It is
+     * extended as each service is added, so this costs a single block
+     * encryption.
+     *
+     * @param[out] hash
+     *               The 128-bit hash in over-the-air (little-endian) order,
+     *               as the value of the Database Hash characteristic.
+     */
+    void getHash(uint8_t hash[AesCmac::BLOCK_SIZE]) const;
+
+    /**
+     * Remove all services and reset the handle allocation.
+     */
+    void reset(void);
+
+public:
+    GattAttribute::Handle_t getFirstHandle(void)    const {return firstHandle;                                    }
+    GattAttribute::Handle_t getLastHandle(void)     const {return firstHandle + attributeCount - 1;               }
+    unsigned                getAttributeCount(void) const {return attributeCount;                                 }
+    unsigned                getServiceCount(void)   const {return serviceCount;                                   }
+    unsigned                getUUIDCount(void)      const {return uuidCount;                                      }
+    bool                    isValidHandle(GattAttribute::Handle_t handle) const {
+        return (handle >= firstHandle) && ((unsigned)(handle - firstHandle) < attributeCount);
+    }
+
+    /**
+     * Accessors for a single attribute. The handle must be valid.
+     */
+    const UUID &getType(GattAttribute::Handle_t handle)      const {return uuids[types[indexOf(handle)]];}
+    UUIDIndex_t getTypeIndex(GattAttribute::Handle_t handle) const {return types[indexOf(handle)];       }
+    uint8_t    *getValuePtr(GattAttribute::Handle_t handle)        {return values[indexOf(handle)];      }
+    uint16_t    getLength(GattAttribute::Handle_t handle)    const {return lengths[indexOf(handle)];     }
+    uint16_t    getMaxLength(GattAttribute::Handle_t handle) const {return maxLengths[indexOf(handle)];  }
+    uint8_t     getProperties(GattAttribute::Handle_t handle) const {return properties[indexOf(handle)];}
+    const UUID &getUUIDAt(UUIDIndex_t index)                 const {return uuids[index];                 }
+
+    /**
+     * Read an attribute's value. Declarations (primary service and
+     * characteristic declarations) are synthesized in their over-the-air
+     * format; values and descriptors are copied out of the value arena.
+     *
+     * @param[in]     handle
+     *                  The attribute handle.
+     * @param[out]    buffer
+     *                  Destination for the value.
+     * @param[in/out] lengthP
+     *                  Size of the buffer on input; length of the value on
+     *                  return. If the buffer is too small the value is
+     *                  truncated and *lengthP holds the full length.
+     */
+    ble_error_t read(GattAttribute::Handle_t handle, uint8_t *buffer, uint16_t *lengthP) const {
+        return read(handle, 0, buffer, lengthP);
+    }
+
+    /**
+     * Read part of an attribute's value, starting at an offset; this serves
+     * ATT Read Blob Requests for long values.
+     *
+     * @param[in]     handle
+     *                  The attribute handle.
+     * @param[in]     offset
+     *                  Offset of the first byte to be read.
+     * @param[out]    buffer
+     *                  Destination for the value.
+     * @param[in/out] lengthP
+     *                  Size of the buffer on input; on return, the number of
+     *                  bytes in the value from the offset onwards. If the
+     *                  buffer is too small, only the first *lengthP bytes
+     *                  (as passed in) are copied.
+     *
+     * @return BLE_ERROR_PARAM_OUT_OF_RANGE if the offset is beyond the end of
+     *         the value (ATT error Invalid Offset).
+     */
+    ble_error_t read(GattAttribute::Handle_t handle, uint16_t offset, uint8_t *buffer, uint16_t *lengthP) const;
+
+    /**
+     * Update the value of a value or descriptor attribute.
+     *
+     * @return BLE_ERROR_INVALID_PARAM for unknown handles and declarations;
+     *         BLE_ERROR_OPERATION_NOT_PERMITTED for constants;
+     *         BLE_ERROR_BUFFER_OVERFLOW if the value exceeds the attribute's
+     *         maximum length.
+     */
+    ble_error_t write(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t length);
+
+    /**
+     * Find the first attribute of a given type within a handle range.
+     *
+     * @return the matching handle, or GattAttribute::INVALID_HANDLE.
+     */
+    GattAttribute::Handle_t findAttribute(const UUID              &type,
+                                          GattAttribute::Handle_t  startHandle = 0x0001,
+                                          GattAttribute::Handle_t  endHandle   = 0xFFFF) const;
+
+    /**
+     * Find the value handle of the first characteristic with the given UUID
+     * within a handle range.
+     */
+    GattAttribute::Handle_t findCharacteristicValue(const UUID              &uuid,
+                                                    GattAttribute::Handle_t  startHandle = 0x0001,
+                                                    GattAttribute::Handle_t  endHandle   = 0xFFFF) const {
+        return findAttribute(uuid, startHandle, endHandle);
+    }
+
+    /**
+     * Look up the handle range of the service enclosing an attribute.
+     *
+     * @return BLE_ERROR_INVALID_PARAM if the handle is unknown.
+     */
+    ble_error_t getServiceRange(GattAttribute::Handle_t  handle,
+                                GattAttribute::Handle_t *startHandleP,
+                                GattAttribute::Handle_t *endHandleP) const;
+
+    /**
+     * Index of a UUID in the table of attribute types; INVALID_UUID_INDEX if
+     * no attribute with this type has been added.
+     */
+    UUIDIndex_t lookupUUID(const UUID &uuid) const;
+
+    /**
+     * Encode a UUID in its over-the-air (little-endian) form.
+     *
+     * @return the number of bytes written: 2 or 16.
+     */
+    static uint8_t encodeUUID(const UUID &uuid, uint8_t *buffer);
+
+private:
+    AttributeIndex_t indexOf(GattAttribute::Handle_t handle) const {
+        return (AttributeIndex_t)(handle - firstHandle);
+    }
+
+    UUIDIndex_t internUUID(const UUID &uuid);
+    bool        hasRoomFor(unsigned requiredAttributes) const;
+    bool        appendServiceDeclaration(const UUID &uuid);
+    bool        appendCharacteristicDeclaration(uint8_t props);
+    bool        appendValue(const UUID &type, const uint8_t *initialValue, uint16_t initialLength, uint16_t maxLength, uint8_t props, bool constant);
+    bool        appendImplicitCCCD(uint8_t props);
+    void        commitService(GattAttribute::Handle_t serviceHandle);
+    void        updateHash(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle);
+    void        appendAttribute(UUIDIndex_t type, uint8_t *value, uint16_t length, uint16_t maxLength, uint8_t props);
+    void        rollback(unsigned attributes, unsigned uuidTableSize, unsigned arena);
+    uint8_t    *allocateValue(uint16_t maxLength);
+
+    static int      compareUUIDs(const UUID &a, const UUID &b);
+    static unsigned getRequiredAttributes(uint8_t props, unsigned descriptorCount);
+    static void     clearHandles(GattService &service);
+    static void     clearHandles(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles);
+
+private:
+    GattAttribute::Handle_t firstHandle;
+    uint16_t                attributeCount;
+    uint8_t                 uuidCount;
+    uint8_t                 serviceCount;
+    uint16_t                arenaUsed;
+
+    /* per-attribute tables, indexed by (handle - firstHandle) */
+    UUIDIndex_t             types[MAX_ATTRIBUTES];
+    uint8_t                *values[MAX_ATTRIBUTES];
+    uint16_t                lengths[MAX_ATTRIBUTES];
+    uint16_t                maxLengths[MAX_ATTRIBUTES];
+    uint8_t                 properties[MAX_ATTRIBUTES];
+
+    /* attribute indices ordered by (type, handle) */
+    AttributeIndex_t        attributesByType[MAX_ATTRIBUTES];
+
+    /* distinct attribute types, and their indices ordered by UUID */
+    UUID                    uuids[MAX_UUIDS];
+    UUIDIndex_t             uuidsSorted[MAX_UUIDS];
+
+    /* per-service tables */
+    AttributeIndex_t        serviceStart[MAX_SERVICES];
+    AttributeIndex_t        serviceEnd[MAX_SERVICES];
+    UUIDIndex_t             serviceUUIDs[MAX_SERVICES];
+
+    uint8_t                 valueArena[VALUE_ARENA_SIZE];
+
+    AesCmac                 hash;
+
+private:
+    /* disallow copy and assignment */
+    GattAttributeDatabase(const GattAttributeDatabase &);
+    GattAttributeDatabase& operator=(const GattAttributeDatabase &);
+};
+
+#endif // ifndef __GATT_ATTRIBUTE_DATABASE_H__
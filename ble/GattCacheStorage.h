@@ -0,0 +1,71 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_CACHE_STORAGE_H__
+#define __GATT_CACHE_STORAGE_H__
+
+#include <string.h>
+#include "Gap.h"
+
+/**
+ * The interface through which GattAttributeCache keeps the attribute tables
+ * of peers across connections and resets. An implementation stores opaque
+ * records, one per peer, in flash, in a file, or wherever the platform keeps
+ * persistent data; ble/host/FileGattCacheStorage.h provides one for host builds.
+ *
+ * Records are identified by a key made of the peer's address type followed
+ * by its address; for bonded peers using resolvable private addresses, the
+ * identity address should be used.
+ */
+class GattCacheStorage {
+public:
+    static const unsigned KEY_SIZE = 1 + Gap::ADDR_LEN;
+
+    typedef uint8_t Key_t[KEY_SIZE];
+
+    static void makeKey(Gap::AddressType_t type, const Gap::Address_t address, Key_t key) {
+        key[0] = (uint8_t)type;
+        memcpy(&key[1], address, Gap::ADDR_LEN);
+    }
+
+public:
+    /**
+     * Retrieve a record.
+     *
+     * @param[in]     key
+     *                  Identifies the peer.
+     * @param[out]    buffer
+     *                  Where to put the record.
+     * @param[in,out] lengthP
+     *                  In: the size of the buffer. Out: the length of the record.
+     *
+     * @return BLE_ERROR_INVALID_PARAM if there is no record for the key, or
+     *         BLE_ERROR_BUFFER_OVERFLOW if it doesn't fit in the buffer.
+     */
+    virtual ble_error_t load(const Key_t key, uint8_t *buffer, uint16_t *lengthP) = 0;
+
+    /**
+     * Create or replace a record.
+     */
+    virtual ble_error_t store(const Key_t key, const uint8_t *data, uint16_t length) = 0;
+
+    /**
+     * Delete a record; deleting a record which doesn't exist isn't an error.
+     */
+    virtual ble_error_t erase(const Key_t key) = 0;
+};
+
+#endif // ifndef __GATT_CACHE_STORAGE_H__
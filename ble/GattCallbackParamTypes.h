@@ -88,4 +88,11 @@ struct GattHVXCallbackParams {
   const uint8_t           *data;   /**< Attribute data, variable length. */
 };
 
+/* For a peer enabling or disabling updates of a characteristic of the local server, through its CCCD. */
+struct GattSubscriptionCallbackParams {
+    Gap::Handle_t            connHandle;
+    GattAttribute::Handle_t  handle;  /**< Value handle of the characteristic. */
+    bool                     enabled; /**< Whether notifications and/or indications are now enabled. */
+};
+
 #endif /*__GATT_CALLBACK_PARAM_TYPES_H__*/
\ No newline at end of file
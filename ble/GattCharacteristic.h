@@ -338,7 +338,13 @@ public:
         enabledReadAuthorization(false),
         enabledWriteAuthorization(false),
         readAuthorizationCallback(),
-        writeAuthorizationCallback() {
+        writeAuthorizationCallback(),
+        hasValueProvider(false),
+        _updateSuppression(SUPPRESS_NONE),
+        _suppressionFieldOffset(0),
+        _suppressionFieldSize(0),
+        _suppressionFieldIsSigned(false),
+        _suppressionDeadband(0) {
         /* empty */
     }
 
@@ -375,6 +381,31 @@ public:
         enabledReadAuthorization = true;
     }
 
+    /**
+     * Value providers. A provider computes the characteristic's value on
+     * demand, when a peer reads it, instead of the application pushing
+     * updates which may never be read. It is a read authorization callback
+     * (and takes its place) for which authorizeRead() presets params->data to
+     * the characteristic's value buffer and params->len to its maximum
+     * length; the provider fills the buffer in place and sets params->len to
+     * the length of the value. It may still deny the read through
+     * params->authorizationReply.
+     *
+     * @Note: for long reads the provider is invoked only for the first part
+     * (offset 0); for subsequent Read Blob Requests, authorizeRead() hands
+     * back the value it produced through params->data and params->len, so
+     * that the parts are consistent whatever storage the port keeps.
+     */
+    void setValueProvider(void (*provider)(GattReadAuthCallbackParams *)) {
+        setReadAuthorizationCallback(provider);
+        hasValueProvider = true;
+    }
+    template <typename T>
+    void setValueProvider(T *object, void (T::*member)(GattReadAuthCallbackParams *)) {
+        setReadAuthorizationCallback(object, member);
+        hasValueProvider = true;
+    }
+
     /**
      * Helper function meant to be called from the guts of the BLE stack to
      * determine the authorization reply for a write request.
@@ -403,7 +434,8 @@ public:
      *         the current characteristic value will be used.
      *
      *         If the read is approved, a new value can be provided by setting
-     *         the params->data pointer and params->len fields.
+     *         the params->data pointer and params->len fields. This is the
+     *         whole value; the port serves it from params->offset.
      *
      * @return        true if the read is authorized to proceed.
      */
@@ -413,10 +445,107 @@ public:
         }
 
         params->authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS; /* initialized to no-error by default */
+        if (hasValueProvider) {
+            params->data = _valueAttribute.getValuePtr();
+            if (params->offset != 0) {
+                params->len = *_valueAttribute.getLengthPtr(); /* continuation of a long read; serve the value produced at offset 0 */
+                return AUTH_CALLBACK_REPLY_SUCCESS;
+            }
+            params->len  = _valueAttribute.getMaxLength();
+        }
         readAuthorizationCallback.call(params);
+        if (hasValueProvider && (params->authorizationReply == AUTH_CALLBACK_REPLY_SUCCESS) &&
+            (params->data != NULL) && (_valueAttribute.getValuePtr() != NULL) && (params->len <= _valueAttribute.getMaxLength())) {
+            /* keep the value for the rest of a long read, even if the provider pointed elsewhere */
+            if (params->data != _valueAttribute.getValuePtr()) {
+                memcpy(_valueAttribute.getValuePtr(), params->data, params->len);
+            }
+            *_valueAttribute.getLengthPtr() = params->len;
+        }
         return params->authorizationReply;
     }
 
+public:
+    /**
+     * Update suppression. Sensor readings are often pushed at a fixed rate
+     * whether or not they have changed; GattServer::write(GattCharacteristic &, ...)
+     * uses this setting to drop updates which don't differ (meaningfully)
+     * from the current value, saving the transport call and the notification.
+     */
+    enum UpdateSuppression_t {
+        SUPPRESS_NONE      = 0, /**< Every update is applied. */
+        SUPPRESS_IDENTICAL = 1, /**< Skip updates which are byte-for-byte identical to the current value. */
+        SUPPRESS_DEADBAND  = 2, /**< Skip updates whose numeric field lies within a deadband of the current value. */
+    };
+
+    void suppressIdenticalUpdates(void) {
+        _updateSuppression = SUPPRESS_IDENTICAL;
+    }
+
+    /**
+     * Skip updates which leave the value unchanged except for a numeric field
+     * whose change, relative to the current value, doesn't exceed a deadband.
+     * Since suppressed updates leave the current value alone, slow drift is
+     * still published once it accumulates beyond the deadband.
+     *
+     * @param[in] fieldOffset
+     *              Offset of the numeric field within the value.
+     * @param[in] fieldSize
+     *              Width of the field in bytes (1 to 4); the field is little-endian.
+     * @param[in] fieldIsSigned
+     *              Whether the field holds a two's complement number.
+     * @param[in] deadband
+     *              Largest change which is suppressed, in units of the field.
+     */
+    void suppressUpdatesWithinDeadband(uint8_t fieldOffset, uint8_t fieldSize, bool fieldIsSigned, uint32_t deadband) {
+        _updateSuppression        = SUPPRESS_DEADBAND;
+        _suppressionFieldOffset   = fieldOffset;
+        _suppressionFieldSize     = (fieldSize > sizeof(uint32_t)) ? sizeof(uint32_t) : fieldSize;
+        _suppressionFieldIsSigned = fieldIsSigned;
+        _suppressionDeadband      = deadband;
+    }
+
+    void disableUpdateSuppression(void) {
+        _updateSuppression = SUPPRESS_NONE;
+    }
+
+    /**
+     * Helper function to determine whether an update to the value would be
+     * suppressed under the current setting.
+     *
+     * @param[in] currentValue, currentLen
+     *              The value currently held by the server.
+     * @param[in] newValue, newLen
+     *              The update.
+     */
+    bool isRedundantUpdate(const uint8_t *currentValue, uint16_t currentLen, const uint8_t *newValue, uint16_t newLen) const {
+        if ((_updateSuppression == SUPPRESS_NONE) || (currentLen != newLen)) {
+            return false;
+        }
+
+        unsigned fieldEnd = _suppressionFieldOffset + _suppressionFieldSize;
+        if ((_updateSuppression == SUPPRESS_IDENTICAL) || (fieldEnd > newLen)) {
+            return memcmp(currentValue, newValue, newLen) == 0;
+        }
+
+        /* everything but the numeric field has to be identical */
+        if ((memcmp(currentValue, newValue, _suppressionFieldOffset) != 0) ||
+            (memcmp(&currentValue[fieldEnd], &newValue[fieldEnd], newLen - fieldEnd) != 0)) {
+            return false;
+        }
+
+        uint32_t current = decodeSuppressionField(&currentValue[_suppressionFieldOffset]);
+        uint32_t update  = decodeSuppressionField(&newValue[_suppressionFieldOffset]);
+        uint32_t change;
+        if (_suppressionFieldIsSigned) {
+            change = ((int32_t)update > (int32_t)current) ? (update - current) : (current - update);
+        } else {
+            change = (update > current) ? (update - current) : (current - update);
+        }
+
+        return change <= _suppressionDeadband;
+    }
+
     /* accessors */
 public:
     GattAttribute&          getValueAttribute()                 {return _valueAttribute;                }
@@ -427,6 +556,8 @@ public:
     uint8_t                 getDescriptorCount(void)      const {return _descriptorCount;               }
     bool                    isReadAuthorizationEnabled()  const {return enabledReadAuthorization;       }
     bool                    isWriteAuthorizationEnabled() const {return enabledWriteAuthorization;      }
+    bool                    isValueProviderEnabled()      const {return hasValueProvider;               }
+    UpdateSuppression_t     getUpdateSuppression(void)    const {return (UpdateSuppression_t)_updateSuppression;}
 
     GattAttribute *getDescriptor(uint8_t index) {
         if (index >= _descriptorCount) {
@@ -447,6 +578,28 @@ private:
     bool enabledWriteAuthorization;
     FunctionPointerWithContext<GattReadAuthCallbackParams *>  readAuthorizationCallback;
     FunctionPointerWithContext<GattWriteAuthCallbackParams *> writeAuthorizationCallback;
+    bool hasValueProvider;
+
+    uint8_t  _updateSuppression;
+    uint8_t  _suppressionFieldOffset;
+    uint8_t  _suppressionFieldSize;
+    bool     _suppressionFieldIsSigned;
+    uint32_t _suppressionDeadband;
+
+private:
+    /* decode the little-endian numeric field used for deadband suppression, sign-extending as required */
+    uint32_t decodeSuppressionField(const uint8_t *field) const {
+        uint32_t value = 0;
+        for (unsigned i = _suppressionFieldSize; i > 0; i--) {
+            value = (value << 8) | field[i - 1];
+        }
+        if (_suppressionFieldIsSigned && (_suppressionFieldSize < sizeof(uint32_t)) &&
+            (field[_suppressionFieldSize - 1] & 0x80)) {
+            value |= ~(uint32_t)0 << (8 * _suppressionFieldSize);
+        }
+
+        return value;
+    }
 
 private:
     /* disallow copy and assignment */
@@ -457,11 +610,11 @@ private:
 template <typename T>
 class ReadOnlyGattCharacteristic : public GattCharacteristic {
 public:
-    ReadOnlyGattCharacteristic<T>(const UUID    &uuid,
-                                  T             *valuePtr,
-                                  uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                  GattAttribute *descriptors[]        = NULL,
-                                  unsigned       numDescriptors       = 0) :
+    ReadOnlyGattCharacteristic(const UUID    &uuid,
+                               T             *valuePtr,
+                               uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                               GattAttribute *descriptors[]        = NULL,
+                               unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T), sizeof(T),
                            BLE_GATT_CHAR_PROPERTIES_READ | additionalProperties, descriptors, numDescriptors) {
         /* empty */
@@ -471,11 +624,11 @@ public:
 template <typename T>
 class WriteOnlyGattCharacteristic : public GattCharacteristic {
 public:
-    WriteOnlyGattCharacteristic<T>(const UUID     &uuid,
-                                   T              *valuePtr,
-                                   uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                   GattAttribute *descriptors[]        = NULL,
-                                   unsigned       numDescriptors       = 0) :
+    WriteOnlyGattCharacteristic(const UUID     &uuid,
+                                T              *valuePtr,
+                                uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                                GattAttribute *descriptors[]        = NULL,
+                                unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T), sizeof(T),
                            BLE_GATT_CHAR_PROPERTIES_WRITE | additionalProperties, descriptors, numDescriptors) {
         /* empty */
@@ -485,11 +638,11 @@ public:
 template <typename T>
 class ReadWriteGattCharacteristic : public GattCharacteristic {
 public:
-    ReadWriteGattCharacteristic<T>(const UUID    &uuid,
-                                   T             *valuePtr,
-                                   uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                   GattAttribute *descriptors[]        = NULL,
-                                   unsigned       numDescriptors       = 0) :
+    ReadWriteGattCharacteristic(const UUID    &uuid,
+                                T             *valuePtr,
+                                uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                                GattAttribute *descriptors[]        = NULL,
+                                unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T), sizeof(T),
                            BLE_GATT_CHAR_PROPERTIES_READ | BLE_GATT_CHAR_PROPERTIES_WRITE | additionalProperties, descriptors, numDescriptors) {
         /* empty */
@@ -499,11 +652,11 @@ public:
 template <typename T, unsigned NUM_ELEMENTS>
 class WriteOnlyArrayGattCharacteristic : public GattCharacteristic {
 public:
-    WriteOnlyArrayGattCharacteristic<T, NUM_ELEMENTS>(const          UUID &uuid,
-                                                      T              valuePtr[NUM_ELEMENTS],
-                                                      uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                                      GattAttribute *descriptors[]        = NULL,
-                                                      unsigned       numDescriptors       = 0) :
+    WriteOnlyArrayGattCharacteristic(const          UUID &uuid,
+                                     T              valuePtr[NUM_ELEMENTS],
+                                     uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                                     GattAttribute *descriptors[]        = NULL,
+                                     unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T) * NUM_ELEMENTS, sizeof(T) * NUM_ELEMENTS,
                            BLE_GATT_CHAR_PROPERTIES_WRITE | additionalProperties, descriptors, numDescriptors) {
         /* empty */
@@ -513,11 +666,11 @@ public:
 template <typename T, unsigned NUM_ELEMENTS>
 class ReadOnlyArrayGattCharacteristic : public GattCharacteristic {
 public:
-    ReadOnlyArrayGattCharacteristic<T, NUM_ELEMENTS>(const UUID    &uuid,
-                                                     T              valuePtr[NUM_ELEMENTS],
-                                                     uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                                     GattAttribute *descriptors[]        = NULL,
-                                                     unsigned       numDescriptors       = 0) :
+    ReadOnlyArrayGattCharacteristic(const UUID    &uuid,
+                                    T              valuePtr[NUM_ELEMENTS],
+                                    uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                                    GattAttribute *descriptors[]        = NULL,
+                                    unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T) * NUM_ELEMENTS, sizeof(T) * NUM_ELEMENTS,
                            BLE_GATT_CHAR_PROPERTIES_READ | additionalProperties, descriptors, numDescriptors) {
         /* empty */
@@ -527,11 +680,11 @@ public:
 template <typename T, unsigned NUM_ELEMENTS>
 class ReadWriteArrayGattCharacteristic : public GattCharacteristic {
 public:
-    ReadWriteArrayGattCharacteristic<T, NUM_ELEMENTS>(const UUID    &uuid,
-                                                      T              valuePtr[NUM_ELEMENTS],
-                                                      uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
-                                                      GattAttribute *descriptors[]        = NULL,
-                                                      unsigned       numDescriptors       = 0) :
+    ReadWriteArrayGattCharacteristic(const UUID    &uuid,
+                                     T              valuePtr[NUM_ELEMENTS],
+                                     uint8_t        additionalProperties = BLE_GATT_CHAR_PROPERTIES_NONE,
+                                     GattAttribute *descriptors[]        = NULL,
+                                     unsigned       numDescriptors       = 0) :
         GattCharacteristic(uuid, reinterpret_cast<uint8_t *>(valuePtr), sizeof(T) * NUM_ELEMENTS, sizeof(T) * NUM_ELEMENTS,
                            BLE_GATT_CHAR_PROPERTIES_READ | BLE_GATT_CHAR_PROPERTIES_WRITE | additionalProperties, descriptors, numDescriptors) {
         /* empty */
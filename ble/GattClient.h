@@ -22,6 +22,14 @@
 #include "ServiceDiscovery.h"
 
 #include "GattCallbackParamTypes.h"
+#include "GattHVXBuffer.h"
+
+#ifndef BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS
+#define BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS 16 /**< Reads and writes held by the request queue across all connections. */
+#endif
+#ifndef BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS
+#define BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS 16 /**< Per-attribute handlers of notifications and indications, across all connections. */
+#endif
 
 class GattClient {
 public:
@@ -36,6 +44,22 @@ public:
 
     typedef void (*HVXCallback_t)(const GattHVXCallbackParams *params);
 
+    /**
+     * The outcome of a request issued through queueRead() or queueWrite().
+     */
+    struct RequestResult_t {
+        Gap::Handle_t            connHandle;
+        GattAttribute::Handle_t  handle;
+        uint16_t                 offset;
+        ble_error_t              status;  /**< BLE_ERROR_NONE once the peer has responded (or, for a write command, once it has been sent); otherwise the reason the request failed. */
+        uint16_t                 len;     /**< For reads, the length of the value read; for writes, the length written. */
+        const uint8_t           *data;    /**< For reads, the value read; NULL for writes. */
+        void                    *context; /**< As passed to queueRead() or queueWrite(). */
+        GattAuthCallbackReply_t  attError; /**< If the peer responded with an Error Response, its error code (as AUTH_CALLBACK_REPLY_ATTERR_*); else AUTH_CALLBACK_REPLY_SUCCESS. */
+    };
+
+    typedef void (*RequestCallback_t)(const RequestResult_t *result);
+
     /*
      * The following functions are meant to be overridden in the platform-specific sub-class.
      */
@@ -91,6 +115,13 @@ public:
      *           service. This allows for an inexpensive method to discover only
      *           services.
      *
+     * @param  tc
+     *           Invoked when this discovery terminates, in place of the
+     *           callback set up with onServiceDiscoveryTermination(); taken as
+     *           NULL by default. This tells apart discoveries running on
+     *           several connections at once, which ports may support (see
+     *           isServiceDiscoveryActive(Gap::Handle_t)).
+     *
      * @return
      *           BLE_ERROR_NONE if service discovery is launched successfully; else an appropriate error.
      */
@@ -98,17 +129,66 @@ public:
                                                ServiceDiscovery::ServiceCallback_t         sc                           = NULL,
                                                ServiceDiscovery::CharacteristicCallback_t  cc                           = NULL,
                                                const UUID                                 &matchingServiceUUID          = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
-                                               const UUID                                 &matchingCharacteristicUUIDIn = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) {
+                                               const UUID                                 &matchingCharacteristicUUIDIn = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                               ServiceDiscovery::TerminationCallback_t     tc                           = NULL) {
         /* avoid compiler warnings about unused variables */
         (void)connectionHandle;
         (void)sc;
         (void)cc;
         (void)matchingServiceUUID;
         (void)matchingCharacteristicUUIDIn;
+        (void)tc;
 
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Launch service discovery for sets of services and characteristics, in
+     * place of launching it once per UUID or filtering in the callbacks. The
+     * other parameters are as above.
+     *
+     * @param  matchingServiceUUIDs
+     *           Services of interest; an empty set matches every service.
+     * @param  matchingCharacteristicUUIDs
+     *           Characteristics of interest; an empty set matches every
+     *           characteristic, and services are then reported as above.
+     *
+     * @note     Discovery ends as soon as everything asked for has been found.
+     *           With a set of services, the first instance of each is
+     *           reported. If both sets are non-empty, so is the first
+     *           instance of each characteristic among those services; once
+     *           all have been found, the remaining services are not searched.
+     *
+     * @note     The sets refer to the caller's UUIDs, which must remain valid
+     *           until the discovery terminates.
+     *
+     * @return
+     *           BLE_ERROR_NONE if service discovery is launched successfully;
+     *           BLE_ERROR_INVALID_PARAM if either set was built from more
+     *           than UUIDSet::MAX_SIZE UUIDs;
+     *           by default, BLE_ERROR_NOT_IMPLEMENTED if either set has more
+     *           than one member, as ports which don't override this only
+     *           support the single-UUID filters.
+     */
+    virtual ble_error_t launchServiceDiscovery(Gap::Handle_t                               connectionHandle,
+                                               ServiceDiscovery::ServiceCallback_t         sc,
+                                               ServiceDiscovery::CharacteristicCallback_t  cc,
+                                               const UUIDSet                              &matchingServiceUUIDs,
+                                               const UUIDSet                              &matchingCharacteristicUUIDs,
+                                               ServiceDiscovery::TerminationCallback_t     tc = NULL) {
+        if (matchingServiceUUIDs.isTruncated() || matchingCharacteristicUUIDs.isTruncated()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if ((matchingServiceUUIDs.getCount() > 1) || (matchingCharacteristicUUIDs.getCount() > 1)) {
+            return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+        }
+
+        return launchServiceDiscovery(connectionHandle, sc, cc,
+                                      matchingServiceUUIDs.isEmpty() ? UUID(UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) : matchingServiceUUIDs.getUUID(0),
+                                      matchingCharacteristicUUIDs.isEmpty() ? UUID(UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) : matchingCharacteristicUUIDs.getUUID(0),
+                                      tc);
+    }
+
     /**
      * Launch service discovery for services. Once launched, service discovery will remain
      * active with service-callbacks being issued back into the application for matching
@@ -183,20 +263,118 @@ public:
     }
 
     /**
-     * Is service-discovery currently active?
+     * Is service-discovery currently active, on any connection?
      */
     virtual bool isServiceDiscoveryActive(void) const {
         return false; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
     /**
-     * Terminate an ongoing service-discovery. This should result in an
-     * invocation of the TerminationCallback if service-discovery is active.
+     * Is service-discovery active on a given connection? Where this returns
+     * false, discovery can be launched on the connection even while it runs
+     * on others.
+     *
+     * @Note: ports which discover on one connection at a time needn't
+     * override this; any discovery in progress keeps all connections busy.
+     */
+    virtual bool isServiceDiscoveryActive(Gap::Handle_t connectionHandle) const {
+        (void)connectionHandle; /* avoid compiler warnings about ununsed variables */
+
+        return isServiceDiscoveryActive();
+    }
+
+    /**
+     * Terminate ongoing service-discovery, on all connections. This should
+     * result in an invocation of the TerminationCallback if service-discovery
+     * is active.
      */
     virtual void terminateServiceDiscovery(void) {
         /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Terminate service-discovery on a given connection, leaving others to
+     * run. By default, this terminates any discovery in progress.
+     */
+    virtual void terminateServiceDiscovery(Gap::Handle_t connectionHandle) {
+        (void)connectionHandle; /* avoid compiler warnings about ununsed variables */
+
+        terminateServiceDiscovery();
+    }
+
+    /**
+     * Launch discovery of the descriptors of a characteristic, with Find
+     * Information Requests over the handles following its value. It ends at
+     * the next declaration, and usually takes a single round trip.
+     *
+     * @param[in] characteristic
+     *              As reported by service discovery.
+     * @param[in] callback
+     *              Invoked for each matching descriptor.
+     * @param[in] matchingUUID
+     *              Filter for descriptors; a wildcard UUID discovers all of them.
+     * @param[in] tc
+     *              Invoked when the discovery terminates, in place of the
+     *              callback set up with onServiceDiscoveryTermination().
+     *
+     * @return BLE_STACK_BUSY if discovery is already active on the connection.
+     *
+     * @Note: descriptor discovery counts as service-discovery for the purposes
+     * of isServiceDiscoveryActive() and terminateServiceDiscovery().
+     */
+    virtual ble_error_t discoverCharacteristicDescriptors(const DiscoveredCharacteristic          &characteristic,
+                                                          ServiceDiscovery::DescriptorCallback_t   callback,
+                                                          const UUID                              &matchingUUID,
+                                                          ServiceDiscovery::TerminationCallback_t  tc = NULL) {
+        /* avoid compiler warnings about unused variables */
+        (void)characteristic;
+        (void)callback;
+        (void)matchingUUID;
+        (void)tc;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
+    /**
+     * Launch discovery of the descriptors of all characteristics in a range of
+     * handles, typically that of a service. Each Find Information Response
+     * covers as many attributes as fit in ATT_MTU, so the descriptors of a
+     * whole service are found in a sweep of a few round trips rather than one
+     * procedure per characteristic. Descriptors are attributed to the
+     * characteristic declared before them, which is given by
+     * DiscoveredDescriptor::valueHandle; the range should therefore begin with
+     * a service or characteristic declaration.
+     *
+     * @param[in] connectionHandle
+     *              Handle for the connection with the peer.
+     * @param[in] startHandle, endHandle
+     *              The range to search.
+     * @param[in] callback
+     *              Invoked for each matching descriptor, in handle order.
+     * @param[in] matchingUUID
+     *              Filter for descriptors; a wildcard UUID discovers all of them.
+     * @param[in] tc
+     *              As for discoverCharacteristicDescriptors().
+     *
+     * @return BLE_STACK_BUSY if discovery is already active on the connection.
+     */
+    virtual ble_error_t discoverDescriptors(Gap::Handle_t                            connectionHandle,
+                                            GattAttribute::Handle_t                  startHandle,
+                                            GattAttribute::Handle_t                  endHandle,
+                                            ServiceDiscovery::DescriptorCallback_t   callback,
+                                            const UUID                              &matchingUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                            ServiceDiscovery::TerminationCallback_t  tc           = NULL) {
+        /* avoid compiler warnings about unused variables */
+        (void)connectionHandle;
+        (void)startHandle;
+        (void)endHandle;
+        (void)callback;
+        (void)matchingUUID;
+        (void)tc;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
     /* Initiate a Gatt Client read procedure by attribute-handle. */
     virtual ble_error_t read(Gap::Handle_t connHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset) const {
         /* avoid compiler warnings about unused variables */
@@ -207,6 +385,37 @@ public:
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Read the values of several attributes in a single round trip, with a
+     * Read Multiple Request or a Read Multiple Variable Request. The port
+     * reports the response through processReadMultipleResponse().
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] handles
+     *              The attributes to read; at least two.
+     * @param[in] count
+     *              The number of handles.
+     * @param[in] variableLength
+     *              Use Read Multiple Variable, whose response gives the length
+     *              of each value; Read Multiple simply concatenates them.
+     *
+     * @return BLE_ERROR_NOT_IMPLEMENTED if the port (or, for
+     *         variableLength, the peer) doesn't support the request.
+     */
+    virtual ble_error_t readMultiple(Gap::Handle_t                  connHandle,
+                                     const GattAttribute::Handle_t *handles,
+                                     uint8_t                        count,
+                                     bool                           variableLength) const {
+        /* avoid compiler warnings about unused variables */
+        (void)connHandle;
+        (void)handles;
+        (void)count;
+        (void)variableLength;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
     /**
      * Initiate a GATT Client write procedure.
      *
@@ -238,6 +447,172 @@ public:
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Initiate an ATT MTU exchange with the peer. Once it completes, the
+     * port reports the resulting MTU through Gap::processAttMtuChangeEvent(),
+     * which invokes the callbacks registered with Gap::onAttMtuChange().
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] clientRxMtu
+     *              The largest ATT MTU the local device can receive.
+     */
+    virtual ble_error_t exchangeMtu(Gap::Handle_t connHandle, uint16_t clientRxMtu = BLE_GATT_MTU_SIZE_MAX) {
+        /* avoid compiler warnings about unused variables */
+        (void)connHandle;
+        (void)clientRxMtu;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
+    /*
+     * Queued requests. ATT allows one outstanding request per connection, so
+     * read() and write() fail with BLE_STACK_BUSY (or leave the application to
+     * match responses to requests) while one is in progress. The queue accepts
+     * any number of reads and writes up to BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS,
+     * issues each one as soon as the response to the previous one arrives, and
+     * completes each through its own callback. Write commands don't wait for
+     * an outstanding request; they are sent as soon as all requests queued
+     * ahead of them have been, so the order on the link is that of the queue.
+     */
+public:
+    /**
+     * Queue a read of an attribute by handle.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] attributeHandle
+     *              Handle of the attribute on the remote GATT server.
+     * @param[in] offset
+     *              Offset into the value; a non-zero offset reads a blob.
+     *              GattLongRead builds on this to read values longer than a
+     *              single response.
+     * @param[in] callback
+     *              Invoked once with the value read, or with the reason the
+     *              read failed: an Error Response from the peer (which ports
+     *              report through processRequestError()), or the end of the
+     *              connection. It may be invoked before this returns if the
+     *              read can't be issued.
+     * @param[in] context
+     *              Handed back to the callback, to tell requests apart.
+     *
+     * @return BLE_ERROR_NO_MEM if the queue is full; BLE_ERROR_NONE otherwise.
+     *
+     * @Note: responses to requests issued directly with read() or write() on a
+     * connection with queued requests may be taken for responses to queued ones.
+     */
+    ble_error_t queueRead(Gap::Handle_t            connHandle,
+                          GattAttribute::Handle_t  attributeHandle,
+                          uint16_t                 offset,
+                          RequestCallback_t        callback,
+                          void                    *context = NULL) {
+        return queueRequest(REQUEST_READ, connHandle, attributeHandle, offset, 0, NULL, callback, context);
+    }
+
+    /**
+     * Queue a write request or a write command.
+     *
+     * @param[in] cmd
+     *              GATT_OP_WRITE_REQ, completed once the peer responds; or
+     *              GATT_OP_WRITE_CMD, completed once it has been sent.
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] attributeHandle
+     *              Handle of the attribute on the remote GATT server.
+     * @param[in] length
+     *              Length of the new value.
+     * @param[in] value
+     *              The new value. It isn't copied; it must remain valid until
+     *              the callback is invoked.
+     * @param[in] callback
+     *              Invoked once when the write completes or fails; may be NULL.
+     * @param[in] context
+     *              Handed back to the callback, to tell requests apart.
+     *
+     * @return BLE_ERROR_NO_MEM if the queue is full, or
+     *         BLE_ERROR_PARAM_OUT_OF_RANGE if length exceeds ATT_MTU - 3 on
+     *         the connection (see Gap::getMaxPayload());
+     *         BLE_ERROR_NONE otherwise.
+     *
+     * @Note: longer values, which take Prepare Write Requests, are rejected
+     * rather than truncated.
+     */
+    ble_error_t queueWrite(GattClient::WriteOp_t    cmd,
+                           Gap::Handle_t            connHandle,
+                           GattAttribute::Handle_t  attributeHandle,
+                           size_t                   length,
+                           const uint8_t           *value,
+                           RequestCallback_t        callback = NULL,
+                           void                    *context  = NULL) {
+        uint16_t maxLength = (gap != NULL) ? gap->getMaxPayload(connHandle) : (BLE_GATT_MTU_SIZE_DEFAULT - 3);
+        if (length > maxLength) {
+            return BLE_ERROR_PARAM_OUT_OF_RANGE;
+        }
+        return queueRequest((cmd == GATT_OP_WRITE_CMD) ? REQUEST_WRITE_CMD : REQUEST_WRITE_REQ,
+                            connHandle, attributeHandle, 0, (uint16_t)length, value, callback, context);
+    }
+
+    /**
+     * Queue a Read Multiple (Variable) Request; see readMultiple(). The result
+     * carries the raw values from the response, as described there; it
+     * fails with BLE_ERROR_NOT_IMPLEMENTED if the port or the peer doesn't
+     * support the request. GattReadBatch builds on this to read a set of
+     * values with whatever the port and the peer support.
+     *
+     * @param[in] handles
+     *              The attributes to read. The array isn't copied; it must
+     *              remain valid until the callback is invoked.
+     */
+    ble_error_t queueReadMultiple(Gap::Handle_t                  connHandle,
+                                  const GattAttribute::Handle_t *handles,
+                                  uint8_t                        count,
+                                  bool                           variableLength,
+                                  RequestCallback_t              callback,
+                                  void                          *context = NULL) {
+        if (count < 2) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        return queueRequest(variableLength ? REQUEST_READ_MULTIPLE_VARIABLE : REQUEST_READ_MULTIPLE,
+                            connHandle, handles[0], 0, count, reinterpret_cast<const uint8_t *>(handles), callback, context);
+    }
+
+    /**
+     * Withdraw the queued requests of a connection which carry a given
+     * context and haven't been issued yet; their callbacks aren't invoked.
+     * A request in progress can't be withdrawn, as its response is due.
+     *
+     * @return The number of requests withdrawn.
+     */
+    unsigned cancelQueuedRequests(Gap::Handle_t connHandle, void *context) {
+        unsigned cancelled = 0;
+        for (unsigned i = 0; i < requestCount; ) {
+            if ((requests[i].connHandle == connHandle) && (requests[i].context == context) && !requests[i].inProgress) {
+                for (unsigned j = i + 1; j < requestCount; j++) {
+                    requests[j - 1] = requests[j];
+                }
+                requestCount--;
+                cancelled++;
+            } else {
+                i++;
+            }
+        }
+        return cancelled;
+    }
+
+    /**
+     * The number of queued requests for a connection which haven't completed,
+     * including the one in progress.
+     */
+    unsigned getQueuedRequestCount(Gap::Handle_t connHandle) const {
+        unsigned count = 0;
+        for (unsigned i = 0; i < requestCount; i++) {
+            if (requests[i].connHandle == connHandle) {
+                count++;
+            }
+        }
+        return count;
+    }
+
     /* Event callback handlers. */
 public:
     /**
@@ -267,7 +642,8 @@ public:
     }
 
     /**
-     * Setup callback for when serviceDiscovery terminates.
+     * Setup callback for when serviceDiscovery terminates, for discoveries
+     * launched without a termination callback of their own.
      */
     virtual void onServiceDiscoveryTermination(ServiceDiscovery::TerminationCallback_t callback) {
         (void)callback; /* avoid compiler warnings about ununsed variables */
@@ -284,36 +660,442 @@ public:
         onHVXCallback = callback;
     }
 
+    /**
+     * Subscribe to the notifications and indications of one attribute on one
+     * connection. These go straight to the subscription, found by a binary
+     * search of a table kept in order, and no longer reach the callback set
+     * up with onHVX(HVXCallback_t). Subscribing again replaces the
+     * subscription; subscriptions end with the connection.
+     *
+     * @Note: this routes what the peer sends; enabling it is up to the
+     * application, through the characteristic's CCCD.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] valueHandle
+     *              The attribute whose updates are wanted.
+     * @param[in] callback
+     *              Invoked for each update; or, with a buffer, when an update
+     *              arrives to find the buffer empty, to prompt the application
+     *              to drain it. May be NULL.
+     * @param[ref] buffer
+     *              If not NULL, updates are appended to it rather than
+     *              passed to the callback. It must outlive the subscription.
+     *
+     * @return BLE_ERROR_NO_MEM if BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS are
+     *         in use already.
+     */
+    ble_error_t onHVX(Gap::Handle_t            connHandle,
+                      GattAttribute::Handle_t  valueHandle,
+                      HVXCallback_t            callback,
+                      GattHVXBuffer           *buffer = NULL) {
+        uint32_t key   = makeSubscriptionKey(connHandle, valueHandle);
+        unsigned index = findSubscriptionIndex(key);
+        if ((index == subscriptionCount) || (subscriptionKeys[index] != key)) {
+            if (subscriptionCount >= BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS) {
+                return BLE_ERROR_NO_MEM;
+            }
+            for (unsigned i = subscriptionCount; i > index; i--) {
+                subscriptionKeys[i] = subscriptionKeys[i - 1];
+                subscriptions[i]    = subscriptions[i - 1];
+            }
+            subscriptionKeys[index] = key;
+            subscriptionCount++;
+        }
+
+        subscriptions[index].callback = callback;
+        subscriptions[index].buffer   = buffer;
+        return BLE_ERROR_NONE;
+    }
+
+    /**
+     * End a subscription; updates of the attribute go to the onHVX()
+     * callback again.
+     */
+    void detachHVX(Gap::Handle_t connHandle, GattAttribute::Handle_t valueHandle) {
+        uint32_t key   = makeSubscriptionKey(connHandle, valueHandle);
+        unsigned index = findSubscriptionIndex(key);
+        if ((index < subscriptionCount) && (subscriptionKeys[index] == key)) {
+            removeSubscription(index);
+        }
+    }
+
 protected:
-    GattClient() {
+    GattClient() : gap(NULL), requestCount(0), subscriptionCount(0) {
         /* empty */
     }
 
     /* Entry points for the underlying stack to report events back to the user. */
 public:
+    /**
+     * Responses to queued reads complete them, and let the next queued
+     * request go out; others are passed to the onDataRead() callback.
+     */
     void processReadResponse(const GattReadCallbackParams *params) {
+        int index = findRequestInProgress(params->connHandle, REQUEST_READ, params->handle);
+        if (index >= 0) {
+            completeRequest(index, BLE_ERROR_NONE, params->len, params->data);
+            issueRequests(params->connHandle);
+            return;
+        }
+
         if (onDataReadCallback) {
             onDataReadCallback(params);
         }
     }
 
     void processWriteResponse(const GattWriteCallbackParams *params) {
+        int index = (params->writeOp == GattWriteCallbackParams::OP_WRITE_REQ) ?
+                        findRequestInProgress(params->connHandle, REQUEST_WRITE_REQ, params->handle) : -1;
+        if (index >= 0) {
+            completeRequest(index, BLE_ERROR_NONE, requests[index].length, NULL);
+            issueRequests(params->connHandle);
+            return;
+        }
+
         if (onDataWriteCallback) {
             onDataWriteCallback(params);
         }
     }
 
+    /**
+     * Report an Error Response from the peer to a read, Read Multiple or
+     * write request. The queued request in progress is completed with the
+     * error, and the next queued request goes out; without this, the queue
+     * of the connection would wait for a response which never comes.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] handle
+     *              The attribute in error, as carried by the Error Response.
+     * @param[in] attError
+     *              The error code, as AUTH_CALLBACK_REPLY_ATTERR_* (0x0100
+     *              plus the ATT error code).
+     */
+    void processRequestError(Gap::Handle_t connHandle, GattAttribute::Handle_t handle, GattAuthCallbackReply_t attError) {
+        int index = findRequestInProgress(connHandle, REQUEST_READ, handle);
+        if (index < 0) {
+            index = findRequestInProgress(connHandle, REQUEST_WRITE_REQ, handle);
+        }
+        if (index < 0) {
+            index = findRequestInProgress(connHandle, REQUEST_READ_MULTIPLE, GattAttribute::INVALID_HANDLE);
+        }
+        if (index >= 0) {
+            completeRequest(index, getErrorStatus(attError), 0, NULL, attError);
+            issueRequests(connHandle);
+        }
+    }
+
+    /**
+     * The ble_error_t reported for an ATT error.
+     */
+    static ble_error_t getErrorStatus(GattAuthCallbackReply_t attError) {
+        switch (attError) {
+            case AUTH_CALLBACK_REPLY_SUCCESS:
+                return BLE_ERROR_NONE;
+            case AUTH_CALLBACK_REPLY_ATTERR_INVALID_HANDLE:
+            case AUTH_CALLBACK_REPLY_ATTERR_ATTRIBUTE_NOT_FOUND:
+                return BLE_ERROR_INVALID_PARAM;
+            case AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET:
+                return BLE_ERROR_PARAM_OUT_OF_RANGE;
+            case AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH:
+                return BLE_ERROR_BUFFER_OVERFLOW;
+            case AUTH_CALLBACK_REPLY_ATTERR_INSUF_RESOURCES:
+            case AUTH_CALLBACK_REPLY_ATTERR_PREPARE_QUEUE_FULL:
+                return BLE_ERROR_NO_MEM;
+            case AUTH_CALLBACK_REPLY_ATTERR_READ_NOT_PERMITTED:
+            case AUTH_CALLBACK_REPLY_ATTERR_WRITE_NOT_PERMITTED:
+            case AUTH_CALLBACK_REPLY_ATTERR_INSUF_AUTHENTICATION:
+            case AUTH_CALLBACK_REPLY_ATTERR_INSUF_AUTHORIZATION:
+            case AUTH_CALLBACK_REPLY_ATTERR_ATTRIBUTE_NOT_LONG:
+                return BLE_ERROR_OPERATION_NOT_PERMITTED;
+            default:
+                return BLE_ERROR_UNSPECIFIED;
+        }
+    }
+
+    /**
+     * Report the response to a readMultiple(): the concatenated values for
+     * Read Multiple, or length and value pairs for Read Multiple Variable,
+     * as they appear in the PDU. If the peer responded with an error, status
+     * is other than BLE_ERROR_NONE and there is no data.
+     */
+    void processReadMultipleResponse(Gap::Handle_t connHandle, ble_error_t status, const uint8_t *data, uint16_t len) {
+        int index = findRequestInProgress(connHandle, REQUEST_READ_MULTIPLE, GattAttribute::INVALID_HANDLE);
+        if (index >= 0) {
+            completeRequest(index, status, len, data);
+            issueRequests(connHandle);
+        }
+    }
+
+    /**
+     * Updates of subscribed attributes go to their subscriptions; others to
+     * the onHVX() callback.
+     */
     void processHVXEvent(const GattHVXCallbackParams *params) {
+        uint32_t key   = makeSubscriptionKey(params->connHandle, params->handle);
+        unsigned index = findSubscriptionIndex(key);
+        if ((index < subscriptionCount) && (subscriptionKeys[index] == key)) {
+            const HVXSubscription_t &subscription = subscriptions[index];
+            if (subscription.buffer == NULL) {
+                if (subscription.callback) {
+                    subscription.callback(params);
+                }
+            } else {
+                bool wasEmpty = subscription.buffer->isEmpty();
+                if (subscription.buffer->push(params->data, params->len) && wasEmpty && subscription.callback) {
+                    subscription.callback(params);
+                }
+            }
+            return;
+        }
+
         if (onHVXCallback) {
             onHVXCallback(params);
         }
     }
 
+    /**
+     * Let the client size requests to the ATT MTU of each connection. This
+     * is done by BLE::init(); until then, the default ATT MTU is assumed.
+     */
+    void setGap(const Gap *gapIn) {
+        gap = gapIn;
+    }
+
+    /**
+     * Retry queued requests which found the stack without transmit buffers.
+     * This is attached to GattServer::onDataSent() by BLE::init().
+     */
+    void processDataSentEvent(unsigned count) {
+        (void)count; /* avoid compiler warnings about unused variables */
+
+        for (unsigned i = 0; i < requestCount; i++) {
+            if (!requests[i].inProgress) {
+                issueRequests(requests[i].connHandle);
+            }
+        }
+    }
+
+    /**
+     * Fail the queued requests of a terminated connection with
+     * BLE_ERROR_INVALID_STATE. This is attached to the disconnection call
+     * chain by BLE::init().
+     */
+    void processDisconnectionEvent(const Gap::DisconnectionCallbackParams_t *params) {
+        /* The connection's subscriptions are contiguous in the table. */
+        unsigned index = findSubscriptionIndex(makeSubscriptionKey(params->handle, 0));
+        while ((index < subscriptionCount) && ((subscriptionKeys[index] >> 16) == params->handle)) {
+            removeSubscription(index);
+        }
+
+        for (unsigned i = 0; i < requestCount; ) {
+            if (requests[i].connHandle == params->handle) {
+                completeRequest(i, BLE_ERROR_INVALID_STATE, 0, NULL);
+                i = 0; /* the callback may have changed the queue */
+            } else {
+                i++;
+            }
+        }
+    }
+
+private:
+    enum RequestType_t {
+        REQUEST_READ,
+        REQUEST_WRITE_REQ,
+        REQUEST_WRITE_CMD,
+        REQUEST_READ_MULTIPLE,
+        REQUEST_READ_MULTIPLE_VARIABLE
+    };
+
+    struct QueuedRequest_t {
+        Gap::Handle_t            connHandle;
+        GattAttribute::Handle_t  handle;
+        uint8_t                  type;       /* RequestType_t */
+        bool                     inProgress; /* issued, awaiting the response */
+        uint16_t                 offset;
+        uint16_t                 length;     /* for Read Multiple, the number of handles */
+        const uint8_t           *value;      /* for Read Multiple, the handles */
+        RequestCallback_t        callback;
+        void                    *context;
+    };
+
+    ble_error_t queueRequest(RequestType_t            type,
+                             Gap::Handle_t            connHandle,
+                             GattAttribute::Handle_t  attributeHandle,
+                             uint16_t                 offset,
+                             uint16_t                 length,
+                             const uint8_t           *value,
+                             RequestCallback_t        callback,
+                             void                    *context) {
+        if (requestCount >= BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS) {
+            return BLE_ERROR_NO_MEM;
+        }
+
+        QueuedRequest_t &request = requests[requestCount++];
+        request.connHandle = connHandle;
+        request.handle     = attributeHandle;
+        request.type       = type;
+        request.inProgress = false;
+        request.offset     = offset;
+        request.length     = length;
+        request.value      = value;
+        request.callback   = callback;
+        request.context    = context;
+
+        issueRequests(connHandle);
+        return BLE_ERROR_NONE;
+    }
+
+    /**
+     * Send whatever a connection's queue allows: requests up to and
+     * including the first which awaits a response, and any write commands
+     * which follow it without a request in between. Requests the stack
+     * rejects are completed with its error; if it is out of buffers, sending
+     * resumes with the next response or data-sent event.
+     */
+    void issueRequests(Gap::Handle_t connHandle) {
+        bool awaitingResponse = false;
+        for (unsigned i = 0; i < requestCount; i++) {
+            QueuedRequest_t &request = requests[i];
+            if (request.connHandle != connHandle) {
+                continue;
+            }
+            if (request.inProgress) {
+                awaitingResponse = true;
+                continue;
+            }
+            if (awaitingResponse && (request.type != REQUEST_WRITE_CMD)) {
+                return;
+            }
+
+            ble_error_t error;
+            switch (request.type) {
+                case REQUEST_READ:
+                    error = read(connHandle, request.handle, request.offset);
+                    break;
+                case REQUEST_WRITE_REQ:
+                    error = write(GATT_OP_WRITE_REQ, connHandle, request.handle, request.length, request.value);
+                    break;
+                case REQUEST_READ_MULTIPLE:
+                case REQUEST_READ_MULTIPLE_VARIABLE:
+                    error = readMultiple(connHandle, reinterpret_cast<const GattAttribute::Handle_t *>(request.value),
+                                         (uint8_t)request.length, (request.type == REQUEST_READ_MULTIPLE_VARIABLE));
+                    break;
+                default:
+                    error = write(GATT_OP_WRITE_CMD, connHandle, request.handle, request.length, request.value);
+                    break;
+            }
+
+            if ((error == BLE_STACK_BUSY) || (error == BLE_ERROR_NO_MEM)) {
+                return;
+            }
+            if ((error == BLE_ERROR_NONE) && (request.type != REQUEST_WRITE_CMD)) {
+                request.inProgress = true;
+                awaitingResponse   = true;
+                continue;
+            }
+
+            /* Sent write commands and failed requests are done; the callback may have changed the queue. */
+            completeRequest(i, error, (error == BLE_ERROR_NONE) ? request.length : 0, NULL);
+            i                = (unsigned)-1;
+            awaitingResponse = false;
+        }
+    }
+
+    /* Responses to Read Multiple don't identify the attributes, and both kinds of request are matched by REQUEST_READ_MULTIPLE. */
+    int findRequestInProgress(Gap::Handle_t connHandle, RequestType_t type, GattAttribute::Handle_t attributeHandle) const {
+        for (unsigned i = 0; i < requestCount; i++) {
+            if ((requests[i].connHandle == connHandle) && requests[i].inProgress) {
+                if (type == REQUEST_READ_MULTIPLE) {
+                    return ((requests[i].type == REQUEST_READ_MULTIPLE) || (requests[i].type == REQUEST_READ_MULTIPLE_VARIABLE)) ? (int)i : -1;
+                }
+                return ((requests[i].type == type) && (requests[i].handle == attributeHandle)) ? (int)i : -1;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Remove a request from the queue, then report its outcome; the
+     * callback is free to queue further requests.
+     */
+    void completeRequest(unsigned                 index,
+                         ble_error_t              status,
+                         uint16_t                 len,
+                         const uint8_t           *data,
+                         GattAuthCallbackReply_t  attError = AUTH_CALLBACK_REPLY_SUCCESS) {
+        const QueuedRequest_t &request = requests[index];
+
+        RequestResult_t result;
+        result.connHandle = request.connHandle;
+        result.handle     = request.handle;
+        result.offset     = request.offset;
+        result.status     = status;
+        result.len        = len;
+        result.data       = data;
+        result.context    = request.context;
+        result.attError   = attError;
+        RequestCallback_t callback = request.callback;
+
+        for (unsigned i = index + 1; i < requestCount; i++) {
+            requests[i - 1] = requests[i];
+        }
+        requestCount--;
+
+        if (callback) {
+            callback(&result);
+        }
+    }
+
+    struct HVXSubscription_t {
+        HVXCallback_t  callback;
+        GattHVXBuffer *buffer;
+    };
+
+    static uint32_t makeSubscriptionKey(Gap::Handle_t connHandle, GattAttribute::Handle_t valueHandle) {
+        return ((uint32_t)connHandle << 16) | valueHandle;
+    }
+
+    /* The position of a key in the table, or where it would go. */
+    unsigned findSubscriptionIndex(uint32_t key) const {
+        unsigned low  = 0;
+        unsigned high = subscriptionCount;
+        while (low < high) {
+            unsigned middle = (low + high) / 2;
+            if (subscriptionKeys[middle] < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    void removeSubscription(unsigned index) {
+        for (unsigned i = index + 1; i < subscriptionCount; i++) {
+            subscriptionKeys[i - 1] = subscriptionKeys[i];
+            subscriptions[i - 1]    = subscriptions[i];
+        }
+        subscriptionCount--;
+    }
+
 protected:
     ReadCallback_t  onDataReadCallback;
     WriteCallback_t onDataWriteCallback;
     HVXCallback_t   onHVXCallback;
 
+private:
+    const Gap      *gap;
+
+    uint8_t         requestCount;
+    QueuedRequest_t requests[BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS]; /* in order of arrival */
+
+    /* Keys, (connection << 16) | attribute, are kept apart from the subscriptions and in order, for the search. */
+    uint8_t           subscriptionCount;
+    uint32_t          subscriptionKeys[BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS];
+    HVXSubscription_t subscriptions[BLE_GATT_CLIENT_MAX_HVX_SUBSCRIPTIONS];
+
 private:
     /* disallow copy and assignment */
     GattClient(const GattClient &);
@@ -0,0 +1,285 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_DISCOVERY_ENGINE_H__
+#define __GATT_DISCOVERY_ENGINE_H__
+
+#include "Gap.h"
+#include "UUID.h"
+#include "UUIDSet.h"
+#include "GattAttribute.h"
+#include "ServiceDiscovery.h"
+#include "DiscoveredService.h"
+#include "DiscoveredCharacteristic.h"
+#include "DiscoveredDescriptor.h"
+
+/* The following limits may be overridden from the build configuration. */
+#ifndef BLE_GATT_DISCOVERY_MAX_CONTEXTS
+#define BLE_GATT_DISCOVERY_MAX_CONTEXTS         4 /**< Connections on which discovery can run at the same time. */
+#endif
+#ifndef BLE_GATT_DISCOVERY_MAX_PENDING_SERVICES
+#define BLE_GATT_DISCOVERY_MAX_PENDING_SERVICES 8 /**< Matching services held per connection until their characteristics are discovered. */
+#endif
+
+class GattClient;
+
+/**
+ * Service discovery over the attribute protocol, for ports which implement
+ * the GATT client on the host. It runs the GATT procedures Discover All
+ * Primary Services and Discover All Characteristics of a Service, with
+ * Read By Group Type and Read By Type Requests encoded by AttPdu.
+ *
+ * Unlike ServiceDiscovery, which describes a single discovery, the engine
+ * keeps a context for each connection being discovered, taken from a fixed
+ * pool of BLE_GATT_DISCOVERY_MAX_CONTEXTS. Discoveries on different
+ * connections proceed side by side, each with its own filters, callbacks
+ * and termination callback, so the time to discover N peers is that of the
+ * slowest rather than the sum.
+ *
+ * A port derives from the engine to provide sendRequest(), forwards
+ * GattClient::launchServiceDiscovery() and its companions to it, and hands
+ * it the responses to its requests through processResponse(). The engine
+ * has at most one request outstanding per connection; a port which issues
+ * other requests on the same bearer must hold them back until the response
+ * has arrived, as ATT requires.
+ *
+ * Results are reported in handle order: each matching service, followed by
+ * its matching characteristics. As documented for launchServiceDiscovery(),
+ * services are reported only if the characteristic filter is a wildcard.
+ * Filters are held as UUIDSets, a single UUID being a set of one, and the
+ * engine notes which members have been found: once they all have, it stops
+ * searching for services, and if neither filter is a wildcard, it stops
+ * altogether.
+ *
+ * The engine also discovers descriptors, with Find Information Requests; a
+ * descriptor discovery occupies the connection's context just as service
+ * discovery does. Over the range of a service, a single sweep finds the
+ * descriptors of every characteristic: each response lists as many
+ * attributes as fit in ATT_MTU, and the characteristic declarations among
+ * them tell which characteristic the descriptors that follow belong to.
+ */
+class GattDiscoveryEngine {
+public:
+    static const unsigned MAX_CONTEXTS         = BLE_GATT_DISCOVERY_MAX_CONTEXTS;
+    static const unsigned MAX_PENDING_SERVICES = BLE_GATT_DISCOVERY_MAX_PENDING_SERVICES;
+
+public:
+    /**
+     * @param[ref] client
+     *               The GattClient through which discovered characteristics
+     *               are to be read and written.
+     */
+    GattDiscoveryEngine(GattClient &client);
+
+    /**
+     * Start discovery on a connection. The parameters are those of
+     * GattClient::launchServiceDiscovery().
+     *
+     * @return BLE_STACK_BUSY if discovery is already running on the
+     *         connection; BLE_ERROR_NO_MEM if every context is in use;
+     *         otherwise the error from sendRequest().
+     */
+    ble_error_t launch(Gap::Handle_t                               connectionHandle,
+                       ServiceDiscovery::ServiceCallback_t         sc,
+                       ServiceDiscovery::CharacteristicCallback_t  cc,
+                       const UUID                                 &matchingServiceUUID,
+                       const UUID                                 &matchingCharacteristicUUID,
+                       ServiceDiscovery::TerminationCallback_t     tc);
+
+    /**
+     * Start discovery for sets of services and characteristics. The sets
+     * refer to the caller's UUIDs, which must remain valid until the
+     * discovery terminates.
+     *
+     * @return as for the single-UUID variant, or BLE_ERROR_INVALID_PARAM if
+     *         either set is truncated.
+     */
+    ble_error_t launch(Gap::Handle_t                               connectionHandle,
+                       ServiceDiscovery::ServiceCallback_t         sc,
+                       ServiceDiscovery::CharacteristicCallback_t  cc,
+                       const UUIDSet                              &matchingServiceUUIDs,
+                       const UUIDSet                              &matchingCharacteristicUUIDs,
+                       ServiceDiscovery::TerminationCallback_t     tc);
+
+    /**
+     * Start discovery of the descriptors of a characteristic, as for
+     * GattClient::discoverCharacteristicDescriptors(). The search ends at the
+     * next declaration.
+     *
+     * @return as for launch().
+     */
+    ble_error_t launchDescriptorDiscovery(const DiscoveredCharacteristic          &characteristic,
+                                          ServiceDiscovery::DescriptorCallback_t   callback,
+                                          const UUID                              &matchingUUID,
+                                          ServiceDiscovery::TerminationCallback_t  tc);
+
+    /**
+     * Start discovery of the descriptors in a range of handles, as for
+     * GattClient::discoverDescriptors().
+     *
+     * @return as for launch().
+     */
+    ble_error_t launchDescriptorDiscovery(Gap::Handle_t                            connectionHandle,
+                                          GattAttribute::Handle_t                  startHandle,
+                                          GattAttribute::Handle_t                  endHandle,
+                                          ServiceDiscovery::DescriptorCallback_t   callback,
+                                          const UUID                              &matchingUUID,
+                                          ServiceDiscovery::TerminationCallback_t  tc);
+
+    /**
+     * Is discovery running on any connection?
+     */
+    bool isActive(void) const;
+
+    /**
+     * Is discovery running on a connection?
+     */
+    bool isActive(Gap::Handle_t connectionHandle) const;
+
+    /**
+     * Stop discovery on all connections.
+     */
+    void terminate(void);
+
+    /**
+     * Stop discovery on a connection, invoking its termination callback.
+     */
+    void terminate(Gap::Handle_t connectionHandle);
+
+    /**
+     * Set the termination callback for discoveries launched without one.
+     */
+    void onTermination(ServiceDiscovery::TerminationCallback_t callback) {
+        defaultTerminationCallback = callback;
+    }
+
+    /**
+     * Drop all contexts without invoking callbacks, e.g. on shutdown.
+     */
+    void reset(void);
+
+    /* Entry points for the port. */
+public:
+    /**
+     * Deliver a response (or Error Response) received on a connection.
+     *
+     * @return true if the response was to a request of the engine.
+     */
+    bool processResponse(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length);
+
+    /**
+     * End discovery on a terminated connection, invoking its termination
+     * callback.
+     */
+    void processDisconnection(Gap::Handle_t connectionHandle);
+
+protected:
+    /**
+     * Send a request PDU to the peer; the port is expected to deliver the
+     * response to processResponse().
+     */
+    virtual ble_error_t sendRequest(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length) = 0;
+
+private:
+    struct PendingService_t {
+        GattAttribute::Handle_t startHandle;
+        GattAttribute::Handle_t endHandle;
+        UUID                    uuid;
+    };
+
+    /*
+     * A context is in use while its discovery is active, and after it ends
+     * until the response to its last request has arrived; discovery can be
+     * relaunched in the meantime, and continues once the stale response has
+     * been discarded.
+     */
+    struct Context_t {
+        bool                                       active;
+        bool                                       awaitingResponse;
+        bool                                       discardResponse;
+        uint8_t                                    requestOpcode;              /* of the request outstanding */
+        Gap::Handle_t                              connHandle;
+        ServiceDiscovery::ServiceCallback_t        serviceCallback;
+        ServiceDiscovery::CharacteristicCallback_t characteristicCallback;
+        ServiceDiscovery::TerminationCallback_t    terminationCallback;
+        UUID                                       matchingServiceUUID;        /* the filters of a single-UUID launch, to which the sets refer */
+        UUID                                       matchingCharacteristicUUID;
+        UUIDSet                                    serviceFilter;
+        UUIDSet                                    characteristicFilter;
+        uint32_t                                   servicesFound;              /* members of the filters found so far */
+        uint32_t                                   characteristicsFound;
+        bool                                       servicesDone;               /* the search for services has reached the end of the table */
+        GattAttribute::Handle_t                    serviceSearchHandle;        /* where the next search for services starts */
+        uint8_t                                    serviceCount;               /* matching services held for characteristic discovery */
+        uint8_t                                    serviceIndex;               /* the one being searched */
+        bool                                       serviceStarted;             /* it has been reported */
+        GattAttribute::Handle_t                    characteristicSearchHandle; /* 0 once the service has been searched */
+        PendingService_t                           services[MAX_PENDING_SERVICES];
+        bool                                       descriptors;                /* a descriptor discovery; the fields below apply */
+        bool                                       singleCharacteristic;       /* it ends at the next declaration */
+        ServiceDiscovery::DescriptorCallback_t     descriptorCallback;
+        UUID                                       matchingDescriptorUUID;
+        GattAttribute::Handle_t                    descriptorSearchHandle;     /* 0 once the range has been searched */
+        GattAttribute::Handle_t                    descriptorEndHandle;
+        GattAttribute::Handle_t                    descriptorOwner;            /* value handle of the characteristic at hand */
+    };
+
+    /* DiscoveredCharacteristic keeps its fields to itself; this fills them in. */
+    class EngineCharacteristic : public DiscoveredCharacteristic {
+    public:
+        void setup(GattClient              *gattcIn,
+                   Gap::Handle_t            connHandleIn,
+                   const UUID              &uuidIn,
+                   uint8_t                  propertiesIn,
+                   GattAttribute::Handle_t  declHandleIn,
+                   GattAttribute::Handle_t  valueHandleIn);
+    };
+
+    Context_t       *findContext(Gap::Handle_t connectionHandle);
+    const Context_t *findContext(Gap::Handle_t connectionHandle) const;
+
+    Context_t  *allocateContext(Gap::Handle_t connectionHandle, ble_error_t *errorP);
+    ble_error_t start(Context_t &context);
+    ble_error_t startServiceDiscovery(Context_t                                  &context,
+                                      ServiceDiscovery::ServiceCallback_t         sc,
+                                      ServiceDiscovery::CharacteristicCallback_t  cc,
+                                      const UUIDSet                              &matchingServiceUUIDs,
+                                      const UUIDSet                              &matchingCharacteristicUUIDs,
+                                      ServiceDiscovery::TerminationCallback_t     tc);
+
+    void        processServices(Context_t &context, const uint8_t *pdu, uint16_t length);
+    void        processCharacteristics(Context_t &context, const uint8_t *pdu, uint16_t length);
+    void        processDescriptors(Context_t &context, const uint8_t *pdu, uint16_t length);
+    void        advance(Context_t &context);
+    ble_error_t send(Context_t &context, const uint8_t *pdu, uint16_t length);
+    void        finish(Context_t &context);
+
+    static bool isRunning(const Context_t &context) {
+        return context.active && !context.awaitingResponse;
+    }
+
+private:
+    GattClient                              &client;
+    ServiceDiscovery::TerminationCallback_t  defaultTerminationCallback;
+    Context_t                                contexts[MAX_CONTEXTS];
+
+private:
+    /* disallow copy and assignment */
+    GattDiscoveryEngine(const GattDiscoveryEngine &);
+    GattDiscoveryEngine& operator=(const GattDiscoveryEngine &);
+};
+
+#endif // ifndef __GATT_DISCOVERY_ENGINE_H__
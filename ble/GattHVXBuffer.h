@@ -0,0 +1,124 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_HVX_BUFFER_H__
+#define __GATT_HVX_BUFFER_H__
+
+#include <stdint.h>
+
+/**
+ * A ring buffer of notified or indicated values, for a high-rate stream
+ * which the application drains in batches rather than handling value by
+ * value; see GattClient::onHVX(Gap::Handle_t, GattAttribute::Handle_t, ...).
+ *
+ * Values are stored back to back, each preceded by its length, and are
+ * never split across the end of the storage, so each can be read in place.
+ * A value which doesn't fit is dropped and counted. The buffer is filled
+ * from the BLE event context and drained from the application; with one
+ * writer and one reader it needs no locking.
+ *
+ * The storage is supplied by the owner; see StaticGattHVXBuffer for a
+ * self-contained variant.
+ *
+ * @section EXAMPLE
+ *
+ * @code
+ *
+ * const uint8_t *value;
+ * uint16_t       length;
+ * while (buffer.front(&value, &length)) {
+ *     process(value, length);
+ *     buffer.pop();
+ * }
+ *
+ * @endcode
+ */
+class GattHVXBuffer {
+public:
+    /**
+     * @param[in] storage
+     *              Memory for the values and their lengths; owned by the caller.
+     * @param[in] size
+     *              The size of storage in bytes.
+     */
+    GattHVXBuffer(uint8_t *storage, uint16_t size);
+
+    /**
+     * Append a value.
+     *
+     * @return false if there isn't room for it, in which case it is dropped.
+     */
+    bool push(const uint8_t *data, uint16_t length);
+
+    /**
+     * The oldest value, which remains valid until it is popped.
+     *
+     * @return false if the buffer is empty.
+     */
+    bool front(const uint8_t **dataP, uint16_t *lengthP) const;
+
+    /**
+     * Drop the oldest value.
+     */
+    void pop(void);
+
+    /**
+     * Drop all values. Only the reader may call this.
+     */
+    void clear(void) {
+        tail = head;
+    }
+
+    bool     isEmpty(void)         const {return head == tail; }
+    uint16_t getSize(void)         const {return size;         }
+    uint32_t getDroppedCount(void) const {return droppedCount; } /**< Values which didn't fit. */
+
+private:
+    static const uint16_t LENGTH_SIZE  = 2;
+    static const uint16_t WRAP_MARKER  = 0xFFFF; /* in place of a length: the next value is at the start */
+
+    uint16_t readLength(uint16_t offset) const;
+    void     writeLength(uint16_t offset, uint16_t length);
+    uint16_t getFrontOffset(void) const;
+
+private:
+    uint8_t           *storage;
+    uint16_t           size;
+    volatile uint16_t  head;         /* where the next value goes; written by push() only */
+    volatile uint16_t  tail;         /* where the oldest value is; written by pop() and clear() only */
+    uint32_t           droppedCount;
+
+private:
+    /* disallow copy and assignment */
+    GattHVXBuffer(const GattHVXBuffer &);
+    GattHVXBuffer& operator=(const GattHVXBuffer &);
+};
+
+/**
+ * A GattHVXBuffer carrying its own storage of SIZE bytes.
+ */
+template <uint16_t SIZE>
+class StaticGattHVXBuffer : public GattHVXBuffer {
+public:
+    StaticGattHVXBuffer() : GattHVXBuffer(storage, SIZE) {
+        /* empty */
+    }
+
+private:
+    uint8_t storage[SIZE];
+};
+
+#endif // ifndef __GATT_HVX_BUFFER_H__
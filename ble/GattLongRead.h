@@ -0,0 +1,144 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_LONG_READ_H__
+#define __GATT_LONG_READ_H__
+
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattClient.h"
+
+#ifndef BLE_GATT_LONG_READ_WINDOW
+#define BLE_GATT_LONG_READ_WINDOW 4 /**< Read Blob Requests held in the request queue ahead of the responses. */
+#endif
+
+#if BLE_GATT_LONG_READ_WINDOW > BLE_GATT_CLIENT_MAX_QUEUED_REQUESTS
+#error "the window of a long read must fit in the GattClient request queue"
+#endif
+
+class BLE;
+
+/**
+ * Client side reading of a value longer than a single response (ATT_MTU - 1
+ * bytes), completed by a single callback with the whole value.
+ *
+ * The value is read from the start with a Read Request. Should the response
+ * be full, the rest is read with Read Blob Requests at increasing offsets;
+ * up to BLE_GATT_LONG_READ_WINDOW of them are kept in the GattClient request
+ * queue, so that each goes out as soon as the response to the previous one
+ * arrives. The first response shorter than ATT_MTU - 1 bytes ends the value,
+ * as does an Invalid Offset or Attribute Not Long error at the end of what
+ * has been received, and whatever is still queued is withdrawn. Values up to the capacity of
+ * the buffer are reassembled there; a longer value fails the read with
+ * BLE_ERROR_BUFFER_OVERFLOW, leaving the first part in the buffer.
+ *
+ * A read takes one attribute on one connection at a time; reading several
+ * at once takes a GattLongRead each.
+ */
+class GattLongRead {
+public:
+    typedef void (*CompletionCallback_t)(GattLongRead *read);
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     * @param[in] buffer
+     *              Where values are reassembled; it must outlive the
+     *              GattLongRead.
+     * @param[in] capacity
+     *              The size of the buffer, which is the longest value that
+     *              can be read.
+     */
+    GattLongRead(BLE &ble, uint8_t *buffer, uint16_t capacity);
+
+    /**
+     * Read a value.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] attributeHandle
+     *              Handle of the attribute on the remote GATT server.
+     * @param[in] callback
+     *              Invoked once the whole value has been read, or the read
+     *              has failed. It may be invoked before this returns if the
+     *              first request can't be issued.
+     *
+     * @return BLE_STACK_BUSY if a read is in progress, or
+     *         BLE_ERROR_NO_MEM if the request queue is full;
+     *         BLE_ERROR_NONE otherwise.
+     */
+    ble_error_t read(Gap::Handle_t           connHandle,
+                     GattAttribute::Handle_t attributeHandle,
+                     CompletionCallback_t    callback);
+
+    bool isActive(void) const {return active;}
+
+    /* Results of the current (or last) read. */
+    Gap::Handle_t           getConnectionHandle(void) const {return connHandle;}
+    GattAttribute::Handle_t getHandle(void)           const {return handle;    }
+    ble_error_t             getStatus(void)           const {return status;    }
+    uint16_t                getLength(void)           const {return length;    }
+    const uint8_t          *getValue(void)            const {return buffer;    }
+
+    /**
+     * The number of responses taken by the last read.
+     */
+    uint8_t                 getRoundTrips(void)       const {return roundTrips;}
+
+protected:
+    static void onRead(const GattClient::RequestResult_t *result);
+
+private:
+    void fillWindow(void);
+    void finish(ble_error_t status);
+
+private:
+    BLE                     &ble;
+    uint8_t                 *buffer;
+    uint16_t                 capacity;
+
+    Gap::Handle_t            connHandle;
+    GattAttribute::Handle_t  handle;
+    CompletionCallback_t     completionCallback;
+    bool                     active;
+    ble_error_t              status;
+    uint16_t                 length;         /* bytes received, which are also the offset of the next response */
+    uint32_t                 nextOffset;     /* of the next request to queue */
+    uint8_t                  outstanding;    /* requests queued, the one in progress included */
+    uint8_t                  roundTrips;
+
+private:
+    /* disallow copy and assignment */
+    GattLongRead(const GattLongRead &);
+    GattLongRead& operator=(const GattLongRead &);
+};
+
+/**
+ * A GattLongRead carrying its own buffer of SIZE bytes.
+ */
+template <uint16_t SIZE>
+class StaticGattLongRead : public GattLongRead {
+public:
+    StaticGattLongRead(BLE &ble) : GattLongRead(ble, storage, SIZE) {
+        /* empty */
+    }
+
+private:
+    uint8_t storage[SIZE];
+};
+
+#endif // ifndef __GATT_LONG_READ_H__
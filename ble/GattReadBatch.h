@@ -0,0 +1,145 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_READ_BATCH_H__
+#define __GATT_READ_BATCH_H__
+
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattClient.h"
+
+#ifndef BLE_GATT_READ_BATCH_MAX_HANDLES
+#define BLE_GATT_READ_BATCH_MAX_HANDLES 16  /**< Attributes read by one batch. */
+#endif
+#ifndef BLE_GATT_READ_BATCH_ARENA_SIZE
+#define BLE_GATT_READ_BATCH_ARENA_SIZE  256 /**< Bytes of values held by one batch. */
+#endif
+
+class BLE;
+
+/**
+ * Client side reading of a set of attribute values, completed by a single
+ * callback, in as few round trips as the port and the peer allow.
+ *
+ * Where the sizes of the values are known (as for most sensor readings), a
+ * single Read Multiple Request fetches them all; otherwise a Read Multiple
+ * Variable Request does. Values which don't fit in the response, and all of
+ * them if the peer rejects the request, are then read one by one through the
+ * GattClient request queue, back to back. Values are copied into the batch,
+ * where they remain until the next read().
+ *
+ * A batch reads from one connection at a time; polling several peers at
+ * once takes a batch per connection.
+ */
+class GattReadBatch {
+public:
+    static const unsigned MAX_HANDLES = BLE_GATT_READ_BATCH_MAX_HANDLES;
+    static const unsigned ARENA_SIZE  = BLE_GATT_READ_BATCH_ARENA_SIZE;
+
+    typedef void (*CompletionCallback_t)(GattReadBatch *batch);
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     */
+    GattReadBatch(BLE &ble);
+
+    /**
+     * Read a set of attributes.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] handles
+     *              The attributes to read; the array is copied.
+     * @param[in] count
+     *              The number of handles, up to MAX_HANDLES.
+     * @param[in] callback
+     *              Invoked once all values have been read, or have failed.
+     * @param[in] lengths
+     *              The size of each value, if known; this allows the use of
+     *              Read Multiple, which peers support more widely than Read
+     *              Multiple Variable. NULL if the sizes aren't known.
+     *
+     * @return BLE_STACK_BUSY if a read is in progress,
+     *         BLE_ERROR_INVALID_PARAM if count is 0 or above MAX_HANDLES, or
+     *         BLE_ERROR_NO_MEM if the request queue is full;
+     *         BLE_ERROR_NONE otherwise.
+     */
+    ble_error_t read(Gap::Handle_t                  connHandle,
+                     const GattAttribute::Handle_t *handles,
+                     uint8_t                        count,
+                     CompletionCallback_t           callback,
+                     const uint16_t                *lengths = NULL);
+
+    bool isActive(void) const {return pending != 0;}
+
+    /* Results of the current (or last) read, in the order of the handles. */
+    Gap::Handle_t           getConnectionHandle(void)  const {return connHandle;             }
+    uint8_t                 getCount(void)             const {return count;                  }
+    GattAttribute::Handle_t getHandle(unsigned index)  const {return handles[index];         }
+    ble_error_t             getStatus(unsigned index)  const {return results[index].status;  }
+    uint16_t                getLength(unsigned index)  const {return results[index].length;  }
+    const uint8_t          *getValue(unsigned index)   const {return &arena[results[index].arenaOffset];}
+
+    /**
+     * The number of round trips taken by the last read; a measure of how
+     * well the peer supports batching.
+     */
+    uint8_t                 getRoundTrips(void)        const {return roundTrips;             }
+
+protected:
+    static void onReadMultiple(const GattClient::RequestResult_t *result);
+    static void onRead(const GattClient::RequestResult_t *result);
+
+private:
+    struct Result_t {
+        ble_error_t status;       /* BLE_STACK_BUSY until the value is read */
+        uint16_t    length;
+        uint16_t    arenaOffset;
+    };
+
+    bool        parseFixed(const uint8_t *data, uint16_t len);
+    void        parseVariable(const uint8_t *data, uint16_t len);
+    void        store(unsigned index, ble_error_t status, const uint8_t *value, uint16_t length);
+    void        readRemaining(void);
+    void        finishIfDone(void);
+
+private:
+    BLE                     &ble;
+
+    Gap::Handle_t            connHandle;
+    CompletionCallback_t     completionCallback;
+    uint8_t                  count;
+    uint8_t                  pending;     /* values not yet read */
+    uint8_t                  roundTrips;
+    uint8_t                  multipleCount; /* values requested with Read Multiple */
+    bool                     fixedLengths;
+    bool                     issuing;       /* completion is held back while requests are being queued */
+    GattAttribute::Handle_t  handles[MAX_HANDLES];
+    uint16_t                 lengths[MAX_HANDLES];
+    Result_t                 results[MAX_HANDLES];
+
+    uint16_t                 arenaUsed;
+    uint8_t                  arena[ARENA_SIZE];
+
+private:
+    /* disallow copy and assignment */
+    GattReadBatch(const GattReadBatch &);
+    GattReadBatch& operator=(const GattReadBatch &);
+};
+
+#endif // ifndef __GATT_READ_BATCH_H__
@@ -19,11 +19,23 @@
 
 #include "Gap.h"
 #include "GattService.h"
+#include "GattServiceDefinition.h"
 #include "GattAttribute.h"
 #include "GattServerEvents.h"
 #include "GattCallbackParamTypes.h"
+#include "PreparedWriteQueue.h"
 #include "CallChainOfFunctionPointersWithContext.h"
 
+#ifndef BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS
+#define BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS 8 /**< Characteristics for which subscribers are tracked at any one time. */
+#endif
+#ifndef BLE_GATT_SERVER_MAX_RECEIVE_BUFFERS
+#define BLE_GATT_SERVER_MAX_RECEIVE_BUFFERS 2 /**< Number of application-owned receive buffers which can be registered. */
+#endif
+#if BLE_GAP_MAX_CONNECTIONS > 32
+#error "subscriber bitsets hold at most 32 connections"
+#endif
+
 class GattServer {
 public:
     /* Event callback handlers. */
@@ -34,12 +46,22 @@ protected:
     GattServer() :
         serviceCount(0),
         characteristicCount(0),
+        preparedWriteQueue(NULL),
+        subscriberSlotsInUse(0),
+        subscriberConnections(),
+        subscriptions(),
+        receiveBuffers(),
         dataSentCallChain(),
         dataWrittenCallChain(),
         dataReadCallChain(),
         updatesEnabledCallback(NULL),
         updatesDisabledCallback(NULL),
-        confirmationReceivedCallback(NULL) {
+        confirmationReceivedCallback(NULL),
+        confirmationReceivedCallChain(),
+        subscriptionCallChain(),
+        txCredits(0),
+        maxTxCredits(0),
+        txCreditsReleasedCallChain() {
         /* empty */
     }
 
@@ -51,6 +73,9 @@ public:
     /**
      * Add a service declaration to the local server ATT table. Also add the
      * characteristics contained within.
+     *
+     * @Note: ports which maintain the attribute table in software may use
+     * GattAttributeDatabase as the backing store.
      */
     virtual ble_error_t addService(GattService &service) {
         /* avoid compiler warnings about unused variables */
@@ -59,6 +84,25 @@ public:
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Add a service described by a constant table (see GattServiceDefinition.h).
+     * Nothing is constructed in RAM for the service; the application refers
+     * to its characteristics by value handle.
+     *
+     * @param[in]  definition
+     *               The service, typically a 'static const' table in flash.
+     * @param[out] valueHandles
+     *               Receives the value handle of each characteristic, in the
+     *               order of the definition; may be NULL.
+     */
+    virtual ble_error_t addService(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles) {
+        /* avoid compiler warnings about unused variables */
+        (void)definition;
+        (void)valueHandles;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
     /**
      * Read the value of a characteristic from the local GattServer
      * @param[in]     attributeHandle
@@ -175,6 +219,28 @@ public:
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Send the value of a characteristic to one connection, as a notification
+     * or an indication according to its subscription, without updating the
+     * value held locally. notifyAll() uses this once it has updated the value.
+     *
+     * @Note: by default this goes through write(connectionHandle, ...), which
+     * stores the value again; ports override it where the stack can send an
+     * update on its own.
+     *
+     * @param[in] connectionHandle
+     *              Connection Handle.
+     * @param[in] attributeHandle
+     *              Handle for the value attribute of the Characteristic.
+     * @param[in] value
+     *              The value to send; shared by all the links it is sent to.
+     * @param[in] size
+     *              Size of the value (in bytes).
+     */
+    virtual ble_error_t sendUpdate(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size) {
+        return write(connectionHandle, attributeHandle, value, size);
+    }
+
     /**
      * Determine the updates-enabled status (notification/indication) for the current connection from a characteristic's CCCD.
      *
@@ -215,6 +281,41 @@ public:
         return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
     }
 
+    /**
+     * Look up the longest value an attribute can take, e.g. to validate a
+     * long write before applying it.
+     *
+     * @param[in]  attributeHandle
+     *               Handle of the attribute.
+     * @param[out] maxLengthP
+     *               The maximum length of its value.
+     *
+     * @return BLE_ERROR_INVALID_PARAM if there is no such attribute.
+     */
+    virtual ble_error_t getMaxLength(GattAttribute::Handle_t attributeHandle, uint16_t *maxLengthP) {
+        /* avoid compiler warnings about unused variables */
+        (void)attributeHandle;
+        (void)maxLengthP;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
+    /**
+     * Compute the Database Hash over the local attribute table, as served by
+     * the Database Hash characteristic (see GenericAttributeService). Clients
+     * which cache the table compare it with the hash they saw last, and skip
+     * discovery if it hasn't changed.
+     *
+     * @param[out] hash
+     *               The 128-bit hash, in over-the-air (little-endian) order.
+     */
+    virtual ble_error_t getDatabaseHash(uint8_t hash[16]) {
+        /* avoid compiler warnings about unused variables */
+        (void)hash;
+
+        return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+    }
+
     /**
      * A virtual function to allow underlying stacks to indicate if they support
      * onDataRead(). It should be overridden to return true as applicable.
@@ -227,6 +328,102 @@ public:
      * APIs with non-virtual implementations.
      */
 public:
+    /**
+     * Update the value of a characteristic, honouring its update suppression
+     * setting (see GattCharacteristic::suppressIdenticalUpdates()). An update
+     * which would not change the value meaningfully is dropped without
+     * involving the stack, so no notification or indication is sent.
+     *
+     * @return BLE_ERROR_NONE if the value was written or the update was
+     *         suppressed; else the error from write(attributeHandle, ...).
+     *
+     * @Note: ports overriding write() hide this overload; call it through
+     * a GattServer reference, e.g. BLE::gattServer().
+     */
+    ble_error_t write(const GattCharacteristic &characteristic, const uint8_t *value, uint16_t size, bool localOnly = false) {
+        if (isRedundantUpdate(characteristic, value, size)) {
+            return BLE_ERROR_NONE;
+        }
+
+        return write(characteristic.getValueHandle(), value, size, localOnly);
+    }
+
+    /**
+     * Determine whether an update to a characteristic would be suppressed,
+     * by comparing it with the value currently held by the server. Updates
+     * are never suppressed if the current value can't be read back.
+     */
+    bool isRedundantUpdate(const GattCharacteristic &characteristic, const uint8_t *value, uint16_t size) {
+        if (characteristic.getUpdateSuppression() == GattCharacteristic::SUPPRESS_NONE) {
+            return false;
+        }
+
+        uint8_t  current[BLE_GATT_MTU_SIZE_MAX - 3];
+        uint16_t currentLen = sizeof(current);
+        if ((size > sizeof(current)) ||
+            (read(characteristic.getValueHandle(), current, &currentLen) != BLE_ERROR_NONE) ||
+            (currentLen > sizeof(current))) {
+            return false;
+        }
+
+        return characteristic.isRedundantUpdate(current, currentLen, value, size);
+    }
+
+    /**
+     * Update the value of a characteristic and send it to every connection
+     * which has subscribed to it (through the CCCD), in one call. The value
+     * is stored once; then only subscribed links are visited, and the update
+     * sent to each through sendUpdate() shares the caller's buffer.
+     *
+     * @Note: subscriptions are tracked for ports which report CCCD writes
+     * through handleSubscriptionEvent().
+     *
+     * @return BLE_ERROR_NONE if the value went out to all subscribers; else
+     *         the error from storing the value, or the first error returned
+     *         by sendUpdate(), in which case the remaining subscribers were
+     *         still attempted.
+     */
+    ble_error_t notifyAll(GattAttribute::Handle_t valueHandle, const uint8_t *value, uint16_t size) {
+        ble_error_t result = write(valueHandle, value, size, true /* localOnly */);
+        const Subscription_t *subscription = findSubscription(valueHandle);
+        if ((result != BLE_ERROR_NONE) || (subscription == NULL)) {
+            return result;
+        }
+
+        uint32_t subscribers = subscription->subscribers;
+        for (unsigned slot = 0; subscribers != 0; slot++, subscribers >>= 1) {
+            if (subscribers & 1) {
+                ble_error_t error = sendUpdate(subscriberConnections[slot], valueHandle, value, size);
+                if ((error != BLE_ERROR_NONE) && (result == BLE_ERROR_NONE)) {
+                    result = error;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * Is a connection subscribed to updates of a characteristic?
+     */
+    bool isSubscribed(Gap::Handle_t connectionHandle, GattAttribute::Handle_t valueHandle) const {
+        const Subscription_t *subscription = findSubscription(valueHandle);
+        int                   slot         = findSubscriberSlot(connectionHandle);
+        return (subscription != NULL) && (slot >= 0) && (subscription->subscribers & (1UL << slot));
+    }
+
+    /**
+     * Number of connections subscribed to updates of a characteristic.
+     */
+    unsigned getSubscriberCount(GattAttribute::Handle_t valueHandle) const {
+        const Subscription_t *subscription = findSubscription(valueHandle);
+        unsigned              count        = 0;
+        for (uint32_t subscribers = (subscription != NULL) ? subscription->subscribers : 0; subscribers != 0; subscribers &= subscribers - 1) {
+            count++;
+        }
+        return count;
+    }
+
     /**
      * Add a callback for the GATT event DATA_SENT (which is triggered when
      * updates are sent out by GATT in the form of notifications).
@@ -314,20 +511,241 @@ public:
      */
     void onUpdatesDisabled(EventCallback_t callback) {updatesDisabledCallback = callback;}
 
+    /**
+     * Add a callback for a peer enabling or disabling updates of a
+     * characteristic, which unlike the two above identifies the connection.
+     * It is invoked once the subscription has been recorded, so updates may
+     * be sent to the peer from within it.
+     */
+    template <typename T>
+    void onSubscriptionChanged(T *objPtr, void (T::*memberPtr)(const GattSubscriptionCallbackParams *params)) {
+        subscriptionCallChain.add(objPtr, memberPtr);
+    }
+
     /**
      * Setup a callback for when the GATT server receives a response for an
      * indication event sent previously.
      */
     void onConfirmationReceived(EventCallback_t callback) {confirmationReceivedCallback = callback;}
 
+    /**
+     * Add a callback into a member function for confirmations. Such
+     * callbacks are chained, and invoked alongside the one set above.
+     */
+    template <typename T>
+    void onConfirmationReceived(T *objPtr, void (T::*memberPtr)(GattAttribute::Handle_t attributeHandle)) {
+        confirmationReceivedCallChain.add(objPtr, memberPtr);
+    }
+
+    /**
+     * An estimate of the stack's free transmit buffers (credits), shared by
+     * the senders which hold updates back in front of write(), such as the
+     * NotificationQueues of several services. A sender takes a credit for
+     * each update the stack accepts, and drops them all when the stack runs
+     * out. The server returns credits as the stack releases buffers: 'count'
+     * of them on a data-sent event, one on a confirmation if none were left
+     * (an unconfirmed indication holds the stack up), and all of them when a
+     * connection terminates; each return is announced to the callbacks
+     * added with onTxCreditsReleased().
+     *
+     * The pool is empty until sized with setTxCredits(), which also caps it.
+     */
+    void setTxCredits(unsigned credits) {
+        txCredits    = 0;
+        maxTxCredits = credits;
+        releaseTxCredits(credits);
+    }
+
+    unsigned getTxCredits(void)    const {return txCredits;   }
+    unsigned getMaxTxCredits(void) const {return maxTxCredits;}
+
+    void takeTxCredit(void) {
+        if (txCredits > 0) {
+            txCredits--;
+        }
+    }
+
+    /**
+     * The stack has refused an update for want of buffers; the estimate was
+     * too optimistic. Sending resumes when buffers are released.
+     */
+    void dropTxCredits(void) {
+        txCredits = 0;
+    }
+
+    /**
+     * Add a callback for the return of credits, which receives the number
+     * available. Unlike the other callbacks it may be removed, with
+     * detachTxCreditsReleased(), by objects which don't outlive the server.
+     */
+    template <typename T>
+    FunctionPointerWithContext<unsigned> *onTxCreditsReleased(T *objPtr, void (T::*memberPtr)(unsigned credits)) {
+        return txCreditsReleasedCallChain.add(objPtr, memberPtr);
+    }
+
+    /**
+     * Remove a callback added with onTxCreditsReleased(); not to be called
+     * from within one.
+     */
+    void detachTxCreditsReleased(FunctionPointerWithContext<unsigned> *callback) {
+        txCreditsReleasedCallChain.remove(callback);
+    }
+
+    /**
+     * Attach a queue to reassemble long writes. Prepare Write Requests are
+     * then held in the queue, and an Execute Write Request delivers each
+     * attribute written to onDataWritten() callbacks as a single OP_WRITE_REQ
+     * carrying the complete value. Without a queue, prepared writes are
+     * passed to onDataWritten() callbacks as they arrive.
+     *
+     * @Note: this is done by the PreparedWriteQueue constructor.
+     */
+    void setPreparedWriteQueue(PreparedWriteQueue *queue) {preparedWriteQueue = queue;}
+
+    /**
+     * Register an application-owned buffer to receive the values written by
+     * peers to a characteristic. Each incoming value is copied once, from
+     * the stack's own buffer into a span of this one--by the port, through
+     * getReceiveSpan(), else by handleDataWrittenEvent()--and onDataWritten()
+     * callbacks receive params->data pointing at that span, so the
+     * application needn't copy it again.
+     *
+     * @param[in] valueHandle
+     *              Value handle of the characteristic.
+     * @param[in] buffer
+     *              The application's buffer; it must remain valid until unregistered.
+     * @param[in] size
+     *              Size of the buffer.
+     * @param[in] ring
+     *              If false, every write lands at its offset from the start
+     *              of the buffer, replacing the previous value. If true,
+     *              successive writes are placed one after the other, wrapping
+     *              around to the start when a write doesn't fit at the end;
+     *              the application must consume data before it is
+     *              overwritten.
+     *
+     * @Note: writes which don't fit into the buffer are delivered as before,
+     * with params->data pointing into the stack's own buffer.
+     *
+     * @return BLE_ERROR_NO_MEM if BLE_GATT_SERVER_MAX_RECEIVE_BUFFERS buffers are already registered.
+     */
+    ble_error_t registerReceiveBuffer(GattAttribute::Handle_t valueHandle, uint8_t *buffer, uint16_t size, bool ring = false) {
+        ReceiveBuffer_t *receiveBuffer = findReceiveBuffer(valueHandle);
+        if (receiveBuffer == NULL) {
+            receiveBuffer = findReceiveBuffer(GattAttribute::INVALID_HANDLE);
+            if (receiveBuffer == NULL) {
+                return BLE_ERROR_NO_MEM;
+            }
+        }
+
+        receiveBuffer->valueHandle = valueHandle;
+        receiveBuffer->buffer      = buffer;
+        receiveBuffer->size        = size;
+        receiveBuffer->head        = 0;
+        receiveBuffer->ring        = ring;
+        return BLE_ERROR_NONE;
+    }
+
+    void unregisterReceiveBuffer(GattAttribute::Handle_t valueHandle) {
+        ReceiveBuffer_t *receiveBuffer = findReceiveBuffer(valueHandle);
+        if (receiveBuffer != NULL) {
+            receiveBuffer->valueHandle = GattAttribute::INVALID_HANDLE;
+        }
+    }
+
     /* Entry points for the underlying stack to report events back to the user. */
 protected:
     void handleDataWrittenEvent(const GattWriteCallbackParams *params) {
+        if ((preparedWriteQueue != NULL) &&
+            ((params->writeOp == GattWriteCallbackParams::OP_PREP_WRITE_REQ) ||
+             (params->writeOp == GattWriteCallbackParams::OP_EXEC_WRITE_REQ_CANCEL) ||
+             (params->writeOp == GattWriteCallbackParams::OP_EXEC_WRITE_REQ_NOW))) {
+            handlePreparedWriteEvent(params);
+            return;
+        }
+
+        /* Move the data into the application's receive buffer, unless the port has already placed it there. */
+        ReceiveBuffer_t *receiveBuffer = findReceiveBuffer(params->handle);
+        if ((receiveBuffer != NULL) &&
+            !((params->data >= receiveBuffer->buffer) && (params->data < receiveBuffer->buffer + receiveBuffer->size))) {
+            uint8_t *span = getReceiveSpan(params->handle, params->offset, params->len);
+            if (span != NULL) {
+                memcpy(span, params->data, params->len);
+
+                GattWriteCallbackParams spanParams = *params;
+                spanParams.data = span;
+                if (dataWrittenCallChain.hasCallbacksAttached()) {
+                    dataWrittenCallChain.call(&spanParams);
+                }
+                return;
+            }
+        }
+
         if (dataWrittenCallChain.hasCallbacksAttached()) {
             dataWrittenCallChain.call(params);
         }
     }
 
+    /**
+     * For ports: obtain the location in a registered receive buffer where an
+     * incoming write is to be placed, so that it can be copied there straight
+     * from the stack's receive buffer. The port then reports the write
+     * through handleDataWrittenEvent() with params->data set to the span,
+     * which is passed on without a further copy.
+     *
+     * @return NULL if no buffer is registered for the attribute or the write
+     *         doesn't fit; the write is then reported as usual.
+     */
+    uint8_t *getReceiveSpan(GattAttribute::Handle_t valueHandle, uint16_t offset, uint16_t len) {
+        ReceiveBuffer_t *receiveBuffer = findReceiveBuffer(valueHandle);
+        if ((receiveBuffer == NULL) || (valueHandle == GattAttribute::INVALID_HANDLE)) {
+            return NULL;
+        }
+
+        if (!receiveBuffer->ring) {
+            return ((unsigned)offset + len <= receiveBuffer->size) ? &receiveBuffer->buffer[offset] : NULL;
+        }
+
+        if ((offset != 0) || (len > receiveBuffer->size)) {
+            return NULL;
+        }
+        if (receiveBuffer->head + len > receiveBuffer->size) {
+            receiveBuffer->head = 0;
+        }
+        uint8_t *span = &receiveBuffer->buffer[receiveBuffer->head];
+        receiveBuffer->head += len;
+        return span;
+    }
+
+    /**
+     * Entry point for Prepare Write and Execute Write Requests, for ports
+     * which reply to these on behalf of the application. The returned status
+     * is to be sent back to the peer.
+     */
+    GattAuthCallbackReply_t handlePreparedWriteEvent(const GattWriteCallbackParams *params) {
+        if (preparedWriteQueue == NULL) {
+            if (dataWrittenCallChain.hasCallbacksAttached()) {
+                dataWrittenCallChain.call(params);
+            }
+            return AUTH_CALLBACK_REPLY_SUCCESS;
+        }
+
+        switch (params->writeOp) {
+            case GattWriteCallbackParams::OP_PREP_WRITE_REQ:
+                return preparedWriteQueue->prepare(params);
+            case GattWriteCallbackParams::OP_EXEC_WRITE_REQ_CANCEL:
+                preparedWriteQueue->cancel(params->connHandle);
+                return AUTH_CALLBACK_REPLY_SUCCESS;
+            case GattWriteCallbackParams::OP_EXEC_WRITE_REQ_NOW: {
+                PreparedWriteQueue::WriteDelivery_t deliver(this, &GattServer::handleDataWrittenEvent);
+                return preparedWriteQueue->execute(params->connHandle, *this, deliver);
+            }
+            default:
+                handleDataWrittenEvent(params);
+                return AUTH_CALLBACK_REPLY_SUCCESS;
+        }
+    }
+
     void handleDataReadEvent(const GattReadCallbackParams *params) {
         if (dataReadCallChain.hasCallbacksAttached()) {
             dataReadCallChain.call(params);
@@ -350,6 +768,12 @@ protected:
                 if (confirmationReceivedCallback) {
                     confirmationReceivedCallback(attributeHandle);
                 }
+                if (confirmationReceivedCallChain.hasCallbacksAttached()) {
+                    confirmationReceivedCallChain.call(attributeHandle);
+                }
+                if (txCredits == 0) {
+                    releaseTxCredits(1);
+                }
                 break;
             default:
                 break;
@@ -360,6 +784,90 @@ protected:
         if (dataSentCallChain.hasCallbacksAttached()) {
             dataSentCallChain.call(count);
         }
+        releaseTxCredits(count);
+    }
+
+    /**
+     * Report a write to a characteristic's CCCD by a peer. This records the
+     * connection as a subscriber (or not) for notifyAll() and isSubscribed(),
+     * then raises GATT_EVENT_UPDATES_ENABLED or GATT_EVENT_UPDATES_DISABLED
+     * as handleEvent() would, and invokes the onSubscriptionChanged() callbacks.
+     *
+     * @param[in] connectionHandle
+     *              The connection which wrote the CCCD.
+     * @param[in] valueHandle
+     *              Value handle of the characteristic the CCCD belongs to.
+     * @param[in] cccdValue
+     *              The new CCCD value; notifications and/or indications are
+     *              enabled if either of the two low bits is set.
+     *
+     * @return BLE_ERROR_NO_MEM if the subscription can't be recorded, as
+     *         BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS characteristics
+     *         or BLE_GAP_MAX_CONNECTIONS subscribers are tracked already; no
+     *         event is raised then, and the port should reject the CCCD
+     *         write (with AUTH_CALLBACK_REPLY_ATTERR_INSUF_RESOURCES).
+     */
+    ble_error_t handleSubscriptionEvent(Gap::Handle_t connectionHandle, GattAttribute::Handle_t valueHandle, uint16_t cccdValue) {
+        bool enabled = (cccdValue & (CCCD_NOTIFICATIONS_ENABLED | CCCD_INDICATIONS_ENABLED)) != 0;
+        if (enabled) {
+            bool            newSlot      = (findSubscriberSlot(connectionHandle) < 0);
+            int             slot         = allocateSubscriberSlot(connectionHandle);
+            Subscription_t *subscription = findSubscription(valueHandle);
+            if (subscription == NULL) {
+                subscription = findSubscription(GattAttribute::INVALID_HANDLE); /* free entries have no subscribers */
+            }
+            if ((slot < 0) || (subscription == NULL)) {
+                if ((slot >= 0) && newSlot) {
+                    subscriberSlotsInUse &= ~(1UL << slot);
+                }
+                return BLE_ERROR_NO_MEM;
+            }
+
+            subscription->valueHandle  = valueHandle;
+            subscription->subscribers |= (1UL << slot);
+        } else {
+            int             slot         = findSubscriberSlot(connectionHandle);
+            Subscription_t *subscription = findSubscription(valueHandle);
+            if ((slot >= 0) && (subscription != NULL)) {
+                subscription->subscribers &= ~(1UL << slot);
+                if (subscription->subscribers == 0) {
+                    subscription->valueHandle = GattAttribute::INVALID_HANDLE;
+                }
+            }
+        }
+
+        handleEvent(enabled ? GattServerEvents::GATT_EVENT_UPDATES_ENABLED : GattServerEvents::GATT_EVENT_UPDATES_DISABLED, valueHandle);
+        if (subscriptionCallChain.hasCallbacksAttached()) {
+            GattSubscriptionCallbackParams params;
+            params.connHandle = connectionHandle;
+            params.handle     = valueHandle;
+            params.enabled    = enabled;
+            subscriptionCallChain.call(&params);
+        }
+        return BLE_ERROR_NONE;
+    }
+
+    /* Connection events which concern the server; BLE::init() hooks these up to Gap. */
+public:
+    /**
+     * Drop the subscriptions of a terminated connection. The buffers the
+     * stack held for it have been released, so credits are returned as well.
+     */
+    void processDisconnectionEvent(const Gap::DisconnectionCallbackParams_t *params) {
+        releaseTxCredits(maxTxCredits);
+
+        int slot = findSubscriberSlot(params->handle);
+        if (slot < 0) {
+            return;
+        }
+
+        for (unsigned i = 0; i < BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS; i++) {
+            subscriptions[i].subscribers &= ~(1UL << slot);
+            if (subscriptions[i].subscribers == 0) {
+                subscriptions[i].valueHandle = GattAttribute::INVALID_HANDLE;
+            }
+        }
+        subscriberSlotsInUse &= ~(1UL << slot);
     }
 
 protected:
@@ -367,12 +875,96 @@ protected:
     uint8_t characteristicCount;
 
 private:
+    static const uint16_t CCCD_NOTIFICATIONS_ENABLED = 0x0001;
+    static const uint16_t CCCD_INDICATIONS_ENABLED   = 0x0002;
+
+    /* Subscribers to a characteristic, as a bitset indexed by subscriber slot. */
+    struct Subscription_t {
+        GattAttribute::Handle_t valueHandle;
+        uint32_t                subscribers;
+    };
+
+    Subscription_t *findSubscription(GattAttribute::Handle_t valueHandle) {
+        for (unsigned i = 0; i < BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS; i++) {
+            if (subscriptions[i].valueHandle == valueHandle) {
+                return &subscriptions[i];
+            }
+        }
+        return NULL;
+    }
+    const Subscription_t *findSubscription(GattAttribute::Handle_t valueHandle) const {
+        return const_cast<GattServer *>(this)->findSubscription(valueHandle);
+    }
+
+    int findSubscriberSlot(Gap::Handle_t connectionHandle) const {
+        for (unsigned slot = 0; slot < BLE_GAP_MAX_CONNECTIONS; slot++) {
+            if ((subscriberSlotsInUse & (1UL << slot)) && (subscriberConnections[slot] == connectionHandle)) {
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    int allocateSubscriberSlot(Gap::Handle_t connectionHandle) {
+        int slot = findSubscriberSlot(connectionHandle);
+        if (slot >= 0) {
+            return slot;
+        }
+
+        for (unsigned i = 0; i < BLE_GAP_MAX_CONNECTIONS; i++) {
+            if (!(subscriberSlotsInUse & (1UL << i))) {
+                subscriberSlotsInUse     |= (1UL << i);
+                subscriberConnections[i]  = connectionHandle;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    struct ReceiveBuffer_t {
+        GattAttribute::Handle_t valueHandle;
+        uint8_t                *buffer;
+        uint16_t                size;
+        uint16_t                head; /* where the next write goes, for rings */
+        bool                    ring;
+    };
+
+    void releaseTxCredits(unsigned credits) {
+        txCredits = ((txCredits + credits) > maxTxCredits) ? maxTxCredits : (txCredits + credits);
+        if ((txCredits > 0) && txCreditsReleasedCallChain.hasCallbacksAttached()) {
+            txCreditsReleasedCallChain.call(txCredits);
+        }
+    }
+
+    ReceiveBuffer_t *findReceiveBuffer(GattAttribute::Handle_t valueHandle) {
+        for (unsigned i = 0; i < BLE_GATT_SERVER_MAX_RECEIVE_BUFFERS; i++) {
+            if (receiveBuffers[i].valueHandle == valueHandle) {
+                return &receiveBuffers[i];
+            }
+        }
+        return NULL;
+    }
+
+private:
+    PreparedWriteQueue                                                     *preparedWriteQueue;
+
+    uint32_t                                                                subscriberSlotsInUse;
+    Gap::Handle_t                                                           subscriberConnections[BLE_GAP_MAX_CONNECTIONS];
+    Subscription_t                                                          subscriptions[BLE_GATT_SERVER_MAX_SUBSCRIBED_CHARACTERISTICS];
+    ReceiveBuffer_t                                                         receiveBuffers[BLE_GATT_SERVER_MAX_RECEIVE_BUFFERS];
+
     CallChainOfFunctionPointersWithContext<unsigned>                        dataSentCallChain;
     CallChainOfFunctionPointersWithContext<const GattWriteCallbackParams *> dataWrittenCallChain;
     CallChainOfFunctionPointersWithContext<const GattReadCallbackParams *>  dataReadCallChain;
     EventCallback_t                                                         updatesEnabledCallback;
     EventCallback_t                                                         updatesDisabledCallback;
     EventCallback_t                                                         confirmationReceivedCallback;
+    CallChainOfFunctionPointersWithContext<GattAttribute::Handle_t>         confirmationReceivedCallChain;
+    CallChainOfFunctionPointersWithContext<const GattSubscriptionCallbackParams *> subscriptionCallChain;
+
+    unsigned                                                                txCredits;
+    unsigned                                                                maxTxCredits;
+    CallChainOfFunctionPointersWithContext<unsigned>                        txCreditsReleasedCallChain;
 
 private:
     /* disallow copy and assignment */
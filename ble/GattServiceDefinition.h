@@ -0,0 +1,102 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_SERVICE_DEFINITION_H__
+#define __GATT_SERVICE_DEFINITION_H__
+
+#include "UUID.h"
+#include "GattAttribute.h"
+#include "GattCharacteristic.h"
+
+/*
+ * Services described by constant tables, as an alternative to building
+ * GattCharacteristic and GattService objects at runtime.
+ *
+ * The definitions below are aggregates; when declared 'static const' and
+ * initialized with constants, as in the example, the compiler lays them out
+ * at build time in read-only memory (flash). No objects are constructed in
+ * RAM. Registration with GattServer::addService(const GattServiceDefinition &, ...)
+ * reserves exactly maxLength bytes of value storage per attribute; values
+ * with a maxLength of 0 are constants and are served from the definition
+ * itself, taking no RAM at all.
+ *
+ * @section EXAMPLE
+ *
+ * @code
+ *
+ * static const uint8_t batteryLevel[] = {100};
+ *
+ * static const GattCharacteristicDefinition batteryCharacteristics[] = {
+ *     {GattCharacteristic::UUID_BATTERY_LEVEL_CHAR, NULL,
+ *      GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY,
+ *      batteryLevel, sizeof(batteryLevel), sizeof(batteryLevel), NULL, 0}
+ * };
+ *
+ * static const GattServiceDefinition batteryService = {
+ *     GattService::UUID_BATTERY_SERVICE, NULL,
+ *     batteryCharacteristics, GATT_DEFINITION_COUNT(batteryCharacteristics)
+ * };
+ *
+ * GattAttribute::Handle_t batteryLevelHandle;
+ * ble.gattServer().addService(batteryService, &batteryLevelHandle);
+ *
+ * @endcode
+ */
+
+/**
+ * The number of entries in a table of definitions, as a constant expression.
+ */
+#define GATT_DEFINITION_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+struct GattDescriptorDefinition {
+    UUID::ShortUUIDBytes_t  shortUUID;     /**< Type of the descriptor; ignored if longUUID is set. */
+    const uint8_t          *longUUID;      /**< A 128-bit type, MSB first (as taken by UUID's constructor); NULL for 16-bit types. */
+    const uint8_t          *initialValue;  /**< May be NULL if initialLength is 0. */
+    uint16_t                initialLength;
+    uint16_t                maxLength;     /**< 0 for a constant value. */
+
+    UUID getUUID(void) const {
+        return (longUUID != NULL) ? UUID(longUUID) : UUID(shortUUID);
+    }
+};
+
+struct GattCharacteristicDefinition {
+    UUID::ShortUUIDBytes_t          shortUUID;       /**< Type of the characteristic; ignored if longUUID is set. */
+    const uint8_t                  *longUUID;        /**< A 128-bit type, MSB first; NULL for 16-bit types. */
+    uint8_t                         properties;      /**< GattCharacteristic::Properties_t, combined. */
+    const uint8_t                  *initialValue;    /**< May be NULL if initialLength is 0. */
+    uint16_t                        initialLength;
+    uint16_t                        maxLength;       /**< 0 for a constant value. */
+    const GattDescriptorDefinition *descriptors;     /**< Explicit descriptors; a CCCD is added implicitly as for GattService. */
+    uint8_t                         descriptorCount;
+
+    UUID getUUID(void) const {
+        return (longUUID != NULL) ? UUID(longUUID) : UUID(shortUUID);
+    }
+};
+
+struct GattServiceDefinition {
+    UUID::ShortUUIDBytes_t              shortUUID;   /**< Type of the service; ignored if longUUID is set. */
+    const uint8_t                      *longUUID;    /**< A 128-bit type, MSB first; NULL for 16-bit types. */
+    const GattCharacteristicDefinition *characteristics;
+    uint8_t                             characteristicCount;
+
+    UUID getUUID(void) const {
+        return (longUUID != NULL) ? UUID(longUUID) : UUID(shortUUID);
+    }
+};
+
+#endif // ifndef __GATT_SERVICE_DEFINITION_H__
@@ -0,0 +1,161 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_SUBSCRIPTION_BATCH_H__
+#define __GATT_SUBSCRIPTION_BATCH_H__
+
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattClient.h"
+#include "DiscoveredCharacteristic.h"
+#include "DiscoveredDescriptor.h"
+
+#ifndef BLE_GATT_SUBSCRIPTION_BATCH_MAX_CHARACTERISTICS
+#define BLE_GATT_SUBSCRIPTION_BATCH_MAX_CHARACTERISTICS 16 /**< Characteristics subscribed to by one batch. */
+#endif
+
+class BLE;
+
+/**
+ * Client side subscription to the notifications or indications of a set of
+ * characteristics, completed by a single callback.
+ *
+ * The CCCDs are found by a single sweep of Find Information Requests,
+ * starting at the first of the characteristics and stopping as soon as the
+ * CCCD of each has been seen, rather than by a descriptor discovery per
+ * characteristic. The CCCD writes then go into the GattClient request queue
+ * together, so each goes out as soon as the previous one is acknowledged.
+ * Where the CCCD handles are known already (from a GattAttributeCache, or
+ * from getCCCDHandle() on an earlier connection), the sweep is skipped.
+ *
+ * @Note: this enables updates at the peer; routing them is up to the
+ * application, through GattClient::onHVX().
+ */
+class GattSubscriptionBatch {
+public:
+    static const unsigned MAX_CHARACTERISTICS = BLE_GATT_SUBSCRIPTION_BATCH_MAX_CHARACTERISTICS;
+
+    enum Mode_t {
+        UNSUBSCRIBE,   /**< Disable both notifications and indications. */
+        NOTIFICATIONS, /**< Notifications, or indications for characteristics which only indicate. */
+        INDICATIONS    /**< Indications, or notifications for characteristics which only notify. */
+    };
+
+    typedef void (*CompletionCallback_t)(GattSubscriptionBatch *batch);
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     */
+    GattSubscriptionBatch(BLE &ble);
+
+    /**
+     * Subscribe to a set of characteristics.
+     *
+     * @param[in] characteristics
+     *              The characteristics, all on one connection; the array is
+     *              copied.
+     * @param[in] count
+     *              The number of characteristics, up to MAX_CHARACTERISTICS.
+     * @param[in] mode
+     *              What to enable.
+     * @param[in] callback
+     *              Invoked once every CCCD has been written, or has failed.
+     *
+     * @return BLE_STACK_BUSY if a subscription or discovery is in progress,
+     *         BLE_ERROR_INVALID_PARAM if count is 0 or above MAX_CHARACTERISTICS
+     *         or the characteristics aren't all on one connection;
+     *         BLE_ERROR_NONE otherwise.
+     */
+    ble_error_t subscribe(const DiscoveredCharacteristic *characteristics,
+                          uint8_t                         count,
+                          Mode_t                          mode,
+                          CompletionCallback_t            callback);
+
+    /**
+     * Subscribe through CCCDs whose handles are known. The mode is taken
+     * as it is, as the properties of the characteristics aren't.
+     *
+     * @param[in] cccdHandles
+     *              The CCCDs; the array is copied.
+     */
+    ble_error_t subscribe(Gap::Handle_t                  connHandle,
+                          const GattAttribute::Handle_t *cccdHandles,
+                          uint8_t                        count,
+                          Mode_t                         mode,
+                          CompletionCallback_t           callback);
+
+    bool isActive(void) const {return pending != 0;}
+
+    /*
+     * Results of the current (or last) subscription, in the order of the
+     * characteristics. A characteristic which supports neither notifications
+     * nor indications fails with BLE_ERROR_OPERATION_NOT_PERMITTED, and one
+     * whose CCCD isn't found with BLE_ERROR_UNSPECIFIED.
+     */
+    Gap::Handle_t           getConnectionHandle(void)       const {return connHandle;                 }
+    uint8_t                 getCount(void)                  const {return count;                      }
+    GattAttribute::Handle_t getValueHandle(unsigned index)  const {return entries[index].valueHandle; }
+    GattAttribute::Handle_t getCCCDHandle(unsigned index)   const {return entries[index].cccdHandle;  }
+    ble_error_t             getStatus(unsigned index)       const {return entries[index].status;      }
+
+protected:
+    static void onDescriptor(const DiscoveredDescriptor *descriptor);
+    static void onTermination(Gap::Handle_t connectionHandle);
+    static void onWritten(const GattClient::RequestResult_t *result);
+
+private:
+    static const uint16_t CCCD_NOTIFICATIONS_ENABLED = 0x0001;
+    static const uint16_t CCCD_INDICATIONS_ENABLED   = 0x0002;
+
+    struct Entry_t {
+        GattAttribute::Handle_t declHandle;
+        GattAttribute::Handle_t valueHandle;
+        GattAttribute::Handle_t cccdHandle;  /* INVALID_HANDLE until found */
+        ble_error_t             status;      /* BLE_STACK_BUSY until written */
+        bool                    queued;
+        uint8_t                 value[2];    /* the CCCD value, little-endian */
+    };
+
+    static uint16_t cccdValue(const DiscoveredCharacteristic::Properties_t &properties, Mode_t mode);
+
+    void writeAll(void);
+    void store(unsigned index, ble_error_t status);
+    void finishIfDone(void);
+
+private:
+    BLE                     &ble;
+
+    Gap::Handle_t            connHandle;
+    CompletionCallback_t     completionCallback;
+    uint8_t                  count;
+    uint8_t                  pending;       /* CCCDs not yet written */
+    uint8_t                  unfound;       /* CCCDs the sweep is still looking for */
+    uint8_t                  outstanding;   /* writes in the request queue */
+    bool                     issuing;       /* completion is held back while writes are being queued */
+    Entry_t                  entries[MAX_CHARACTERISTICS];
+
+    GattSubscriptionBatch   *next;          /* in the list of batches which are discovering */
+    static GattSubscriptionBatch *discoveringBatches;
+
+private:
+    /* disallow copy and assignment */
+    GattSubscriptionBatch(const GattSubscriptionBatch &);
+    GattSubscriptionBatch& operator=(const GattSubscriptionBatch &);
+};
+
+#endif // ifndef __GATT_SUBSCRIPTION_BATCH_H__
@@ -0,0 +1,159 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GATT_WRITE_STREAM_H__
+#define __GATT_WRITE_STREAM_H__
+
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattClient.h"
+
+class BLE;
+
+/**
+ * Client side streaming of bulk data to a characteristic with write commands
+ * (writes without response), such as firmware images or configuration blobs.
+ *
+ * The data, taken from a buffer or from a producer callback, is split into
+ * chunks of ATT_MTU - 3 bytes. The stream sends chunks until the stack runs
+ * out of transmit buffers, so that every connection event carries as many
+ * packets as the controller allows; it resumes on data-sent events. Progress
+ * may be read at any time, and a callback reports completion.
+ *
+ * A stream transfers to one characteristic over one connection at a time;
+ * use a stream per connection to feed several peers at once. The stream
+ * attaches itself to the GattServer's data-sent events and to the
+ * disconnection chain, so it must outlive the BLE object (typically, it is
+ * static or a member of a long-lived service object).
+ */
+class GattWriteStream {
+public:
+    /**
+     * Fill a chunk of the stream.
+     *
+     * @param[out] buffer
+     *               Where to put the data.
+     * @param[in]  maxLength
+     *               The size of the chunk; anything shorter is sent as it is.
+     * @param[in]  context
+     *               As passed to start().
+     *
+     * @return The number of bytes produced; 0 at the end of the stream.
+     */
+    typedef uint16_t (*Producer_t)(uint8_t *buffer, uint16_t maxLength, void *context);
+
+    /**
+     * Invoked once at the end of the transfer, with BLE_ERROR_NONE if all the
+     * data was handed to the stack, or the reason the transfer stopped.
+     */
+    typedef void (*CompletionCallback_t)(GattWriteStream *stream, ble_error_t status);
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     */
+    GattWriteStream(BLE &ble);
+
+    /**
+     * Stream the contents of a buffer.
+     *
+     * @param[in] connHandle
+     *              Connection handle.
+     * @param[in] valueHandle
+     *              Value handle of the characteristic on the peer; it must
+     *              permit writes without response.
+     * @param[in] data
+     *              The data to send. It isn't copied; it must remain valid
+     *              until the transfer completes.
+     * @param[in] length
+     *              The number of bytes to send.
+     * @param[in] callback
+     *              Invoked on completion; may be NULL.
+     *
+     * @return BLE_STACK_BUSY if a transfer is in progress; BLE_ERROR_NONE otherwise.
+     *         The first chunks are sent before this returns.
+     */
+    ble_error_t start(Gap::Handle_t            connHandle,
+                      GattAttribute::Handle_t  valueHandle,
+                      const uint8_t           *data,
+                      uint32_t                 length,
+                      CompletionCallback_t     callback = NULL);
+
+    /**
+     * Stream data from a producer, until it returns 0.
+     */
+    ble_error_t start(Gap::Handle_t            connHandle,
+                      GattAttribute::Handle_t  valueHandle,
+                      Producer_t               producer,
+                      void                    *context,
+                      CompletionCallback_t     callback = NULL);
+
+    /**
+     * Stop the transfer. Chunks already handed to the stack are still sent;
+     * the completion callback isn't invoked.
+     */
+    void abort(void);
+
+    bool isActive(void) const {return active;}
+
+    /* Progress of the current (or last) transfer. */
+    uint32_t getBytesSent(void)   const {return bytesSent;  }
+    uint32_t getPacketsSent(void) const {return packetsSent;}
+
+    /**
+     * The number of times the stream filled the transmit buffers: once at
+     * start, and then once per data-sent event. Packets per burst approaching
+     * the controller's buffer count indicates the link is kept saturated.
+     */
+    uint32_t getBursts(void)      const {return bursts;     }
+
+protected:
+    void onDataSent(unsigned count);
+    void onDisconnection(const Gap::DisconnectionCallbackParams_t *params);
+
+private:
+    ble_error_t begin(Gap::Handle_t connHandle, GattAttribute::Handle_t valueHandle, CompletionCallback_t callback);
+    void        send(void);
+    void        finish(ble_error_t status);
+
+private:
+    BLE                     &ble;
+
+    bool                     active;
+    Gap::Handle_t            connHandle;
+    GattAttribute::Handle_t  valueHandle;
+    CompletionCallback_t     completionCallback;
+
+    const uint8_t           *data;          /* the buffer, when not streaming from a producer */
+    uint32_t                 length;
+    Producer_t               producer;
+    void                    *producerContext;
+
+    uint8_t                  chunk[BLE_GATT_MTU_SIZE_MAX - 3]; /* produced, but not yet accepted by the stack */
+    uint16_t                 chunkLength;
+
+    uint32_t                 bytesSent;
+    uint32_t                 packetsSent;
+    uint32_t                 bursts;
+
+private:
+    /* disallow copy and assignment */
+    GattWriteStream(const GattWriteStream &);
+    GattWriteStream& operator=(const GattWriteStream &);
+};
+
+#endif // ifndef __GATT_WRITE_STREAM_H__
@@ -0,0 +1,202 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __NOTIFICATION_QUEUE_H__
+#define __NOTIFICATION_QUEUE_H__
+
+#include "BLE.h"
+
+#ifndef BLE_NOTIFICATION_QUEUE_MAX_VALUE_LEN
+#define BLE_NOTIFICATION_QUEUE_MAX_VALUE_LEN (BLE_GATT_MTU_SIZE_MAX - 3)
+#endif
+#ifndef BLE_NOTIFICATION_QUEUE_DEFAULT_TX_CREDITS
+#define BLE_NOTIFICATION_QUEUE_DEFAULT_TX_CREDITS 8
+#endif
+
+/**
+ * A send queue for notifications and indications which sits in front of
+ * GattServer::write().
+ *
+ * Updates are sent straight away while the stack has transmit buffers
+ * available. Once the stack runs out (GattServer::write() fails with
+ * BLE_ERROR_NO_MEM or BLE_STACK_BUSY) they are held back in the queue and
+ * sent as buffers are released, which the stack reports through
+ * GattServer::onDataSent(). The estimate of the free transmit buffers
+ * (credits) is the GattServer's (see GattServer::setTxCredits()): every
+ * successful send takes one and every data-sent event returns 'count' of
+ * them. The estimate corrects itself whenever the stack refuses a packet.
+ *
+ * Entries are tagged with the connection they are destined for, and entries
+ * for a connection are purged when it terminates. Each update is queued in
+ * one of two modes:
+ *  - MODE_STATE: only the latest value matters (e.g. a sensor reading). A
+ *    pending entry for the same connection and attribute is overwritten in
+ *    place, so a slow link only ever sees the most recent value.
+ *  - MODE_STREAM: every value matters (e.g. UART data). Each update takes
+ *    its own entry; enqueue() fails with BLE_ERROR_NO_MEM when the queue is
+ *    full so that the caller can apply backpressure.
+ *
+ * An indication holds the stack up until the peer confirms it, which the
+ * stack reports through GattServer::onConfirmationReceived() rather than as
+ * a data-sent event; the queue resumes sending on either.
+ *
+ * @note: Data-sent events don't identify the link they refer to, so credits
+ * are shared across connections; this mirrors stacks which share their
+ * transmit buffers between links. For the same reason the queues on one
+ * BLE object (e.g. those of several services) draw on one pool, and are
+ * flushed in turn as credits return.
+ *
+ * A queue detaches itself from the GattServer and Gap when destroyed; it
+ * must not be destroyed from within one of their callbacks.
+ *
+ * The storage for the entries is supplied by the owner; see
+ * StaticNotificationQueue for a self-contained variant.
+ */
+class NotificationQueue {
+public:
+    enum Mode_t {
+        MODE_STATE  = 0, /**< Coalesce: keep only the latest pending value for an attribute. */
+        MODE_STREAM = 1, /**< Keep every value, in order. */
+    };
+
+    static const unsigned MAX_VALUE_LEN      = BLE_NOTIFICATION_QUEUE_MAX_VALUE_LEN;
+    static const unsigned DEFAULT_TX_CREDITS = BLE_NOTIFICATION_QUEUE_DEFAULT_TX_CREDITS;
+
+    struct Entry {
+        uint32_t                sequence;
+        Gap::Handle_t           connHandle;
+        GattAttribute::Handle_t handle;
+        uint16_t                len;
+        uint8_t                 flags;
+        uint8_t                 value[MAX_VALUE_LEN];
+    };
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     * @param[in]  storage
+     *               Memory for the queue entries; owned by the caller.
+     * @param[in]  capacity
+     *               Number of entries in storage.
+     * @param[in]  txCredits
+     *               Initial estimate of the number of transmit buffers
+     *               available in the stack, which also caps the estimate.
+     *               It sizes the GattServer's pool, unless that has been
+     *               sized already (e.g. by another queue).
+     */
+    NotificationQueue(BLE &ble, Entry *storage, unsigned capacity, unsigned txCredits = DEFAULT_TX_CREDITS);
+
+    ~NotificationQueue(void);
+
+    /**
+     * Queue an update to a characteristic value, to be notified/indicated to
+     * whichever peers have subscribed; see GattServer::write(). The locally
+     * stored value is updated immediately even if the notification has to be
+     * deferred.
+     *
+     * @return BLE_ERROR_NONE if the update has been sent or queued;
+     *         BLE_ERROR_NO_MEM if the queue is full;
+     *         BLE_ERROR_BUFFER_OVERFLOW if the value is longer than MAX_VALUE_LEN;
+     *         else the error returned by GattServer::write().
+     */
+    ble_error_t enqueue(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len, Mode_t mode);
+
+    /**
+     * Queue an update to a characteristic value for a specific connection;
+     * see GattServer::write(Gap::Handle_t, ...).
+     */
+    ble_error_t enqueue(Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len, Mode_t mode);
+
+    /**
+     * Send as many pending entries as the stack will accept. This is done
+     * automatically upon data-sent events.
+     */
+    void flush(void);
+
+    /**
+     * Drop all pending entries.
+     */
+    void clear(void);
+
+    /**
+     * Reset the estimate of the stack's free transmit buffers, for instance
+     * once the application has learned the real number from the stack. This
+     * applies to all the queues on the same BLE object; see
+     * GattServer::setTxCredits().
+     */
+    void setTxCredits(unsigned credits) {ble.gattServer().setTxCredits(credits);}
+
+    unsigned getTxCredits(void)     const {return ble.gattServer().getTxCredits();}
+    unsigned getPendingCount(void)  const {return pendingCount; }
+    unsigned getCapacity(void)      const {return capacity;     }
+    unsigned getDroppedCount(void)  const {return droppedCount; } /**< Entries the stack rejected outright (e.g. updates disabled). */
+    bool     isEmpty(void)          const {return pendingCount == 0;}
+
+protected:
+    void onTxCreditsReleased(unsigned credits);
+    void onDisconnection(const Gap::DisconnectionCallbackParams_t *params);
+
+private:
+    enum {
+        FLAG_USED             = 0x01,
+        FLAG_STATE            = 0x02,
+        FLAG_HAS_CONN_HANDLE  = 0x04,
+    };
+
+    ble_error_t enqueue(uint8_t flags, Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len);
+    ble_error_t send(uint8_t flags, Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len);
+    Entry      *findOldest(void);
+
+    static bool isOutOfBuffers(ble_error_t error) {
+        return (error == BLE_ERROR_NO_MEM) || (error == BLE_STACK_BUSY);
+    }
+
+private:
+    BLE      &ble;
+    Entry    *entries;
+    unsigned  capacity;
+    unsigned  pendingCount;
+    unsigned  droppedCount;
+    uint32_t  nextSequence;
+    bool      flushing;
+
+    /* as registered with the GattServer and Gap, to be removed on destruction */
+    FunctionPointerWithContext<unsigned>                              *txCreditsReleasedCallback;
+    Gap::DisconnectionEventCallChain_t::pFunctionPointerWithContext_t  disconnectionCallback;
+
+private:
+    /* disallow copy and assignment */
+    NotificationQueue(const NotificationQueue &);
+    NotificationQueue& operator=(const NotificationQueue &);
+};
+
+/**
+ * A NotificationQueue carrying its own storage for DEPTH entries.
+ */
+template <unsigned DEPTH>
+class StaticNotificationQueue : public NotificationQueue {
+public:
+    StaticNotificationQueue(BLE &ble, unsigned txCredits = DEFAULT_TX_CREDITS) :
+        NotificationQueue(ble, storage, DEPTH, txCredits) {
+        /* empty */
+    }
+
+private:
+    Entry storage[DEPTH];
+};
+
+#endif // ifndef __NOTIFICATION_QUEUE_H__
@@ -0,0 +1,142 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PREPARED_WRITE_QUEUE_H__
+#define __PREPARED_WRITE_QUEUE_H__
+
+#include "Gap.h"
+#include "GattAttribute.h"
+#include "GattCallbackParamTypes.h"
+#include "FunctionPointerWithContext.h"
+
+#ifndef BLE_PREPARED_WRITE_ARENA_SIZE
+#define BLE_PREPARED_WRITE_ARENA_SIZE  256 /**< Bytes of prepared data held across all connections. */
+#endif
+#ifndef BLE_PREPARED_WRITE_MAX_SEGMENTS
+#define BLE_PREPARED_WRITE_MAX_SEGMENTS 24 /**< Prepare Write Requests held across all connections. */
+#endif
+#ifndef BLE_PREPARED_WRITE_MAX_VALUE_LEN
+#define BLE_PREPARED_WRITE_MAX_VALUE_LEN 256 /**< Longest value which can be reassembled. */
+#endif
+
+class BLE;
+class GattServer;
+
+/**
+ * Server side reassembly of long writes.
+ *
+ * A client writes values longer than ATT_MTU - 3 with a sequence of Prepare
+ * Write Requests, each carrying a part of the value and its offset, followed
+ * by an Execute Write Request. The queue holds the prepared parts in a fixed
+ * arena, subject to per-connection limits, and upon execution applies them in
+ * order to the current value of each attribute. Every attribute written is
+ * then updated locally and reported to GattServer::onDataWritten() callbacks
+ * as a single OP_WRITE_REQ carrying the complete value at offset 0; so
+ * services see long writes the same way they see short ones.
+ *
+ * Creating a PreparedWriteQueue attaches it to the GattServer. Ports hand
+ * prepare and execute operations to GattServer::handlePreparedWriteEvent()
+ * (or simply to handleDataWrittenEvent()) and reply to the peer with the
+ * status it returns.
+ */
+class PreparedWriteQueue {
+public:
+    static const unsigned ARENA_SIZE    = BLE_PREPARED_WRITE_ARENA_SIZE;
+    static const unsigned MAX_SEGMENTS  = BLE_PREPARED_WRITE_MAX_SEGMENTS;
+    static const unsigned MAX_VALUE_LEN = BLE_PREPARED_WRITE_MAX_VALUE_LEN;
+
+    typedef FunctionPointerWithContext<const GattWriteCallbackParams *> WriteDelivery_t;
+
+public:
+    /**
+     * @param[ref] ble
+     *               BLE object for the underlying controller.
+     * @param[in]  maxBytesPerConnection
+     *               Limit on the prepared data held for any one connection.
+     * @param[in]  maxSegmentsPerConnection
+     *               Limit on the number of prepared writes held for any one connection.
+     */
+    PreparedWriteQueue(BLE &ble, uint16_t maxBytesPerConnection = ARENA_SIZE, uint8_t maxSegmentsPerConnection = MAX_SEGMENTS);
+
+    /**
+     * Queue the data from a Prepare Write Request.
+     *
+     * @return AUTH_CALLBACK_REPLY_SUCCESS, or
+     *         AUTH_CALLBACK_REPLY_ATTERR_PREPARE_QUEUE_FULL if the arena or
+     *         the connection's allowance is exhausted.
+     */
+    GattAuthCallbackReply_t prepare(const GattWriteCallbackParams *params);
+
+    /**
+     * Apply all writes prepared by a connection, in the order in which they
+     * were received. The resulting values are validated before any of them
+     * is applied; the queue for the connection is emptied in any case.
+     *
+     * @param[in] connHandle
+     *              The connection which issued the Execute Write Request.
+     * @param[in] server
+     *              The server holding the attributes.
+     * @param[in] deliver
+     *              Invoked once for every attribute written, with its complete value.
+     *
+     * @return AUTH_CALLBACK_REPLY_SUCCESS, or
+     *         AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET if a part starts beyond the end of the value, or
+     *         AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH if a value would exceed MAX_VALUE_LEN
+     *         or the maximum length of its attribute (see GattServer::getMaxLength()), or
+     *         the server refuses it; attributes applied before a refusal stay written.
+     */
+    GattAuthCallbackReply_t execute(Gap::Handle_t connHandle, GattServer &server, WriteDelivery_t &deliver);
+
+    /**
+     * Discard all writes prepared by a connection.
+     */
+    void cancel(Gap::Handle_t connHandle);
+
+    unsigned getBytesQueued(void)    const {return arenaUsed;   }
+    unsigned getSegmentsQueued(void) const {return segmentCount;}
+
+protected:
+    void onDisconnection(const Gap::DisconnectionCallbackParams_t *params);
+
+private:
+    struct Segment {
+        Gap::Handle_t           connHandle;
+        GattAttribute::Handle_t handle;
+        uint16_t                offset;
+        uint16_t                len;
+        uint16_t                arenaOffset;
+    };
+
+    GattAuthCallbackReply_t reassemble(Gap::Handle_t connHandle, GattServer &server, unsigned first, uint16_t *lengthP);
+    void                    release(Gap::Handle_t connHandle);
+
+private:
+    uint16_t maxBytesPerConnection;
+    uint8_t  maxSegmentsPerConnection;
+
+    uint16_t arenaUsed;
+    uint8_t  segmentCount;
+    Segment  segments[MAX_SEGMENTS];  /* in order of arrival */
+    uint8_t  arena[ARENA_SIZE];       /* segment data, packed in order of arrival */
+    uint8_t  value[MAX_VALUE_LEN];    /* scratch space for reassembly */
+
+private:
+    /* disallow copy and assignment */
+    PreparedWriteQueue(const PreparedWriteQueue &);
+    PreparedWriteQueue& operator=(const PreparedWriteQueue &);
+};
+
+#endif // ifndef __PREPARED_WRITE_QUEUE_H__
@@ -18,11 +18,13 @@
 #define __SERVICE_DISOVERY_H__
 
 #include "UUID.h"
+#include "UUIDSet.h"
 #include "Gap.h"
 #include "GattAttribute.h"
 
 class DiscoveredService;
 class DiscoveredCharacteristic;
+struct DiscoveredDescriptor;
 
 class ServiceDiscovery {
 public:
@@ -50,6 +52,16 @@ public:
      */
     typedef void (*CharacteristicCallback_t)(const DiscoveredCharacteristic *);
 
+    /**
+     * Callback type for when a characteristic descriptor is found during
+     * descriptor-discovery. The receiving function is passed in a pointer to a
+     * DiscoveredDescriptor object which will remain valid for the lifetime
+     * of the callback. Memory for this object is owned by the BLE_API eventing
+     * framework. The application can safely make a persistent shallow-copy of
+     * this object in order to work with the descriptor beyond the callback.
+     */
+    typedef void (*DescriptorCallback_t)(const DiscoveredDescriptor *);
+
     /**
      * Callback type for when serviceDiscovery terminates.
      */
@@ -116,6 +128,28 @@ public:
                                const UUID               &matchingServiceUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
                                const UUID               &matchingCharacteristicUUIDIn = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) = 0;
 
+    /**
+     * Launch service discovery for sets of services and characteristics, as
+     * described for GattClient::launchServiceDiscovery(). By default, sets of
+     * at most one UUID are passed on to the single-UUID variant.
+     */
+    virtual ble_error_t launch(Gap::Handle_t             connectionHandle,
+                               ServiceCallback_t         sc,
+                               CharacteristicCallback_t  cc,
+                               const UUIDSet            &matchingServiceUUIDs,
+                               const UUIDSet            &matchingCharacteristicUUIDs) {
+        if (matchingServiceUUIDs.isTruncated() || matchingCharacteristicUUIDs.isTruncated()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if ((matchingServiceUUIDs.getCount() > 1) || (matchingCharacteristicUUIDs.getCount() > 1)) {
+            return BLE_ERROR_NOT_IMPLEMENTED; /* Requesting action from porter(s): override this API if this capability is supported. */
+        }
+
+        return launch(connectionHandle, sc, cc,
+                      matchingServiceUUIDs.isEmpty() ? UUID(UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) : matchingServiceUUIDs.getUUID(0),
+                      matchingCharacteristicUUIDs.isEmpty() ? UUID(UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN)) : matchingCharacteristicUUIDs.getUUID(0));
+    }
+
     /**
      * Is service-discovery currently active?
      */
@@ -22,16 +22,30 @@
 
 #include "blecommon.h"
 
+/**
+ * A Bluetooth UUID. Whatever the width it was created with (16, 32 or 128
+ * bits), a UUID is held in its canonical 128-bit form, with the short forms
+ * expanded over the Bluetooth Base UUID. UUIDs therefore compare equal
+ * across widths: UUID(0x180F) equals the 128-bit 0000180F-0000-1000-8000-
+ * 00805F9B34FB. Comparison takes four word compares, without branching on
+ * the width, and hash() is consistent with it.
+ *
+ * The width a UUID was created with is kept for encoding it: a 16-bit UUID
+ * goes over ATT in 2 bytes. A 32-bit UUID is encoded in its 128-bit form, as
+ * ATT has no 32-bit form; the compact width is for advertising data.
+ */
 class UUID {
 public:
     enum UUID_Type_t {
         UUID_TYPE_SHORT = 0,    // Short BLE UUID
-        UUID_TYPE_LONG  = 1     // Full 128-bit UUID
+        UUID_TYPE_LONG  = 1     // Full 128-bit UUID, or a 32-bit UUID in its 128-bit form
     };
 
     typedef uint16_t      ShortUUIDBytes_t;
+    typedef uint32_t      UUID32Bytes_t;
 
     static const unsigned LENGTH_OF_LONG_UUID = 16;
+    static const unsigned LENGTH_OF_UUID32    = 4;
     typedef uint8_t       LongUUIDBytes_t[LENGTH_OF_LONG_UUID];
 
 public:
@@ -44,7 +58,7 @@ public:
      * @param longUUID
      *          The 128-bit (16-byte) UUID value, MSB first (big-endian).
      */
-    UUID(const LongUUIDBytes_t longUUID) : type(UUID_TYPE_LONG), baseUUID(), shortUUID(0) {
+    UUID(const LongUUIDBytes_t longUUID) {
         setupLong(longUUID);
     }
 
@@ -72,72 +86,137 @@ public:
      *       vendor-specific UUIDs. In these cases, you’ll need to use the full
      *       128-bit UUID value at all times.
      *
-     * @note we don't yet support 32-bit shortened UUIDs.
+     * @note 32-bit UUIDs are created with fromUUID32(), as a constructor
+     *       would make UUID(0x180F) ambiguous.
      */
-    UUID(ShortUUIDBytes_t shortUUID) : type(UUID_TYPE_SHORT), baseUUID(), shortUUID(shortUUID) {
-        /* empty */
+    UUID(ShortUUIDBytes_t shortUUID) {
+        setupBaseDerived(shortUUID, sizeof(ShortUUIDBytes_t));
     }
 
-    UUID(const UUID &source) {
-        type      = source.type;
-        shortUUID = source.shortUUID;
-        memcpy(baseUUID, source.baseUUID, LENGTH_OF_LONG_UUID);
+    UUID(void) {
+        setupBaseDerived(BLE_UUID_UNKNOWN, sizeof(ShortUUIDBytes_t));
     }
 
-    UUID(void) : type(UUID_TYPE_SHORT), shortUUID(BLE_UUID_UNKNOWN) {
-        /* empty */
+    /**
+     * Creates a new 32-bit UUID, which stands for xxxxxxxx-0000-1000-8000-
+     * 00805F9B34FB.
+     */
+    static UUID fromUUID32(UUID32Bytes_t uuid32) {
+        UUID uuid;
+        uuid.setupBaseDerived(uuid32, LENGTH_OF_UUID32);
+        return uuid;
     }
 
     /**
      * Fill in a 128-bit UUID; this is useful when UUID isn't known at the time of object construction.
      */
     void setupLong(const LongUUIDBytes_t longUUID) {
-        type      = UUID_TYPE_LONG;
-        memcpy(baseUUID, longUUID, LENGTH_OF_LONG_UUID);
-        shortUUID = (uint16_t)((longUUID[2] << 8) | (longUUID[3]));
+        memcpy(canonical.bytes, longUUID, LENGTH_OF_LONG_UUID);
+        shortUUID     = (uint16_t)((longUUID[2] << 8) | (longUUID[3]));
+        compactLength = LENGTH_OF_LONG_UUID;
     }
 
 public:
-    UUID_Type_t       shortOrLong(void)  const {return type;     }
+    UUID_Type_t       shortOrLong(void)  const {
+        return (compactLength == sizeof(ShortUUIDBytes_t)) ? UUID_TYPE_SHORT : UUID_TYPE_LONG;
+    }
+
+    /**
+     * For a 16-bit UUID, the two bytes of the value in host order; for
+     * others, the 128-bit form, MSB first.
+     */
     const uint8_t    *getBaseUUID(void)  const {
-        if (type == UUID_TYPE_SHORT) {
+        if (compactLength == sizeof(ShortUUIDBytes_t)) {
             return (const uint8_t*)&shortUUID;
         } else {
-            return baseUUID;
+            return canonical.bytes;
         }
     }
 
+    /**
+     * The canonical 128-bit form, MSB first, whatever the width.
+     */
+    const uint8_t    *getLongUUID(void)  const {return canonical.bytes;}
+
     ShortUUIDBytes_t  getShortUUID(void) const {return shortUUID;}
-    uint8_t           getLen(void)       const {
-        return ((type == UUID_TYPE_SHORT) ? sizeof(ShortUUIDBytes_t) : LENGTH_OF_LONG_UUID);
+
+    /**
+     * The first four bytes of the 128-bit form, which is the value of a
+     * 32-bit UUID.
+     */
+    UUID32Bytes_t     getUUID32(void)    const {
+        return ((UUID32Bytes_t)canonical.bytes[0] << 24) | ((UUID32Bytes_t)canonical.bytes[1] << 16) |
+               ((UUID32Bytes_t)canonical.bytes[2] << 8)  | canonical.bytes[3];
     }
 
-    bool operator== (const UUID &other) const {
-        if ((this->type == UUID_TYPE_SHORT) && (other.type == UUID_TYPE_SHORT) &&
-            (this->shortUUID == other.shortUUID)) {
-            return true;
-        }
+    /**
+     * The length of the UUID over ATT: 2 or 16.
+     */
+    uint8_t           getLen(void)       const {
+        return ((compactLength == sizeof(ShortUUIDBytes_t)) ? sizeof(ShortUUIDBytes_t) : LENGTH_OF_LONG_UUID);
+    }
 
-        if ((this->type == UUID_TYPE_LONG) && (other.type == UUID_TYPE_LONG) &&
-            (memcmp(this->baseUUID, other.baseUUID, LENGTH_OF_LONG_UUID) == 0)) {
-            return true;
-        }
+    /**
+     * The width the UUID was created with: 2, 4 or 16 bytes.
+     */
+    uint8_t           getCompactLength(void) const {return compactLength;}
 
-        return false;
+    bool operator== (const UUID &other) const {
+        return ((canonical.words[0] ^ other.canonical.words[0]) | (canonical.words[1] ^ other.canonical.words[1]) |
+                (canonical.words[2] ^ other.canonical.words[2]) | (canonical.words[3] ^ other.canonical.words[3])) == 0;
     }
 
     bool operator!= (const UUID &other) const {
         return !(*this == other);
     }
 
+    /**
+     * A 64-bit hash of the canonical form, in 32-bit arithmetic; equal UUIDs
+     * hash alike, whatever their widths. It depends on the byte order of the
+     * host, so it isn't to be stored or sent.
+     */
+    uint64_t hash(void) const {
+        uint32_t low  = mix(canonical.words[0] ^ rotate(canonical.words[1], 16) ^ 0x9E3779B9u);
+        uint32_t high = mix(canonical.words[2] ^ rotate(canonical.words[3], 16) ^ low);
+        return ((uint64_t)high << 32) | mix(low ^ high);
+    }
+
+private:
+    /* The Base UUID, with the leading 32 bits in place. */
+    void setupBaseDerived(UUID32Bytes_t value, uint8_t length) {
+        static const LongUUIDBytes_t BASE_UUID = {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB
+        };
+        memcpy(canonical.bytes, BASE_UUID, LENGTH_OF_LONG_UUID);
+        canonical.bytes[0] = (uint8_t)(value >> 24);
+        canonical.bytes[1] = (uint8_t)(value >> 16);
+        canonical.bytes[2] = (uint8_t)(value >> 8);
+        canonical.bytes[3] = (uint8_t)value;
+        shortUUID          = (uint16_t)value;
+        compactLength      = length;
+    }
+
+    static uint32_t rotate(uint32_t value, unsigned bits) {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    /* the finalizer of MurmurHash3 */
+    static uint32_t mix(uint32_t value) {
+        value ^= value >> 16;
+        value *= 0x85EBCA6Bu;
+        value ^= value >> 13;
+        value *= 0xC2B2AE35u;
+        value ^= value >> 16;
+        return value;
+    }
+
 private:
-    UUID_Type_t      type;      // UUID_TYPE_SHORT or UUID_TYPE_LONG
-    LongUUIDBytes_t  baseUUID;  /* the base of the long UUID (if
-                            * used). Note: bytes 12 and 13 (counting from LSB)
-                            * are zeroed out to allow comparison with other long
-                            * UUIDs which differ only in the 16-bit relative
-                            * part.*/
-    ShortUUIDBytes_t shortUUID; // 16 bit uuid (byte 2-3 using with base)
+    union {
+        LongUUIDBytes_t bytes;  /* MSB first */
+        uint32_t        words[LENGTH_OF_LONG_UUID / sizeof(uint32_t)];
+    }                canonical;
+    ShortUUIDBytes_t shortUUID;     // 16 bit uuid (bytes 2-3 of the canonical form)
+    uint8_t          compactLength; // the width the UUID was created with, in bytes
 };
 
 #endif // ifndef __UUID_H__
\ No newline at end of file
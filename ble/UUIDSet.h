@@ -0,0 +1,131 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UUID_SET_H__
+#define __UUID_SET_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include "UUID.h"
+
+#ifndef BLE_UUID_SET_MAX_SIZE
+#define BLE_UUID_SET_MAX_SIZE 16 /**< UUIDs in a discovery filter. */
+#endif
+#if BLE_UUID_SET_MAX_SIZE > 32
+#error "UUID sets are tracked in 32-bit masks"
+#endif
+
+/**
+ * A set of UUIDs, as used to filter discovery. The UUIDs stay in the
+ * caller's array, which must remain valid for as long as the set is in use;
+ * the set adds an open-addressed hash index over them, one byte per slot,
+ * so that a lookup typically compares against a single candidate.
+ *
+ * An empty set matches every UUID, as the wildcard UUID does for the
+ * single-UUID filters. Each distinct UUID has an index, its position in the
+ * array, and a bit in getMembers(); callers use these to track which
+ * members have been seen.
+ */
+class UUIDSet {
+public:
+    static const unsigned MAX_SIZE  = BLE_UUID_SET_MAX_SIZE;
+    static const int      NOT_FOUND = -1;
+
+public:
+    /**
+     * The empty set.
+     */
+    UUIDSet() : uuids(NULL), count(0), members(0), truncated(false) {
+        memset(slots, 0, sizeof(slots));
+    }
+
+    /**
+     * @param[in] uuidsIn
+     *              The members; the array isn't copied. Duplicates are
+     *              allowed, but only the first of each is a member.
+     * @param[in] countIn
+     *              At most MAX_SIZE; a longer array is cut short and the
+     *              set marked as truncated, which discovery rejects.
+     */
+    UUIDSet(const UUID *uuidsIn, unsigned countIn) : uuids(uuidsIn), count(0), members(0), truncated(countIn > MAX_SIZE) {
+        memset(slots, 0, sizeof(slots));
+        count = (uint8_t)((countIn < MAX_SIZE) ? countIn : MAX_SIZE);
+        for (unsigned i = 0; i < count; i++) {
+            unsigned slot = hash(uuids[i]) % TABLE_SIZE;
+            while ((slots[slot] != 0) && !(uuids[slots[slot] - 1] == uuids[i])) {
+                slot = (slot + 1) % TABLE_SIZE;
+            }
+            if (slots[slot] == 0) {
+                slots[slot]  = (uint8_t)(i + 1);
+                members     |= (uint32_t)1 << i;
+            }
+        }
+    }
+
+    bool     isEmpty(void)    const {return count == 0;}
+    unsigned getCount(void)   const {return count;     }
+    uint32_t getMembers(void) const {return members;   }
+
+    /**
+     * Were UUIDs beyond MAX_SIZE left out of the set?
+     */
+    bool     isTruncated(void) const {return truncated;}
+
+    const UUID &getUUID(unsigned index) const {
+        return uuids[index];
+    }
+
+    /**
+     * @return the index of a UUID, or NOT_FOUND if it isn't a member.
+     */
+    int find(const UUID &uuid) const {
+        if (count == 0) {
+            return NOT_FOUND;
+        }
+        for (unsigned slot = hash(uuid) % TABLE_SIZE; slots[slot] != 0; slot = (slot + 1) % TABLE_SIZE) {
+            if (uuids[slots[slot] - 1] == uuid) {
+                return slots[slot] - 1;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    /**
+     * Does a UUID pass the filter? Everything passes an empty set.
+     */
+    bool matches(const UUID &uuid) const {
+        return (count == 0) || (find(uuid) != NOT_FOUND);
+    }
+
+    /**
+     * Consistent with UUID::operator==(): equal UUIDs hash alike.
+     */
+    static uint32_t hash(const UUID &uuid) {
+        return (uint32_t)uuid.hash();
+    }
+
+private:
+    static const unsigned TABLE_SIZE = 2 * MAX_SIZE; /* at most half full, so probe sequences stay short */
+
+    const UUID *uuids;
+    uint8_t     count;
+    uint32_t    members;
+    bool        truncated;
+    uint8_t     slots[TABLE_SIZE];   /* index + 1 of the UUID in each slot; 0 for an empty one */
+};
+
+#endif // ifndef __UUID_SET_H__
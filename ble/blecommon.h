@@ -41,6 +41,8 @@ enum {
 /* GATT specific UUIDs */
     BLE_UUID_GATT                                = 0x1801, /**< Generic Attribute Profile. */
     BLE_UUID_GATT_CHARACTERISTIC_SERVICE_CHANGED = 0x2A05, /**< Service Changed Characteristic. */
+    BLE_UUID_GATT_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES = 0x2B29, /**< Client Supported Features Characteristic. */
+    BLE_UUID_GATT_CHARACTERISTIC_DATABASE_HASH   = 0x2B2A, /**< Database Hash Characteristic. */
 
 /* GAP specific UUIDs */
     BLE_UUID_GAP                                 = 0x1800, /**< Generic Access Profile. */
@@ -129,6 +131,13 @@ enum ble_error_t {
 /** @brief Default MTU size. */
 static const unsigned BLE_GATT_MTU_SIZE_DEFAULT = 23;
 
+/** @brief Largest ATT MTU negotiated by the local device. Buffers which carry
+ *  attribute values over the air are sized from this; stacks supporting larger
+ *  MTUs may raise it from the build configuration. */
+#ifndef BLE_GATT_MTU_SIZE_MAX
+#define BLE_GATT_MTU_SIZE_MAX 23
+#endif
+
 enum HVXType_t {
     BLE_HVX_NOTIFICATION = 0x01,  /**< Handle Value Notification. */
     BLE_HVX_INDICATION   = 0x02,  /**< Handle Value Indication. */
@@ -0,0 +1,56 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FILE_GATT_CACHE_STORAGE_H__
+#define __FILE_GATT_CACHE_STORAGE_H__
+
+#include "ble/GattCacheStorage.h"
+
+#ifndef BLE_FILE_GATT_CACHE_MAX_PATH
+#define BLE_FILE_GATT_CACHE_MAX_PATH 256 /**< Length of the paths of record files, including the directory. */
+#endif
+
+/**
+ * GattCacheStorage for host builds: each record is a file named
+ * gatt-<type>-<address>.bin in a given directory, which must exist. Records
+ * are written to a temporary file and renamed into place, so a record is
+ * either replaced completely or not at all.
+ */
+class FileGattCacheStorage : public GattCacheStorage {
+public:
+    /**
+     * @param[in] directory
+     *              Where the records are kept; the string must outlive the object.
+     */
+    FileGattCacheStorage(const char *directory);
+
+    virtual ble_error_t load(const Key_t key, uint8_t *buffer, uint16_t *lengthP);
+    virtual ble_error_t store(const Key_t key, const uint8_t *data, uint16_t length);
+    virtual ble_error_t erase(const Key_t key);
+
+private:
+    bool makePath(const Key_t key, const char *suffix, char *path) const;
+
+private:
+    const char *directory;
+
+private:
+    /* disallow copy and assignment */
+    FileGattCacheStorage(const FileGattCacheStorage &);
+    FileGattCacheStorage& operator=(const FileGattCacheStorage &);
+};
+
+#endif // ifndef __FILE_GATT_CACHE_STORAGE_H__
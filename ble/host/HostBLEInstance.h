@@ -0,0 +1,216 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_BLE_INSTANCE_H__
+#define __HOST_BLE_INSTANCE_H__
+
+#include "ble/BLE.h"
+#include "HostGap.h"
+#include "HostGattServer.h"
+#include "HostGattClient.h"
+
+/* The following limits may be overridden from the build configuration. */
+#ifndef BLE_HOST_MAX_INSTANCES
+#define BLE_HOST_MAX_INSTANCES     8  /**< Instances which can coexist in a process. */
+#endif
+#ifndef BLE_HOST_MAX_LINKS
+#define BLE_HOST_MAX_LINKS         8  /**< Connections between instances, process-wide. */
+#endif
+#ifndef BLE_HOST_EVENT_QUEUE_DEPTH
+#define BLE_HOST_EVENT_QUEUE_DEPTH 32 /**< Pending events per instance. */
+#endif
+#ifndef BLE_HOST_TX_BUFFERS
+#define BLE_HOST_TX_BUFFERS        8  /**< Notifications and write commands in flight per instance. */
+#endif
+
+class HostSecurityManager : public SecurityManager {
+public:
+    HostSecurityManager() : SecurityManager() {
+        /* empty */
+    }
+};
+
+/**
+ * A software BLEInstanceBase for host (Linux) builds.
+ *
+ * Any number of instances (up to BLE_HOST_MAX_INSTANCES) can coexist in a
+ * process; pass each to BLE(BLEInstanceBase *). The init() of any further
+ * instance fails with BLE_ERROR_NO_MEM. The instances share a simulated air:
+ * an instance advertising through its Gap can be found by the others while
+ * they scan, and connected to. Over a link, the GattClient of one instance
+ * talks to the GattServer of the other. Nothing happens behind the
+ * application's back: each instance has a bounded event queue, which it
+ * processes in waitForEvent(), and every callback is invoked from there.
+ *
+ * Like a controller, an instance has a fixed number of transmit buffers
+ * (BLE_HOST_TX_BUFFERS) for notifications and write commands; sending fails
+ * with BLE_ERROR_NO_MEM when they are exhausted, or when the peer's event
+ * queue is full, and buffers are returned (with onDataSent()) as the local
+ * instance processes its events. This provides realistic flow control for
+ * throughput measurements.
+ *
+ * The build picks up createBLEInstance() from HostBLEInstance.cpp, which
+ * returns a default instance, when TARGET_LIKE_LINUX is defined.
+ */
+class HostBLEInstance : public BLEInstanceBase {
+public:
+    enum EventType_t {
+        EVENT_CONNECTION,             /**< A link was established; op holds the local Gap::Role_t. */
+        EVENT_DISCONNECTION,          /**< A link was terminated; op holds the reason. */
+        EVENT_ATT_MTU_CHANGE,         /**< offset holds the new ATT MTU. */
+        EVENT_WRITE_REQUEST,          /**< To a server; op holds the GattWriteCallbackParams::WriteOp_t. */
+        EVENT_READ_REQUEST,           /**< To a server. */
+        EVENT_DATA_SENT,              /**< Transmit buffers returned; offset holds the count. */
+        EVENT_READ_RESPONSE,          /**< To a client. */
+        EVENT_WRITE_RESPONSE,         /**< To a client. */
+        EVENT_HVX,                    /**< To a client; op holds the HVXType_t. */
+        EVENT_ATT_REQUEST,            /**< To a server; data holds an ATT request PDU, for the discovery procedures. */
+        EVENT_READ_MULTIPLE_REQUEST,  /**< To a server; data holds the handles, op is set for Read Multiple Variable. */
+        EVENT_READ_MULTIPLE_RESPONSE, /**< To a client; op holds the ble_error_t. */
+        EVENT_ATT_RESPONSE,           /**< To a client; data holds the response PDU to an EVENT_ATT_REQUEST. */
+        EVENT_ERROR_RESPONSE          /**< To a client, in place of a read or write response; op holds the ATT error code. */
+    };
+
+    static const unsigned MAX_EVENT_DATA_LEN = (BLE_GATT_MTU_SIZE_MAX > GAP_ADVERTISING_DATA_MAX_PAYLOAD) ?
+                                                   BLE_GATT_MTU_SIZE_MAX : GAP_ADVERTISING_DATA_MAX_PAYLOAD;
+
+    struct Event_t {
+        uint8_t                 type;
+        uint8_t                 op;
+        Gap::Handle_t           connHandle;
+        GattAttribute::Handle_t handle;
+        uint16_t                offset;
+        uint16_t                len;
+        uint8_t                 data[MAX_EVENT_DATA_LEN];
+    };
+
+public:
+    HostBLEInstance();
+    virtual ~HostBLEInstance();
+
+    virtual ble_error_t init(void);
+    virtual ble_error_t shutdown(void);
+    virtual const char *getVersion(void);
+
+    virtual Gap&                   getGap()                   {return gap;            }
+    virtual const Gap&             getGap() const             {return gap;            }
+    virtual GattServer&            getGattServer()            {return gattServer;     }
+    virtual const GattServer&      getGattServer() const      {return gattServer;     }
+    virtual GattClient&            getGattClient()            {return gattClient;     }
+    virtual SecurityManager&       getSecurityManager()       {return securityManager;}
+    virtual const SecurityManager& getSecurityManager() const {return securityManager;}
+
+    /**
+     * Process all pending events, delivering callbacks. Unlike on a device
+     * this doesn't sleep; it returns at once if nothing is pending.
+     */
+    virtual void waitForEvent(void);
+
+public:
+    HostGap        &getHostGap(void)        {return gap;       }
+    HostGattServer &getHostGattServer(void) {return gattServer;}
+    HostGattClient &getHostGattClient(void) {return gattClient;}
+
+    bool     hasPendingEvents(void) const {return eventCount != 0; }
+    unsigned getTxBuffersFree(void) const {return txBuffersFree;   }
+
+    /**
+     * Queue an event for this instance.
+     *
+     * @return BLE_STACK_BUSY if the event queue is full.
+     */
+    ble_error_t post(const Event_t &event);
+
+    /**
+     * Send an event to the peer on a link, through one of the local transmit
+     * buffers; the buffer is returned through an EVENT_DATA_SENT once the
+     * local instance processes its events.
+     *
+     * @return BLE_ERROR_NO_MEM if no buffer is free or either queue is full.
+     */
+    ble_error_t transmit(HostBLEInstance &peer, const Event_t &event);
+
+    /**
+     * The instance at the other end of a link; NULL if there is no such link.
+     */
+    HostBLEInstance *getPeer(Gap::Handle_t connectionHandle) const;
+
+    /**
+     * Enumerate the links of this instance, in either role.
+     *
+     * @return the number of handles written to the array.
+     */
+    unsigned getLinks(Gap::Handle_t *handles, unsigned maxHandles) const;
+
+public:
+    /**
+     * Process the events of all instances until none are pending, or for at
+     * most a given number of rounds (scanning instances keep producing
+     * advertisement reports).
+     *
+     * @return the number of rounds in which events were processed.
+     */
+    static unsigned processAll(unsigned maxRounds = 0xFFFF);
+
+    static HostBLEInstance *getInstance(unsigned index) {
+        return (index < BLE_HOST_MAX_INSTANCES) ? instances[index] : NULL;
+    }
+
+    /**
+     * Establish a link between a central and an advertising peripheral. The
+     * peripheral stops advertising; EVENT_CONNECTION is posted to both.
+     */
+    static ble_error_t openLink(HostBLEInstance &central, HostBLEInstance &peripheral);
+
+    /**
+     * Terminate a link; EVENT_DISCONNECTION is posted to both ends.
+     */
+    static ble_error_t closeLink(Gap::Handle_t connectionHandle, Gap::DisconnectionReason_t reason);
+
+private:
+    void dispatch(const Event_t &event);
+
+private:
+    struct Link_t {
+        Gap::Handle_t    handle;
+        HostBLEInstance *central;
+        HostBLEInstance *peripheral;
+    };
+
+    static Link_t *findLink(Gap::Handle_t connectionHandle);
+
+    static HostBLEInstance *instances[BLE_HOST_MAX_INSTANCES];
+    static Link_t           links[BLE_HOST_MAX_LINKS];
+    static Gap::Handle_t    nextConnectionHandle;
+
+private:
+    HostGap             gap;
+    HostGattServer      gattServer;
+    HostGattClient      gattClient;
+    HostSecurityManager securityManager;
+
+    uint8_t             txBuffersFree;
+    uint16_t            eventHead;
+    uint16_t            eventCount;
+    Event_t             events[BLE_HOST_EVENT_QUEUE_DEPTH];
+
+private:
+    /* disallow copy and assignment */
+    HostBLEInstance(const HostBLEInstance &);
+    HostBLEInstance& operator=(const HostBLEInstance &);
+};
+
+#endif // ifndef __HOST_BLE_INSTANCE_H__
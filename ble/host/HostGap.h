@@ -0,0 +1,79 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_GAP_H__
+#define __HOST_GAP_H__
+
+#include "ble/Gap.h"
+
+class HostBLEInstance;
+
+/**
+ * Gap for the in-memory host backend. Advertising and scanning are virtual:
+ * while an instance scans, every call to its waitForEvent() delivers one
+ * advertisement report (and scan response, for active scans) from each
+ * advertising instance in the process. connect() links to an advertising
+ * instance by address.
+ */
+class HostGap : public Gap {
+public:
+    HostGap(HostBLEInstance &instance);
+
+    virtual ble_error_t setAddress(AddressType_t type, const Address_t address);
+    virtual ble_error_t getAddress(AddressType_t *typeP, Address_t address);
+
+    virtual ble_error_t stopAdvertising(void);
+    virtual ble_error_t stopScan(void);
+
+    virtual ble_error_t connect(const Address_t           peerAddr,
+                                Gap::AddressType_t        peerAddrType,
+                                const ConnectionParams_t *connectionParams,
+                                const GapScanningParams  *scanParams);
+    virtual ble_error_t disconnect(Handle_t connectionHandle, DisconnectionReason_t reason);
+    virtual ble_error_t disconnect(DisconnectionReason_t reason);
+
+public:
+    bool isAdvertising(void) const {return state.advertising;}
+    bool isScanning(void)    const {return scanningActive;   }
+
+    /**
+     * Deliver one round of advertisement reports from the other instances,
+     * if scanning.
+     */
+    void processScan(void);
+
+protected:
+    virtual ble_error_t startRadioScan(const GapScanningParams &scanningParams);
+
+private:
+    virtual ble_error_t setAdvertisingData(const GapAdvertisingData &advData, const GapAdvertisingData &scanResponse);
+    virtual ble_error_t startAdvertising(const GapAdvertisingParams &params);
+
+private:
+    HostBLEInstance                        &instance;
+    AddressType_t                           addressType;
+    Address_t                               address;
+    GapAdvertisingParams::AdvertisingType_t advertisingType;
+    GapAdvertisingData                      advertisedPayload;
+    GapAdvertisingData                      advertisedScanResponse;
+
+private:
+    /* disallow copy and assignment */
+    HostGap(const HostGap &);
+    HostGap& operator=(const HostGap &);
+};
+
+#endif // ifndef __HOST_GAP_H__
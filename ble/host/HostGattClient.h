@@ -0,0 +1,115 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_GATT_CLIENT_H__
+#define __HOST_GATT_CLIENT_H__
+
+#include "ble/GattClient.h"
+#include "ble/GattDiscoveryEngine.h"
+
+class HostBLEInstance;
+
+/**
+ * GattClient for the in-memory host backend. Reads and writes are posted to
+ * the GattServer of the linked instance and complete when that instance
+ * processes its events. Service and descriptor discovery run on
+ * GattDiscoveryEngine, whose requests are answered by the peer's GattServer
+ * in the same way, so they take as many round trips as over the air and
+ * proceed on several links at once.
+ */
+class HostGattClient : public GattClient {
+public:
+    HostGattClient(HostBLEInstance &instance);
+
+    virtual ble_error_t launchServiceDiscovery(Gap::Handle_t                               connectionHandle,
+                                               ServiceDiscovery::ServiceCallback_t         sc                           = NULL,
+                                               ServiceDiscovery::CharacteristicCallback_t  cc                           = NULL,
+                                               const UUID                                 &matchingServiceUUID          = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                               const UUID                                 &matchingCharacteristicUUIDIn = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                               ServiceDiscovery::TerminationCallback_t     tc                           = NULL);
+    virtual ble_error_t launchServiceDiscovery(Gap::Handle_t                               connectionHandle,
+                                               ServiceDiscovery::ServiceCallback_t         sc,
+                                               ServiceDiscovery::CharacteristicCallback_t  cc,
+                                               const UUIDSet                              &matchingServiceUUIDs,
+                                               const UUIDSet                              &matchingCharacteristicUUIDs,
+                                               ServiceDiscovery::TerminationCallback_t     tc = NULL);
+    virtual bool        isServiceDiscoveryActive(void) const;
+    virtual bool        isServiceDiscoveryActive(Gap::Handle_t connectionHandle) const;
+    virtual void        terminateServiceDiscovery(void);
+    virtual void        terminateServiceDiscovery(Gap::Handle_t connectionHandle);
+    virtual void        onServiceDiscoveryTermination(ServiceDiscovery::TerminationCallback_t callback);
+    virtual ble_error_t discoverCharacteristicDescriptors(const DiscoveredCharacteristic          &characteristic,
+                                                          ServiceDiscovery::DescriptorCallback_t   callback,
+                                                          const UUID                              &matchingUUID,
+                                                          ServiceDiscovery::TerminationCallback_t  tc = NULL);
+    virtual ble_error_t discoverDescriptors(Gap::Handle_t                            connectionHandle,
+                                            GattAttribute::Handle_t                  startHandle,
+                                            GattAttribute::Handle_t                  endHandle,
+                                            ServiceDiscovery::DescriptorCallback_t   callback,
+                                            const UUID                              &matchingUUID = UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                            ServiceDiscovery::TerminationCallback_t  tc           = NULL);
+
+    virtual ble_error_t read(Gap::Handle_t connHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset) const;
+    virtual ble_error_t readMultiple(Gap::Handle_t                  connHandle,
+                                     const GattAttribute::Handle_t *handles,
+                                     uint8_t                        count,
+                                     bool                           variableLength) const;
+    virtual ble_error_t write(GattClient::WriteOp_t    cmd,
+                              Gap::Handle_t            connHandle,
+                              GattAttribute::Handle_t  attributeHandle,
+                              size_t                   length,
+                              const uint8_t           *value) const;
+    virtual ble_error_t exchangeMtu(Gap::Handle_t connHandle, uint16_t clientRxMtu = BLE_GATT_MTU_SIZE_MAX);
+
+    /* Events, as delivered by HostBLEInstance. */
+public:
+    /**
+     * A response to a discovery request.
+     */
+    void processAttResponse(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length);
+
+    /**
+     * End discovery on a terminated link; called after the disconnection
+     * callbacks have run.
+     */
+    void processDisconnection(Gap::Handle_t connectionHandle);
+
+    void reset(void);
+
+private:
+    /* Sends the engine's requests to the GattServer of the peer. */
+    class HostDiscoveryEngine : public GattDiscoveryEngine {
+    public:
+        HostDiscoveryEngine(HostGattClient &client, HostBLEInstance &instance);
+
+    protected:
+        virtual ble_error_t sendRequest(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length);
+
+    private:
+        HostBLEInstance &instance;
+    };
+
+private:
+    HostBLEInstance     &instance;
+    HostDiscoveryEngine  discovery;
+
+private:
+    /* disallow copy and assignment */
+    HostGattClient(const HostGattClient &);
+    HostGattClient& operator=(const HostGattClient &);
+};
+
+#endif // ifndef __HOST_GATT_CLIENT_H__
@@ -0,0 +1,123 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HOST_GATT_SERVER_H__
+#define __HOST_GATT_SERVER_H__
+
+#include "ble/GattServer.h"
+#include "ble/GattAttributeDatabase.h"
+
+#ifndef BLE_HOST_MAX_CHARACTERISTICS
+#define BLE_HOST_MAX_CHARACTERISTICS 24 /**< Characteristics whose authorization callbacks are honoured. */
+#endif
+
+class HostBLEInstance;
+
+/**
+ * GattServer for the in-memory host backend, backed by a
+ * GattAttributeDatabase. Requests arrive from the GattClient of a linked
+ * instance through the process* entry points below; writes to CCCDs are
+ * reported through handleSubscriptionEvent(), and write() sends
+ * notifications to subscribed links.
+ */
+class HostGattServer : public GattServer {
+public:
+    HostGattServer(HostBLEInstance &instance);
+
+    virtual ble_error_t addService(GattService &service);
+    virtual ble_error_t addService(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles);
+
+    virtual ble_error_t read(GattAttribute::Handle_t attributeHandle, uint8_t buffer[], uint16_t *lengthP);
+    virtual ble_error_t read(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint8_t *buffer, uint16_t *lengthP);
+    virtual ble_error_t write(GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size, bool localOnly = false);
+    virtual ble_error_t write(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size, bool localOnly = false);
+    virtual ble_error_t sendUpdate(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size);
+
+    virtual ble_error_t areUpdatesEnabled(const GattCharacteristic &characteristic, bool *enabledP);
+    virtual ble_error_t areUpdatesEnabled(Gap::Handle_t connectionHandle, const GattCharacteristic &characteristic, bool *enabledP);
+
+    virtual ble_error_t getMaxLength(GattAttribute::Handle_t attributeHandle, uint16_t *maxLengthP) {
+        if (!database.isValidHandle(attributeHandle)) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        *maxLengthP = database.getMaxLength(attributeHandle);
+        return BLE_ERROR_NONE;
+    }
+
+    virtual ble_error_t getDatabaseHash(uint8_t hash[16]) {
+        database.getHash(hash);
+        return BLE_ERROR_NONE;
+    }
+
+    virtual bool isOnDataReadAvailable() const {
+        return true;
+    }
+
+public:
+    const GattAttributeDatabase &getDatabase(void) const {
+        return database;
+    }
+
+    /**
+     * Remove all services.
+     */
+    void reset(void);
+
+    /* Requests from the peer, as delivered by HostBLEInstance. */
+public:
+    void processWriteRequest(Gap::Handle_t                       connectionHandle,
+                             GattAttribute::Handle_t             attributeHandle,
+                             GattWriteCallbackParams::WriteOp_t  writeOp,
+                             uint16_t                            offset,
+                             const uint8_t                      *data,
+                             uint16_t                            len);
+    void processReadRequest(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset);
+    void processReadMultipleRequest(Gap::Handle_t connectionHandle, const uint8_t *handles, uint16_t count, bool variableLength);
+    void processAttRequest(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length);
+    void processDataSentEvent(unsigned count) {
+        handleDataSentEvent(count);
+    }
+
+private:
+    uint16_t            buildServiceList(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle, uint8_t *buffer, uint16_t capacity) const;
+    uint16_t            buildInformationList(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle, uint8_t *buffer, uint16_t capacity) const;
+    uint16_t            buildAttributeList(Gap::Handle_t            connectionHandle,
+                                           GattAttribute::Handle_t  startHandle,
+                                           GattAttribute::Handle_t  endHandle,
+                                           const UUID              &type,
+                                           uint8_t                 *buffer,
+                                           uint16_t                 capacity,
+                                           GattAttribute::Handle_t *errorHandleP,
+                                           uint8_t                 *errorCodeP);
+    GattAuthCallbackReply_t readValue(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset, uint8_t *buffer, uint16_t *lengthP);
+    void                sendErrorResponse(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, GattAuthCallbackReply_t error);
+    ble_error_t         sendNotification(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size);
+    GattCharacteristic *findCharacteristic(GattAttribute::Handle_t valueHandle);
+    GattAttribute::Handle_t findValueHandleOfDescriptor(GattAttribute::Handle_t descriptorHandle) const;
+
+private:
+    HostBLEInstance       &instance;
+    GattAttributeDatabase  database;
+    GattCharacteristic    *characteristics[BLE_HOST_MAX_CHARACTERISTICS];
+    uint8_t                characteristicTableSize;
+
+private:
+    /* disallow copy and assignment */
+    HostGattServer(const HostGattServer &);
+    HostGattServer& operator=(const HostGattServer &);
+};
+
+#endif // ifndef __HOST_GATT_SERVER_H__
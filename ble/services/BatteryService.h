@@ -26,17 +26,34 @@
 * Battery Level Char:  https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.battery_level.xml
 */
 class BatteryService {
+public:
+    /**
+     * @brief Signature for an on-demand source of the battery level; see the constructor.
+     */
+    typedef uint8_t (*LevelProvider_t)(void);
+
 public:
     /**
     * @param[ref] _ble
     *               BLE object for the underlying controller.
     * @param[in] level
     *               8bit batterly level. Usually used to represent percentage of batterly charge remaining.
+    * @param[in] provider
+    *               Optional. If supplied, the battery level is obtained from
+    *               this function whenever a peer reads it, and need not be
+    *               updated periodically; updateBatteryLevel() remains
+    *               available to push notifications.
     */
-    BatteryService(BLE &_ble, uint8_t level = 100) :
+    BatteryService(BLE &_ble, uint8_t level = 100, LevelProvider_t provider = NULL) :
         ble(_ble),
         batteryLevel(level),
-        batteryLevelCharacteristic(GattCharacteristic::UUID_BATTERY_LEVEL_CHAR, &batteryLevel, GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY) {
+        batteryLevelCharacteristic(GattCharacteristic::UUID_BATTERY_LEVEL_CHAR, &batteryLevel, GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY),
+        levelProvider(provider) {
+        if (levelProvider != NULL) {
+            batteryLevelCharacteristic.setValueProvider(this, &BatteryService::provideBatteryLevel);
+        }
+
+        batteryLevelCharacteristic.suppressIdenticalUpdates(); /* don't notify unchanged levels */
 
         GattCharacteristic *charTable[] = {&batteryLevelCharacteristic};
         GattService         batteryService(GattService::UUID_BATTERY_SERVICE, charTable, sizeof(charTable) / sizeof(GattCharacteristic *));
@@ -48,12 +65,24 @@ public:
      * @brief Update the battery level with a new value. Valid values range from
      * 0..100. Anything outside this range will be ignored.
      *
+     * @note Repeating the current level doesn't generate a notification.
+     *
      * @param newLevel
      *              update to battery level.
      */
     void updateBatteryLevel(uint8_t newLevel) {
         batteryLevel = newLevel;
-        ble.gattServer().write(batteryLevelCharacteristic.getValueHandle(), &batteryLevel, 1);
+        ble.gattServer().write(batteryLevelCharacteristic, &batteryLevel, 1);
+    }
+
+protected:
+    /**
+     * Value provider for the battery level characteristic.
+     */
+    void provideBatteryLevel(GattReadAuthCallbackParams *params) {
+        batteryLevel    = levelProvider();
+        params->data[0] = batteryLevel;
+        params->len     = sizeof(batteryLevel);
     }
 
 protected:
@@ -61,6 +90,7 @@ protected:
 
     uint8_t    batteryLevel;
     ReadOnlyGattCharacteristic<uint8_t> batteryLevelCharacteristic;
+    LevelProvider_t                     levelProvider;
 };
 
 #endif /* #ifndef __BLE_BATTERY_SERVICE_H__*/
\ No newline at end of file
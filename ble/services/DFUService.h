@@ -55,7 +55,7 @@ public:
     DFUService(BLE &_ble, ResetPrepare_t _handoverCallback = NULL) :
         ble(_ble),
         controlPoint(DFUServiceControlCharacteristicUUID, controlBytes, GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY),
-        packet(DFUServicePacketCharacteristicUUID, packetBytes, SIZEOF_PACKET_BYTES, SIZEOF_PACKET_BYTES,
+        packet(DFUServicePacketCharacteristicUUID, packetBytes, BLE_GATT_MTU_SIZE_DEFAULT - 3, SIZEOF_PACKET_BYTES,
                GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE),
         controlBytes(),
         packetBytes() {
@@ -107,7 +107,7 @@ public:
 
 protected:
     static const unsigned SIZEOF_CONTROL_BYTES = 2;
-    static const unsigned SIZEOF_PACKET_BYTES  = 20;
+    static const unsigned SIZEOF_PACKET_BYTES  = BLE_GATT_MTU_SIZE_MAX - 3; /* accept packets as large as the negotiated MTU permits */
 
 protected:
     BLE          &ble;
@@ -0,0 +1,298 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BLE_GENERIC_ATTRIBUTE_SERVICE_H__
+#define __BLE_GENERIC_ATTRIBUTE_SERVICE_H__
+
+#include "ble/BLE.h"
+
+#ifndef BLE_GATT_MAX_CHANGE_AWARE_CLIENTS
+#define BLE_GATT_MAX_CHANGE_AWARE_CLIENTS 8 /**< Clients whose view of the database is remembered; the least recently seen is forgotten first. */
+#endif
+
+/**
+* @class GenericAttributeService
+* @brief The GATT service, for ports whose stack doesn't provide one. It lets clients cache the attribute table across connections.<br>
+* Service Changed: indicated to a returning client whose cached table is stale, and by servicesChanged() when the table changes at runtime.<br>
+* Database Hash: read by clients which support robust caching to validate their cache; a client which reads it is change-aware.<br>
+* Client Supported Features: written by clients to declare robust caching support; kept per client.<br>
+*
+* Clients are recognized by address, which is stable for bonded peers. For
+* each, the service remembers the Database Hash as of the last time the
+* client was brought up to date: a client with an identity address is
+* recorded when it first connects, as it has yet to discover the table, and
+* again when it reads the Database Hash. The service may be added at any point, as
+* the hash covers the table as it stands when read; the port must support
+* GattServer::getDatabaseHash().
+*/
+class GenericAttributeService {
+public:
+    static const unsigned HASH_SIZE = 16;
+
+    enum {
+        CLIENT_FEATURE_ROBUST_CACHING = 0x01
+    };
+
+public:
+    /**
+    * @param[ref] _ble
+    *               BLE object for the underlying controller.
+    */
+    GenericAttributeService(BLE &_ble) :
+        ble(_ble),
+        clientSupportedFeatures(0),
+        serviceChangedCharacteristic(BLE_UUID_GATT_CHARACTERISTIC_SERVICE_CHANGED, serviceChangedRange,
+                                     sizeof(serviceChangedRange), sizeof(serviceChangedRange),
+                                     GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE),
+        databaseHashCharacteristic(BLE_UUID_GATT_CHARACTERISTIC_DATABASE_HASH, databaseHash, HASH_SIZE, HASH_SIZE,
+                                   GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ),
+        clientSupportedFeaturesCharacteristic(BLE_UUID_GATT_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES, &clientSupportedFeatures),
+        clients(),
+        clock(0) {
+        memset(serviceChangedRange, 0, sizeof(serviceChangedRange));
+        memset(databaseHash, 0, sizeof(databaseHash));
+
+        databaseHashCharacteristic.setValueProvider(this, &GenericAttributeService::provideDatabaseHash);
+        clientSupportedFeaturesCharacteristic.setValueProvider(this, &GenericAttributeService::provideClientSupportedFeatures);
+        clientSupportedFeaturesCharacteristic.setWriteAuthorizationCallback(this, &GenericAttributeService::authorizeClientSupportedFeatures);
+
+        GattCharacteristic *charTable[] = {&serviceChangedCharacteristic, &databaseHashCharacteristic, &clientSupportedFeaturesCharacteristic};
+        GattService         gattService(BLE_UUID_GATT, charTable, sizeof(charTable) / sizeof(GattCharacteristic *));
+
+        ble.addService(gattService);
+        ble.gap().addToConnectionCallChain(this, &GenericAttributeService::onConnection);
+        ble.gattServer().onSubscriptionChanged(this, &GenericAttributeService::onSubscriptionChanged);
+    }
+
+    /**
+     * @brief Tell connected clients that part of the table has changed, after
+     * services have been added at runtime. Clients which aren't connected are
+     * told when they return.
+     *
+     * @param startHandle, endHandle
+     *              The affected range of handles.
+     */
+    ble_error_t servicesChanged(GattAttribute::Handle_t startHandle = 0x0001, GattAttribute::Handle_t endHandle = 0xFFFF) {
+        setRange(startHandle, endHandle);
+        return ble.gattServer().notifyAll(serviceChangedCharacteristic.getValueHandle(), serviceChangedRange, sizeof(serviceChangedRange));
+    }
+
+    /**
+     * @brief Is a connected client's view of the table up to date? Requests
+     * from change-unaware clients may refer to stale handles.
+     */
+    bool isChangeAware(Gap::Handle_t connectionHandle) {
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        uint8_t            hash[HASH_SIZE];
+        if ((ble.gap().getPeerAddress(connectionHandle, &type, address) != BLE_ERROR_NONE) ||
+            (ble.gattServer().getDatabaseHash(hash) != BLE_ERROR_NONE)) {
+            return false;
+        }
+
+        const Client_t *client = findClient(type, address);
+        return (client != NULL) && (memcmp(client->hash, hash, HASH_SIZE) == 0);
+    }
+
+protected:
+    /**
+     * A client seen for the first time is recorded against the current
+     * table, which it is about to discover; one with a private address is
+     * not, as it can't be recognized again. A returning client with a stale
+     * view is sent Service Changed over the whole range, which prompts it to
+     * rediscover. Where the port keeps the CCCDs of bonded clients across
+     * connections, it goes out straight away; otherwise once the client
+     * subscribes again (see onSubscriptionChanged()).
+     */
+    void onConnection(const Gap::ConnectionCallbackParams_t *params) {
+        uint8_t hash[HASH_SIZE];
+        if (ble.gattServer().getDatabaseHash(hash) != BLE_ERROR_NONE) {
+            return;
+        }
+
+        Client_t *client = findClient(params->peerAddrType, params->peerAddr);
+        if (client == NULL) {
+            if ((params->peerAddrType == Gap::ADDR_TYPE_PUBLIC) || (params->peerAddrType == Gap::ADDR_TYPE_RANDOM_STATIC)) {
+                recordClient(params->peerAddrType, params->peerAddr, hash);
+            }
+            return;
+        }
+        if (ble.gattServer().isSubscribed(params->handle, serviceChangedCharacteristic.getValueHandle())) {
+            indicateServiceChanged(params->handle, client, hash);
+        }
+    }
+
+    /**
+     * A client subscribing to Service Changed with a stale view, typically
+     * as it reconnects to a port which forgets CCCDs on disconnection, is
+     * sent Service Changed there and then.
+     */
+    void onSubscriptionChanged(const GattSubscriptionCallbackParams *params) {
+        if (!params->enabled || (params->handle != serviceChangedCharacteristic.getValueHandle())) {
+            return;
+        }
+
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        uint8_t            hash[HASH_SIZE];
+        if ((ble.gap().getPeerAddress(params->connHandle, &type, address) != BLE_ERROR_NONE) ||
+            (ble.gattServer().getDatabaseHash(hash) != BLE_ERROR_NONE)) {
+            return;
+        }
+
+        Client_t *client = findClient(type, address);
+        if (client != NULL) {
+            indicateServiceChanged(params->connHandle, client, hash);
+        }
+    }
+
+    /**
+     * Value provider for the Database Hash characteristic. Reading it makes
+     * the client change-aware.
+     */
+    void provideDatabaseHash(GattReadAuthCallbackParams *params) {
+        if (ble.gattServer().getDatabaseHash(params->data) != BLE_ERROR_NONE) {
+            params->authorizationReply = AUTH_CALLBACK_REPLY_ATTERR_READ_NOT_PERMITTED;
+            return;
+        }
+        params->len = HASH_SIZE;
+
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        if (ble.gap().getPeerAddress(params->connHandle, &type, address) == BLE_ERROR_NONE) {
+            memcpy(recordClient(type, address, params->data)->hash, params->data, HASH_SIZE);
+        }
+    }
+
+    /**
+     * Value provider for the Client Supported Features characteristic: each
+     * client reads back the features it has declared.
+     */
+    void provideClientSupportedFeatures(GattReadAuthCallbackParams *params) {
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        const Client_t    *client = NULL;
+        if (ble.gap().getPeerAddress(params->connHandle, &type, address) == BLE_ERROR_NONE) {
+            client = findClient(type, address);
+        }
+
+        params->data[0] = (client != NULL) ? client->features : 0;
+        params->len     = sizeof(uint8_t);
+    }
+
+    /**
+     * Write authorization for the Client Supported Features characteristic.
+     * The features are stored against the writing client; a feature once
+     * declared can't be withdrawn, and unknown bits are ignored.
+     */
+    void authorizeClientSupportedFeatures(GattWriteAuthCallbackParams *params) {
+        if ((params->offset != 0) || (params->len != sizeof(uint8_t))) {
+            params->authorizationReply = AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+            return;
+        }
+
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        uint8_t            hash[HASH_SIZE];
+        if ((ble.gap().getPeerAddress(params->connHandle, &type, address) != BLE_ERROR_NONE) ||
+            (ble.gattServer().getDatabaseHash(hash) != BLE_ERROR_NONE)) {
+            params->authorizationReply = AUTH_CALLBACK_REPLY_ATTERR_WRITE_NOT_PERMITTED;
+            return;
+        }
+
+        recordClient(type, address, hash)->features |= (params->data[0] & CLIENT_FEATURE_ROBUST_CACHING);
+    }
+
+private:
+    struct Client_t {
+        Gap::AddressType_t type;
+        Gap::Address_t     address;
+        uint8_t            hash[HASH_SIZE];
+        uint8_t            features; /* CLIENT_FEATURE_* declared by the client */
+        uint32_t           lastSeen; /* 0 for unused entries */
+    };
+
+    Client_t *findClient(Gap::AddressType_t type, const Gap::Address_t address) {
+        for (unsigned i = 0; i < BLE_GATT_MAX_CHANGE_AWARE_CLIENTS; i++) {
+            if ((clients[i].lastSeen != 0) && (clients[i].type == type) &&
+                (memcmp(clients[i].address, address, Gap::ADDR_LEN) == 0)) {
+                clients[i].lastSeen = ++clock;
+                return &clients[i];
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * Find the client's entry, or take over the least recently seen one for
+     * it. A new entry starts out with the given hash and no features.
+     */
+    Client_t *recordClient(Gap::AddressType_t type, const Gap::Address_t address, const uint8_t *hash) {
+        Client_t *client = findClient(type, address);
+        if (client != NULL) {
+            return client;
+        }
+
+        client = &clients[0];
+        for (unsigned i = 1; i < BLE_GATT_MAX_CHANGE_AWARE_CLIENTS; i++) {
+            if (clients[i].lastSeen < client->lastSeen) {
+                client = &clients[i];
+            }
+        }
+        client->type     = type;
+        memcpy(client->address, address, Gap::ADDR_LEN);
+        memcpy(client->hash, hash, HASH_SIZE);
+        client->features = 0;
+        client->lastSeen = ++clock;
+        return client;
+    }
+
+    /* The client is up to date once the indication has gone out. */
+    void indicateServiceChanged(Gap::Handle_t connectionHandle, Client_t *client, const uint8_t *hash) {
+        if (memcmp(client->hash, hash, HASH_SIZE) == 0) {
+            return;
+        }
+
+        setRange(0x0001, 0xFFFF);
+        if (ble.gattServer().write(connectionHandle, serviceChangedCharacteristic.getValueHandle(),
+                                   serviceChangedRange, sizeof(serviceChangedRange)) == BLE_ERROR_NONE) {
+            memcpy(client->hash, hash, HASH_SIZE);
+        }
+    }
+
+    void setRange(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle) {
+        serviceChangedRange[0] = (uint8_t)(startHandle & 0xFF);
+        serviceChangedRange[1] = (uint8_t)(startHandle >> 8);
+        serviceChangedRange[2] = (uint8_t)(endHandle & 0xFF);
+        serviceChangedRange[3] = (uint8_t)(endHandle >> 8);
+    }
+
+protected:
+    BLE &ble;
+
+    uint8_t                                serviceChangedRange[2 * sizeof(GattAttribute::Handle_t)];
+    uint8_t                                databaseHash[HASH_SIZE];
+    uint8_t                                clientSupportedFeatures; /* scratch; the value is kept per client */
+    GattCharacteristic                     serviceChangedCharacteristic;
+    GattCharacteristic                     databaseHashCharacteristic;
+    ReadWriteGattCharacteristic<uint8_t>   clientSupportedFeaturesCharacteristic;
+
+private:
+    Client_t                               clients[BLE_GATT_MAX_CHANGE_AWARE_CLIENTS];
+    uint32_t                               clock;
+};
+
+#endif /* #ifndef __BLE_GENERIC_ATTRIBUTE_SERVICE_H__*/
@@ -44,18 +44,33 @@ public:
         LOCATION_EAR_DRUM,      /*!< ear drum */
     };
 
+    /**
+     * @brief Signature for an on-demand source of temperature measurements (in celsius); see the constructor.
+     */
+    typedef float (*TemperatureProvider_t)(void);
+
 public:
     /**
      * @brief Add the Health Thermometer Service to an existing ble object, initialize with temperature and location.
      * @param[ref] _ble         reference to the BLE device
      * @param[in] initialTemp  initial value in celsius
      * @param[in] _location
+     * @param[in] provider     optional; if supplied, the temperature is
+     *                         measured through this function whenever a peer
+     *                         reads it, rather than pushed with updateTemperature().
      */
-    HealthThermometerService(BLE &_ble, float initialTemp, uint8_t _location) :
+    HealthThermometerService(BLE &_ble, float initialTemp, uint8_t _location, TemperatureProvider_t provider = NULL) :
         ble(_ble),
         valueBytes(initialTemp),
         tempMeasurement(GattCharacteristic::UUID_TEMPERATURE_MEASUREMENT_CHAR, (TemperatureValueBytes *)valueBytes.getPointer(), GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY),
-        tempLocation(GattCharacteristic::UUID_TEMPERATURE_TYPE_CHAR, &_location) {
+        tempLocation(GattCharacteristic::UUID_TEMPERATURE_TYPE_CHAR, &_location),
+        temperatureProvider(provider) {
+        if (temperatureProvider != NULL) {
+            tempMeasurement.setValueProvider(this, &HealthThermometerService::provideTemperature);
+        }
+
+        /* don't notify measurements which are unchanged, in hundredths of a degree */
+        tempMeasurement.suppressUpdatesWithinDeadband(TemperatureValueBytes::OFFSET_OF_VALUE, TemperatureValueBytes::SIZEOF_MANTISSA, true, 0);
 
         GattCharacteristic *hrmChars[] = {&tempMeasurement, &tempLocation, };
         GattService         hrmService(GattService::UUID_HEALTH_THERMOMETER_SERVICE, hrmChars, sizeof(hrmChars) / sizeof(GattCharacteristic *));
@@ -73,8 +88,28 @@ public:
     void updateTemperature(float temperature) {
         if (ble.getGapState().connected) {
             valueBytes.updateTemperature(temperature);
-            ble.gattServer().write(tempMeasurement.getValueHandle(), valueBytes.getPointer(), sizeof(TemperatureValueBytes));
+            ble.gattServer().write(tempMeasurement, valueBytes.getPointer(), sizeof(TemperatureValueBytes));
+        }
+    }
+
+    /**
+     * @brief Set the smallest change in temperature which gets notified.
+     * Measurements which differ from the last one sent by no more than this
+     * are not sent; by default only unchanged measurements are suppressed.
+     *
+     * @param[in] degrees
+     *              Deadband in degrees Celsius, rounded to the resolution of
+     *              0.01; its sign is ignored.
+     */
+    void setTemperatureDeadband(float degrees) {
+        static const float MAX_DEADBAND = 0xFFFFFF; /* the largest 24-bit mantissa, in hundredths */
+
+        float hundredths = ((degrees < 0) ? -degrees : degrees) * 100 + 0.5f;
+        if (!(hundredths < MAX_DEADBAND)) {
+            hundredths = MAX_DEADBAND; /* also catches NaN */
         }
+        tempMeasurement.suppressUpdatesWithinDeadband(TemperatureValueBytes::OFFSET_OF_VALUE, TemperatureValueBytes::SIZEOF_MANTISSA, true,
+                                                      (uint32_t)hundredths);
     }
 
     /**
@@ -86,12 +121,23 @@ public:
         ble.gattServer().write(tempLocation.getValueHandle(), reinterpret_cast<uint8_t *>(&loc), sizeof(uint8_t));
     }
 
+protected:
+    /**
+     * Value provider for the temperature measurement characteristic.
+     */
+    void provideTemperature(GattReadAuthCallbackParams *params) {
+        valueBytes.updateTemperature(temperatureProvider());
+        params->data = valueBytes.getPointer();
+        params->len  = sizeof(TemperatureValueBytes);
+    }
+
 private:
     /* Private internal representation for the bytes used to work with the vaulue of the heart-rate characteristic. */
     struct TemperatureValueBytes {
         static const unsigned OFFSET_OF_FLAGS    = 0;
         static const unsigned OFFSET_OF_VALUE    = OFFSET_OF_FLAGS + sizeof(uint8_t);
         static const unsigned SIZEOF_VALUE_BYTES = sizeof(uint8_t) + sizeof(float);
+        static const unsigned SIZEOF_MANTISSA    = 3; /* the 11073 FLOAT value: 24-bit mantissa followed by an 8-bit exponent */
 
         static const unsigned TEMPERATURE_UNITS_FLAG_POS = 0;
         static const unsigned TIMESTAMP_FLAG_POS         = 1;
@@ -145,6 +191,7 @@ protected:
     TemperatureValueBytes                              valueBytes;
     ReadOnlyGattCharacteristic<TemperatureValueBytes>  tempMeasurement;
     ReadOnlyGattCharacteristic<uint8_t>                tempLocation;
+    TemperatureProvider_t                              temperatureProvider;
 };
 
 #endif /* #ifndef __BLE_HEALTH_THERMOMETER_SERVICE_H__*/
\ No newline at end of file
@@ -18,6 +18,7 @@
 #define __BLE_HEART_RATE_SERVICE_H__
 
 #include "ble/BLE.h"
+#include "ble/NotificationQueue.h"
 
 /**
 * @class HeartRateService
@@ -55,6 +56,7 @@ public:
      */
     HeartRateService(BLE &_ble, uint8_t hrmCounter, uint8_t location) :
         ble(_ble),
+        notificationQueue(_ble),
         valueBytes(hrmCounter),
         hrmRate(GattCharacteristic::UUID_HEART_RATE_MEASUREMENT_CHAR, valueBytes.getPointer(),
                 valueBytes.getNumValueBytes(), HeartRateValueBytes::MAX_VALUE_BYTES,
@@ -76,6 +78,7 @@ public:
      */
     HeartRateService(BLE &_ble, uint16_t hrmCounter, uint8_t location) :
         ble(_ble),
+        notificationQueue(_ble),
         valueBytes(hrmCounter),
         hrmRate(GattCharacteristic::UUID_HEART_RATE_MEASUREMENT_CHAR, valueBytes.getPointer(),
                 valueBytes.getNumValueBytes(), HeartRateValueBytes::MAX_VALUE_BYTES,
@@ -88,12 +91,19 @@ public:
     /**
      * @brief Set a new 8-bit value for heart rate.
      *
+     * @note If the stack is out of transmit buffers the notification is
+     * deferred; only the most recent measurement is kept.
+     * A measurement identical to the current one isn't notified again.
+     *
      * @param[in] hrmCounter
      *                  HeartRate in bpm.
      */
     void updateHeartRate(uint8_t hrmCounter) {
         valueBytes.updateHeartRate(hrmCounter);
-        ble.gattServer().write(hrmRate.getValueHandle(), valueBytes.getPointer(), valueBytes.getNumValueBytes());
+        if (!ble.gattServer().isRedundantUpdate(hrmRate, valueBytes.getPointer(), valueBytes.getNumValueBytes())) {
+            notificationQueue.enqueue(hrmRate.getValueHandle(), valueBytes.getPointer(), valueBytes.getNumValueBytes(),
+                                      NotificationQueue::MODE_STATE);
+        }
     }
 
     /**
@@ -104,7 +114,10 @@ public:
      */
     void updateHeartRate(uint16_t hrmCounter) {
         valueBytes.updateHeartRate(hrmCounter);
-        ble.gattServer().write(hrmRate.getValueHandle(), valueBytes.getPointer(), valueBytes.getNumValueBytes());
+        if (!ble.gattServer().isRedundantUpdate(hrmRate, valueBytes.getPointer(), valueBytes.getNumValueBytes())) {
+            notificationQueue.enqueue(hrmRate.getValueHandle(), valueBytes.getPointer(), valueBytes.getNumValueBytes(),
+                                      NotificationQueue::MODE_STATE);
+        }
     }
 
     /**
@@ -127,6 +140,8 @@ public:
 
 protected:
     void setupService(void) {
+        hrmRate.suppressIdenticalUpdates();
+
         GattCharacteristic *charTable[] = {&hrmRate, &hrmLocation, &controlPoint};
         GattService         hrmService(GattService::UUID_HEART_RATE_SERVICE, charTable, sizeof(charTable) / sizeof(GattCharacteristic *));
 
@@ -183,6 +198,8 @@ protected:
 protected:
     BLE                 &ble;
 
+    StaticNotificationQueue<1> notificationQueue; /**< Holds back the latest measurement while the stack is out of buffers. */
+
     HeartRateValueBytes  valueBytes;
     uint8_t              controlPointValue;
 
@@ -22,6 +22,7 @@
 
 #include "ble/UUID.h"
 #include "ble/BLE.h"
+#include "ble/NotificationQueue.h"
 
 extern const uint8_t  UARTServiceBaseUUID[UUID::LENGTH_OF_LONG_UUID];
 extern const uint16_t UARTServiceShortUUID;
@@ -40,8 +41,12 @@ extern const uint8_t  UARTServiceRXCharacteristicUUID[UUID::LENGTH_OF_LONG_UUID]
 */
 class UARTService {
 public:
-    /**< Maximum length of data (in bytes) that can be transmitted by the UART service module to the peer. */
-    static const unsigned BLE_UART_SERVICE_MAX_DATA_LEN = (BLE_GATT_MTU_SIZE_DEFAULT - 3);
+    /**< Maximum length of data (in bytes) that can be transmitted by the UART service module to the peer. The
+     *   amount sent per notification is further limited by the ATT MTU negotiated on the connection(s). */
+    static const unsigned BLE_UART_SERVICE_MAX_DATA_LEN = (BLE_GATT_MTU_SIZE_MAX - 3);
+
+    /**< Number of notifications which can be held back while the stack is out of transmit buffers. */
+    static const unsigned BLE_UART_SERVICE_NOTIFICATION_QUEUE_DEPTH = 4;
 
 public:
 
@@ -51,6 +56,7 @@ public:
     */
     UARTService(BLE &_ble) :
         ble(_ble),
+        notificationQueue(_ble),
         receiveBuffer(),
         sendBuffer(),
         sendBufferIndex(0),
@@ -63,6 +69,7 @@ public:
         GattService         uartService(UARTServiceUUID, charTable, sizeof(charTable) / sizeof(GattCharacteristic *));
 
         ble.addService(uartService);
+        ble.gattServer().registerReceiveBuffer(getTXCharacteristicHandle(), receiveBuffer, sizeof(receiveBuffer));
         ble.onDataWritten(this, &UARTService::onDataWritten);
     }
 
@@ -91,7 +98,14 @@ public:
      * updates. But we shouldn't buffer a large amount of data before updating
      * the characteristic otherwise the client will need to turn around and make
      * a long read request; this is because notifications include only the first
-     * 20 bytes of the updated data.
+     * ATT_MTU - 3 bytes of the updated data. Data is therefore collected into
+     * chunks of Gap::getMaxPayload() bytes, which grows once a larger MTU has
+     * been negotiated with the peer.
+     *
+     * Notifications which can't be handed to the stack straight away are
+     * queued, and sent as the stack releases transmit buffers. Once that
+     * queue is full, write() accepts only as many bytes as it can buffer
+     * and returns a short count; the caller should retry the remainder later.
      *
      * @param  buffer The received update
      * @param  length Amount of characters to be appended.
@@ -102,9 +116,19 @@ public:
         const uint8_t *buffer     = static_cast<const uint8_t *>(_buffer);
 
         if (ble.getGapState().connected) {
+            unsigned chunkSize = ble.gap().getMaxPayload();
+            if (chunkSize > BLE_UART_SERVICE_MAX_DATA_LEN) {
+                chunkSize = BLE_UART_SERVICE_MAX_DATA_LEN;
+            }
+
             unsigned bufferIndex = 0;
             while (length) {
-                unsigned bytesRemainingInSendBuffer = BLE_UART_SERVICE_MAX_DATA_LEN - sendBufferIndex;
+                /* a full sendBuffer left over from an earlier call has to go out first */
+                if ((sendBufferIndex >= chunkSize) && (flushSendBuffer() != BLE_ERROR_NONE)) {
+                    return bufferIndex;
+                }
+
+                unsigned bytesRemainingInSendBuffer = chunkSize - sendBufferIndex;
                 unsigned bytesToCopy                = (length < bytesRemainingInSendBuffer) ? length : bytesRemainingInSendBuffer;
 
                 /* copy bytes into sendBuffer */
@@ -114,11 +138,10 @@ public:
                 bufferIndex     += bytesToCopy;
 
                 /* have we collected enough? */
-                if ((sendBufferIndex == BLE_UART_SERVICE_MAX_DATA_LEN) ||
+                if ((sendBufferIndex == chunkSize) ||
                     // (sendBuffer[sendBufferIndex - 1] == '\r')          ||
                     (sendBuffer[sendBufferIndex - 1] == '\n')) {
-                    ble.gattServer().write(getRXCharacteristicHandle(), static_cast<const uint8_t *>(sendBuffer), sendBufferIndex);
-                    sendBufferIndex = 0;
+                    flushSendBuffer(); /* if the queue is full, the bytes stay in sendBuffer and go out with the next write */
                 }
             }
         }
@@ -160,6 +183,19 @@ public:
     }
 
 protected:
+    /**
+     * Push the contents of sendBuffer to the rxCharacteristic.
+     */
+    ble_error_t flushSendBuffer(void) {
+        ble_error_t error = notificationQueue.enqueue(getRXCharacteristicHandle(), sendBuffer, sendBufferIndex,
+                                                      NotificationQueue::MODE_STREAM);
+        if (error != BLE_ERROR_NO_MEM) {
+            sendBufferIndex = 0;
+        }
+
+        return error;
+    }
+
     /**
      * This callback allows the UART service to receive updates to the
      * txCharacteristic. The application should forward the call to this
@@ -172,7 +208,9 @@ protected:
             if (bytesRead <= BLE_UART_SERVICE_MAX_DATA_LEN) {
                 numBytesReceived   = bytesRead;
                 receiveBufferIndex = 0;
-                memcpy(receiveBuffer, params->data, numBytesReceived);
+                if (params->data != receiveBuffer) { /* the data has normally been received in place */
+                    memmove(receiveBuffer, params->data, numBytesReceived);
+                }
             }
         }
     }
@@ -180,6 +218,10 @@ protected:
 protected:
     BLE                &ble;
 
+    StaticNotificationQueue<BLE_UART_SERVICE_NOTIFICATION_QUEUE_DEPTH> notificationQueue; /**< Holds back outbound data while
+                                                                                            *   the stack is out of transmit
+                                                                                            *   buffers. */
+
     uint8_t             receiveBuffer[BLE_UART_SERVICE_MAX_DATA_LEN]; /**< The local buffer into which we receive
                                                                        *   inbound data before forwarding it to the
                                                                        *   application. */
@@ -187,9 +229,9 @@ protected:
     uint8_t             sendBuffer[BLE_UART_SERVICE_MAX_DATA_LEN];    /**< The local buffer into which outbound data is
                                                                        *   accumulated before being pushed to the
                                                                        *   rxCharacteristic. */
-    uint8_t             sendBufferIndex;
-    uint8_t             numBytesReceived;
-    uint8_t             receiveBufferIndex;
+    uint16_t            sendBufferIndex;
+    uint16_t            numBytesReceived;
+    uint16_t            receiveBufferIndex;
 
     GattCharacteristic  txCharacteristic; /**< From the point of view of the external client, this is the characteristic
                                            *   they'd write into in order to communicate with this application. */
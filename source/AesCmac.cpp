@@ -0,0 +1,186 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/AesCmac.h"
+
+static const uint8_t sbox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/* multiplication by x in GF(2^8) */
+static uint8_t
+xtime(uint8_t value)
+{
+    return (uint8_t)((value << 1) ^ ((value & 0x80) ? 0x1B : 0x00));
+}
+
+AesCmac::AesCmac(const uint8_t key[KEY_SIZE])
+{
+    /* key expansion (FIPS-197, Section 5.2) */
+    memcpy(roundKeys, key, KEY_SIZE);
+    uint8_t roundConstant = 0x01;
+    for (unsigned i = KEY_SIZE; i < sizeof(roundKeys); i += 4) {
+        uint8_t word[4];
+        memcpy(word, &roundKeys[i - 4], 4);
+        if ((i % KEY_SIZE) == 0) {
+            uint8_t first = word[0];
+            word[0] = sbox[word[1]] ^ roundConstant;
+            word[1] = sbox[word[2]];
+            word[2] = sbox[word[3]];
+            word[3] = sbox[first];
+            roundConstant = xtime(roundConstant);
+        }
+        for (unsigned j = 0; j < 4; j++) {
+            roundKeys[i + j] = roundKeys[i + j - KEY_SIZE] ^ word[j];
+        }
+    }
+
+    /* subkeys (RFC 4493, Section 2.3) */
+    uint8_t zero[BLOCK_SIZE] = {0};
+    uint8_t encryptedZero[BLOCK_SIZE];
+    encrypt(zero, encryptedZero);
+    deriveSubkey(encryptedZero, subkey1);
+    deriveSubkey(subkey1, subkey2);
+
+    reset();
+}
+
+void
+AesCmac::reset(void)
+{
+    memset(chain, 0, sizeof(chain));
+    pendingLength = 0;
+}
+
+void
+AesCmac::update(const uint8_t *data, unsigned length)
+{
+    while (length > 0) {
+        /* A full pending block is only processed once more data follows, as the last block is treated specially. */
+        if (pendingLength == BLOCK_SIZE) {
+            for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+                chain[i] ^= pending[i];
+            }
+            encrypt(chain, chain);
+            pendingLength = 0;
+        }
+
+        unsigned toCopy = BLOCK_SIZE - pendingLength;
+        if (toCopy > length) {
+            toCopy = length;
+        }
+        memcpy(&pending[pendingLength], data, toCopy);
+        pendingLength += toCopy;
+        data          += toCopy;
+        length        -= toCopy;
+    }
+}
+
+void
+AesCmac::getMac(uint8_t mac[BLOCK_SIZE]) const
+{
+    uint8_t last[BLOCK_SIZE];
+    if (pendingLength == BLOCK_SIZE) {
+        for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+            last[i] = pending[i] ^ subkey1[i];
+        }
+    } else {
+        memcpy(last, pending, pendingLength);
+        last[pendingLength] = 0x80;
+        memset(&last[pendingLength + 1], 0, BLOCK_SIZE - pendingLength - 1);
+        for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+            last[i] ^= subkey2[i];
+        }
+    }
+
+    for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+        last[i] ^= chain[i];
+    }
+    encrypt(last, mac);
+}
+
+/**
+ * AES-128 encryption of one block (FIPS-197, Section 5.1). The state is kept
+ * column by column, as in the specification; in and out may be the same.
+ */
+void
+AesCmac::encrypt(const uint8_t in[BLOCK_SIZE], uint8_t out[BLOCK_SIZE]) const
+{
+    uint8_t state[BLOCK_SIZE];
+    for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+        state[i] = in[i] ^ roundKeys[i];
+    }
+
+    for (unsigned round = 1; round <= ROUNDS; round++) {
+        /* SubBytes and ShiftRows: row r moves r columns to the left */
+        uint8_t shifted[BLOCK_SIZE];
+        for (unsigned column = 0; column < 4; column++) {
+            for (unsigned row = 0; row < 4; row++) {
+                shifted[column * 4 + row] = sbox[state[((column + row) % 4) * 4 + row]];
+            }
+        }
+
+        /* MixColumns, except in the last round */
+        if (round < ROUNDS) {
+            for (unsigned column = 0; column < 4; column++) {
+                uint8_t *c   = &shifted[column * 4];
+                uint8_t  all = c[0] ^ c[1] ^ c[2] ^ c[3];
+                uint8_t  c0  = c[0];
+                c[0] ^= all ^ xtime(c[0] ^ c[1]);
+                c[1] ^= all ^ xtime(c[1] ^ c[2]);
+                c[2] ^= all ^ xtime(c[2] ^ c[3]);
+                c[3] ^= all ^ xtime(c[3] ^ c0);
+            }
+        }
+
+        /* AddRoundKey */
+        for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+            state[i] = shifted[i] ^ roundKeys[round * BLOCK_SIZE + i];
+        }
+    }
+
+    memcpy(out, state, BLOCK_SIZE);
+}
+
+/* doubling in GF(2^128), as for the CMAC subkeys */
+void
+AesCmac::deriveSubkey(const uint8_t in[BLOCK_SIZE], uint8_t out[BLOCK_SIZE])
+{
+    uint8_t carry = in[0] & 0x80;
+    for (unsigned i = 0; i < BLOCK_SIZE - 1; i++) {
+        out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+    }
+    out[BLOCK_SIZE - 1] = (uint8_t)(in[BLOCK_SIZE - 1] << 1);
+    if (carry) {
+        out[BLOCK_SIZE - 1] ^= 0x87;
+    }
+}
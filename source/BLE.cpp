@@ -28,6 +28,16 @@ BLE::init()
         return err;
     }
 
+    /* Let the GattServer forget the subscriptions of terminated connections. */
+    transport->getGap().addToDisconnectionCallChain(&transport->getGattServer(), &GattServer::processDisconnectionEvent);
+
+    /* Let the GattClient fail the queued requests of terminated connections,
+     * size writes to the ATT MTU of each connection, and resume sending
+     * queued requests as transmit buffers free up. */
+    transport->getGap().addToDisconnectionCallChain(&transport->getGattClient(), &GattClient::processDisconnectionEvent);
+    transport->getGattClient().setGap(&transport->getGap());
+    transport->getGattServer().onDataSent(&transport->getGattClient(), &GattClient::processDataSentEvent);
+
     /* Platforms enabled for DFU should introduce the DFU Service into
      * applications automatically. */
 #if defined(TARGET_OTA_ENABLED)
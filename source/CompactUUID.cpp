@@ -0,0 +1,92 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/CompactUUID.h"
+
+UUID::LongUUIDBytes_t CompactUUID::bases[CompactUUID::MAX_BASES];
+uint16_t              CompactUUID::baseCount = 0;
+
+CompactUUID::CompactUUID(const UUID &uuid) : base(), value(uuid.getShortUUID())
+{
+    uint16_t width;
+    switch (uuid.getCompactLength()) {
+        case sizeof(UUID::ShortUUIDBytes_t):
+            base = (WIDTH_16 << WIDTH_SHIFT) | BLUETOOTH_BASE_INDEX;
+            return;
+        case UUID::LENGTH_OF_UUID32:
+            width = WIDTH_32;
+            break;
+        default:
+            width = WIDTH_128;
+            break;
+    }
+
+    base = (uint16_t)((width << WIDTH_SHIFT) | internBase(uuid.getLongUUID()));
+}
+
+UUID
+CompactUUID::getUUID(void) const
+{
+    uint16_t index = base & INDEX_MASK;
+    uint16_t width = base >> WIDTH_SHIFT;
+    if (index == INVALID_INDEX) {
+        return UUID();
+    }
+    if (width == WIDTH_16) {
+        return UUID(value);
+    }
+
+    UUID::LongUUIDBytes_t longUUID;
+    if (index == BLUETOOTH_BASE_INDEX) {
+        memcpy(longUUID, UUID(UUID::ShortUUIDBytes_t(0)).getLongUUID(), UUID::LENGTH_OF_LONG_UUID);
+    } else {
+        memcpy(longUUID, bases[index - 1], UUID::LENGTH_OF_LONG_UUID);
+    }
+    if (width == WIDTH_32) {
+        return UUID::fromUUID32(((UUID::UUID32Bytes_t)longUUID[0] << 24) | ((UUID::UUID32Bytes_t)longUUID[1] << 16) | value);
+    }
+
+    longUUID[2] = (uint8_t)(value >> 8);
+    longUUID[3] = (uint8_t)(value & 0xFF);
+    return UUID(longUUID);
+}
+
+uint16_t
+CompactUUID::internBase(const uint8_t *longUUID)
+{
+    UUID::LongUUIDBytes_t key;
+    memcpy(key, longUUID, UUID::LENGTH_OF_LONG_UUID);
+    key[2] = 0;
+    key[3] = 0;
+
+    /* the Bluetooth Base UUID, 00000000-0000-1000-8000-00805F9B34FB */
+    if (UUID(key) == UUID(UUID::ShortUUIDBytes_t(0))) {
+        return BLUETOOTH_BASE_INDEX;
+    }
+
+    for (uint16_t i = 0; i < baseCount; i++) {
+        if (memcmp(bases[i], key, UUID::LENGTH_OF_LONG_UUID) == 0) {
+            return i + 1;
+        }
+    }
+    if (baseCount >= MAX_BASES) {
+        return INVALID_INDEX;
+    }
+
+    memcpy(bases[baseCount], key, UUID::LENGTH_OF_LONG_UUID);
+    return ++baseCount;
+}
@@ -60,7 +60,13 @@ DiscoveredCharacteristic::writeWoResponse(uint16_t length, const uint8_t *value)
 }
 
 ble_error_t
-DiscoveredCharacteristic::discoverDescriptors(DescriptorCallback_t callback, const UUID &matchingUUID) const
+DiscoveredCharacteristic::discoverDescriptors(DescriptorCallback_t                     callback,
+                                              const UUID                              &matchingUUID,
+                                              ServiceDiscovery::TerminationCallback_t  tc) const
 {
-    return BLE_ERROR_NOT_IMPLEMENTED; /* TODO: this needs to be filled in. */
-}
\ No newline at end of file
+    if (!gattc) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    return gattc->discoverCharacteristicDescriptors(*this, callback, matchingUUID, tc);
+}
@@ -0,0 +1,558 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/BLE.h"
+#include "ble/GattAttributeCache.h"
+#include "ble/AttPdu.h"
+
+GattAttributeCache *GattAttributeCache::discovering = NULL;
+
+static const uint8_t  RECORD_MAGIC[2]      = {'G', 'C'};
+static const unsigned RECORD_HEADER_SIZE   = 2 + 1 + 1 + 2 + GattAttributeCache::HASH_SIZE;
+static const uint8_t  RECORD_FLAG_HAS_HASH = 0x01;
+
+static bool
+isWildcard(const UUID &filter)
+{
+    return (filter.shortOrLong() == UUID::UUID_TYPE_SHORT) && (filter.getShortUUID() == BLE_UUID_UNKNOWN);
+}
+
+static bool
+matches(const UUID &filter, const UUID &uuid)
+{
+    return isWildcard(filter) || (filter == uuid);
+}
+
+static uint8_t
+encodeProperties(const DiscoveredCharacteristic::Properties_t &props)
+{
+    return (props.broadcast()       ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_BROADCAST                    : 0) |
+           (props.read()            ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ                         : 0) |
+           (props.writeWoResp()     ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE       : 0) |
+           (props.write()           ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE                        : 0) |
+           (props.notify()          ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY                       : 0) |
+           (props.indicate()        ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE                     : 0) |
+           (props.authSignedWrite() ? GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_AUTHENTICATED_SIGNED_WRITES  : 0);
+}
+
+GattAttributeCache::GattAttributeCache(BLE &bleIn, GattCacheStorage &storageIn) :
+    ble(bleIn),
+    storage(storageIn),
+    state(STATE_IDLE),
+    aborted(false),
+    connHandle(0),
+    serviceCallback(NULL),
+    characteristicCallback(NULL),
+    terminationCallback(NULL),
+    matchingServiceUUID(),
+    matchingCharacteristicUUID(),
+    serviceMatched(false),
+    tableLoaded(false),
+    hasHash(false),
+    entryCount(0),
+    overflow(false),
+    hits(0),
+    misses(0)
+{
+    memset(tableKey, 0, sizeof(tableKey));
+    memset(hash, 0, sizeof(hash));
+    ble.gap().addToDisconnectionCallChain(this, &GattAttributeCache::onDisconnection);
+}
+
+ble_error_t
+GattAttributeCache::discover(Gap::Handle_t                               connectionHandle,
+                             ServiceDiscovery::ServiceCallback_t         sc,
+                             ServiceDiscovery::CharacteristicCallback_t  cc,
+                             const UUID                                 &matchingServiceUUIDIn,
+                             const UUID                                 &matchingCharacteristicUUIDIn,
+                             ServiceDiscovery::TerminationCallback_t     tc)
+{
+    if (state != STATE_IDLE) {
+        return BLE_STACK_BUSY;
+    }
+
+    connHandle                 = connectionHandle;
+    serviceCallback            = sc;
+    characteristicCallback     = cc;
+    terminationCallback        = tc;
+    matchingServiceUUID        = matchingServiceUUIDIn;
+    matchingCharacteristicUUID = matchingCharacteristicUUIDIn;
+    aborted                    = false;
+
+    if (loadTable(connectionHandle) != BLE_ERROR_NONE) {
+        return record();
+    }
+
+    GattAttribute::Handle_t hashHandle = hasHash ? findDatabaseHash() : GattAttribute::INVALID_HANDLE;
+    if (hashHandle == GattAttribute::INVALID_HANDLE) {
+        replay();
+        return BLE_ERROR_NONE;
+    }
+
+    state = STATE_VALIDATING;
+    ble_error_t error = ble.gattClient().queueRead(connectionHandle, hashHandle, 0, onHashRead, this);
+    if (error != BLE_ERROR_NONE) {
+        state = STATE_IDLE;
+    }
+    return error;
+}
+
+void
+GattAttributeCache::terminate(void)
+{
+    if ((state == STATE_IDLE) || (state == STATE_HASHING)) {
+        return;
+    }
+
+    aborted = true;
+    if (state == STATE_RECORDING) {
+        ble.gattClient().terminateServiceDiscovery(connHandle);
+    }
+}
+
+ble_error_t
+GattAttributeCache::invalidate(Gap::Handle_t connectionHandle)
+{
+    Gap::AddressType_t      type;
+    Gap::Address_t          address;
+    GattCacheStorage::Key_t key;
+    if (ble.gap().getPeerAddress(connectionHandle, &type, address) != BLE_ERROR_NONE) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    GattCacheStorage::makeKey(type, address, key);
+
+    if (memcmp(key, tableKey, sizeof(key)) == 0) {
+        tableLoaded = false;
+    }
+    return storage.erase(key);
+}
+
+ble_error_t
+GattAttributeCache::addDescriptor(Gap::Handle_t connectionHandle, GattAttribute::Handle_t handle, const UUID &uuid)
+{
+    if (state != STATE_IDLE) {
+        return BLE_STACK_BUSY;
+    }
+    if (loadTable(connectionHandle) != BLE_ERROR_NONE) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    for (unsigned i = 0; i < entryCount; i++) {
+        if ((entries[i].kind == ENTRY_DESCRIPTOR) && (entries[i].handle == handle)) {
+            return BLE_ERROR_NONE;
+        }
+    }
+    if (appendEntry(ENTRY_DESCRIPTOR, handle, GattAttribute::INVALID_HANDLE, uuid) == NULL) {
+        overflow = false;
+        return BLE_ERROR_NO_MEM;
+    }
+    return storeTable();
+}
+
+/**
+ * A characteristic's descriptors lie between its value and whichever comes
+ * first: the next characteristic declaration or the end of its service.
+ */
+GattAttribute::Handle_t
+GattAttributeCache::findDescriptor(Gap::Handle_t connectionHandle, GattAttribute::Handle_t valueHandle, const UUID &uuid)
+{
+    if ((state != STATE_IDLE) || (loadTable(connectionHandle) != BLE_ERROR_NONE)) {
+        return GattAttribute::INVALID_HANDLE;
+    }
+
+    GattAttribute::Handle_t limit = 0xFFFF;
+    for (unsigned i = 0; i < entryCount; i++) {
+        const Entry_t &entry = entries[i];
+        if ((entry.kind == ENTRY_SERVICE) && (entry.handle <= valueHandle) && (valueHandle <= entry.endHandle) && (entry.endHandle < limit)) {
+            limit = entry.endHandle;
+        } else if ((entry.kind == ENTRY_CHARACTERISTIC) && (entry.handle > valueHandle) && (entry.handle - 1 < limit)) {
+            limit = entry.handle - 1;
+        }
+    }
+
+    for (unsigned i = 0; i < entryCount; i++) {
+        const Entry_t &entry = entries[i];
+        if ((entry.kind == ENTRY_DESCRIPTOR) && (entry.handle > valueHandle) && (entry.handle <= limit) && (entry.uuid == uuid)) {
+            return entry.handle;
+        }
+    }
+    return GattAttribute::INVALID_HANDLE;
+}
+
+void
+GattAttributeCache::onService(const DiscoveredService *service)
+{
+    GattAttributeCache *cache = discovering;
+    if (cache == NULL) {
+        return;
+    }
+
+    cache->appendEntry(ENTRY_SERVICE, service->getStartHandle(), service->getEndHandle(), service->getUUID());
+    cache->serviceMatched = matches(cache->matchingServiceUUID, service->getUUID());
+    if (cache->serviceMatched && cache->serviceCallback && isWildcard(cache->matchingCharacteristicUUID)) {
+        cache->serviceCallback(service);
+    }
+}
+
+void
+GattAttributeCache::onCharacteristic(const DiscoveredCharacteristic *characteristic)
+{
+    GattAttributeCache *cache = discovering;
+    if (cache == NULL) {
+        return;
+    }
+
+    Entry_t *entry = cache->appendEntry(ENTRY_CHARACTERISTIC, characteristic->getDeclHandle(), characteristic->getValueHandle(), characteristic->getUUID());
+    if (entry != NULL) {
+        entry->properties = encodeProperties(characteristic->getProperties());
+    }
+    if (cache->serviceMatched && cache->characteristicCallback && matches(cache->matchingCharacteristicUUID, characteristic->getUUID())) {
+        cache->characteristicCallback(characteristic);
+    }
+}
+
+/**
+ * A complete table is stored, together with the Database Hash if the peer
+ * has one; the application learns of the end of discovery once the hash has
+ * been read, when the cache is idle again.
+ */
+void
+GattAttributeCache::onTermination(Gap::Handle_t connectionHandle)
+{
+    GattAttributeCache *cache = discovering;
+    if ((cache == NULL) || (connectionHandle != cache->connHandle)) {
+        return;
+    }
+    discovering = NULL;
+
+    if (cache->aborted || cache->overflow) {
+        cache->storage.erase(cache->tableKey);
+        cache->finish();
+        return;
+    }
+
+    cache->tableLoaded = true;
+    cache->state       = STATE_HASHING;
+    GattAttribute::Handle_t hashHandle = cache->findDatabaseHash();
+    if ((hashHandle == GattAttribute::INVALID_HANDLE) ||
+        (cache->ble.gattClient().queueRead(connectionHandle, hashHandle, 0, onHashRead, cache) != BLE_ERROR_NONE)) {
+        cache->storeTable();
+        cache->finish();
+    }
+}
+
+void
+GattAttributeCache::onHashRead(const GattClient::RequestResult_t *result)
+{
+    GattAttributeCache *cache = static_cast<GattAttributeCache *>(result->context);
+    bool                valid = (result->status == BLE_ERROR_NONE) && (result->len == HASH_SIZE);
+
+    if (cache->state == STATE_HASHING) {
+        /* Without the hash, the table couldn't be validated; it isn't kept. */
+        if (valid) {
+            cache->hasHash = true;
+            memcpy(cache->hash, result->data, HASH_SIZE);
+            cache->storeTable();
+        } else {
+            cache->tableLoaded = false;
+        }
+        cache->finish();
+        return;
+    }
+
+    if (cache->aborted) {
+        cache->finish();
+        return;
+    }
+    if (valid && (memcmp(cache->hash, result->data, HASH_SIZE) == 0)) {
+        cache->replay();
+        return;
+    }
+
+    /* The peer's database has changed. */
+    cache->storage.erase(cache->tableKey);
+    cache->tableLoaded = false;
+    cache->state       = STATE_IDLE;
+    if (cache->record() != BLE_ERROR_NONE) {
+        cache->finish();
+    }
+}
+
+void
+GattAttributeCache::onDisconnection(const Gap::DisconnectionCallbackParams_t *params)
+{
+    if ((state != STATE_IDLE) && (params->handle == connHandle)) {
+        aborted = true;
+    }
+}
+
+ble_error_t
+GattAttributeCache::loadTable(Gap::Handle_t connectionHandle)
+{
+    Gap::AddressType_t      type;
+    Gap::Address_t          address;
+    GattCacheStorage::Key_t key;
+    if (ble.gap().getPeerAddress(connectionHandle, &type, address) != BLE_ERROR_NONE) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    GattCacheStorage::makeKey(type, address, key);
+
+    if (tableLoaded && (memcmp(key, tableKey, sizeof(key)) == 0)) {
+        return BLE_ERROR_NONE;
+    }
+
+    tableLoaded = false;
+    memcpy(tableKey, key, sizeof(key));
+
+    uint16_t    length = sizeof(recordBuffer);
+    ble_error_t error  = storage.load(key, recordBuffer, &length);
+    if (error != BLE_ERROR_NONE) {
+        return error;
+    }
+    if (!parse(recordBuffer, length)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    tableLoaded = true;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+GattAttributeCache::storeTable(void)
+{
+    uint16_t length = serialize(recordBuffer);
+    if (length == 0) {
+        return BLE_ERROR_BUFFER_OVERFLOW;
+    }
+    return storage.store(tableKey, recordBuffer, length);
+}
+
+/**
+ * Rebuild the table from a record, checking every field against the length
+ * of the record; anything malformed, or of another version, is rejected.
+ */
+bool
+GattAttributeCache::parse(const uint8_t *record, uint16_t length)
+{
+    entryCount = 0;
+    overflow   = false;
+    if ((length < RECORD_HEADER_SIZE) ||
+        (memcmp(record, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0) ||
+        (record[2] != FORMAT_VERSION)) {
+        return false;
+    }
+
+    hasHash = ((record[3] & RECORD_FLAG_HAS_HASH) != 0);
+    uint16_t count = AttPdu::readUint16(&record[4]);
+    memcpy(hash, &record[6], HASH_SIZE);
+    if (count > MAX_ENTRIES) {
+        return false;
+    }
+
+    unsigned offset = RECORD_HEADER_SIZE;
+    for (unsigned i = 0; i < count; i++) {
+        if (offset >= length) {
+            return false;
+        }
+        uint8_t  kind       = record[offset++];
+        unsigned fixedSize  = (kind == ENTRY_DESCRIPTOR) ? 2 : (kind == ENTRY_CHARACTERISTIC) ? 5 : 4;
+        if ((kind < ENTRY_SERVICE) || (kind > ENTRY_DESCRIPTOR) || (offset + fixedSize + 1 > length)) {
+            return false;
+        }
+
+        const uint8_t *fields     = &record[offset];
+        uint8_t        uuidLength = record[offset + fixedSize];
+        offset += fixedSize + 1;
+        if (((uuidLength != UUID::LENGTH_OF_LONG_UUID) && (uuidLength != sizeof(UUID::ShortUUIDBytes_t))) ||
+            (offset + uuidLength > length)) {
+            return false;
+        }
+
+        GattAttribute::Handle_t endHandle = (kind == ENTRY_DESCRIPTOR) ? (GattAttribute::Handle_t)GattAttribute::INVALID_HANDLE : AttPdu::readUint16(&fields[2]);
+        Entry_t *entry = appendEntry((EntryKind_t)kind, AttPdu::readUint16(fields), endHandle, AttPdu::decodeUUID(&record[offset], uuidLength));
+        if (kind == ENTRY_CHARACTERISTIC) {
+            entry->properties = fields[4];
+        }
+        offset += uuidLength;
+    }
+
+    return (offset == length);
+}
+
+/**
+ * @return the length of the record; 0 if it exceeds MAX_RECORD_SIZE.
+ */
+uint16_t
+GattAttributeCache::serialize(uint8_t *record) const
+{
+    memcpy(record, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    record[2] = FORMAT_VERSION;
+    record[3] = hasHash ? RECORD_FLAG_HAS_HASH : 0;
+    AttPdu::writeUint16(&record[4], entryCount);
+    memcpy(&record[6], hash, HASH_SIZE);
+
+    unsigned offset = RECORD_HEADER_SIZE;
+    for (unsigned i = 0; i < entryCount; i++) {
+        const Entry_t &entry = entries[i];
+        if (offset + 1 + 5 + 1 + UUID::LENGTH_OF_LONG_UUID > MAX_RECORD_SIZE) {
+            return 0;
+        }
+
+        record[offset++] = entry.kind;
+        AttPdu::writeUint16(&record[offset], entry.handle);
+        offset += 2;
+        if (entry.kind != ENTRY_DESCRIPTOR) {
+            AttPdu::writeUint16(&record[offset], entry.endHandle);
+            offset += 2;
+        }
+        if (entry.kind == ENTRY_CHARACTERISTIC) {
+            record[offset++] = entry.properties;
+        }
+        uint8_t uuidLength = AttPdu::encodeUUID(entry.uuid, &record[offset + 1]);
+        record[offset] = uuidLength;
+        offset += 1 + uuidLength;
+    }
+
+    return (uint16_t)offset;
+}
+
+GattAttributeCache::Entry_t *
+GattAttributeCache::appendEntry(EntryKind_t kind, GattAttribute::Handle_t handle, GattAttribute::Handle_t endHandle, const UUID &uuid)
+{
+    if (entryCount >= MAX_ENTRIES) {
+        overflow = true;
+        return NULL;
+    }
+
+    Entry_t &entry   = entries[entryCount++];
+    entry.kind       = kind;
+    entry.properties = 0;
+    entry.handle     = handle;
+    entry.endHandle  = endHandle;
+    entry.uuid       = uuid;
+    return &entry;
+}
+
+GattAttribute::Handle_t
+GattAttributeCache::findDatabaseHash(void) const
+{
+    const UUID databaseHash(BLE_UUID_GATT_CHARACTERISTIC_DATABASE_HASH);
+    for (unsigned i = 0; i < entryCount; i++) {
+        if ((entries[i].kind == ENTRY_CHARACTERISTIC) && (entries[i].uuid == databaseHash)) {
+            return entries[i].endHandle;
+        }
+    }
+    return GattAttribute::INVALID_HANDLE;
+}
+
+/**
+ * Run a complete discovery, recording everything and passing on what
+ * matches the application's filters.
+ */
+ble_error_t
+GattAttributeCache::record(void)
+{
+    if ((discovering != NULL) && (discovering != this)) {
+        return BLE_STACK_BUSY; /* another cache is recording; the results couldn't be told apart */
+    }
+
+    Gap::AddressType_t type;
+    Gap::Address_t     address;
+    if (ble.gap().getPeerAddress(connHandle, &type, address) != BLE_ERROR_NONE) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    GattCacheStorage::makeKey(type, address, tableKey);
+    tableLoaded    = false;
+    hasHash        = false;
+    entryCount     = 0;
+    overflow       = false;
+    serviceMatched = false;
+
+    state       = STATE_RECORDING;
+    discovering = this;
+    ble_error_t error = ble.gattClient().launchServiceDiscovery(connHandle, onService, onCharacteristic,
+                                                                UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                                                UUID::ShortUUIDBytes_t(BLE_UUID_UNKNOWN),
+                                                                onTermination);
+    if (error != BLE_ERROR_NONE) {
+        state       = STATE_IDLE;
+        discovering = NULL;
+        return error;
+    }
+
+    misses++;
+    return BLE_ERROR_NONE;
+}
+
+/**
+ * Answer from the table, as GattClient would: services are reported only if
+ * the characteristic filter is a wildcard.
+ */
+void
+GattAttributeCache::replay(void)
+{
+    state = STATE_REPLAYING;
+    hits++;
+
+    GattClient &client         = ble.gattClient();
+    bool        serviceMatches = false;
+    for (unsigned i = 0; (i < entryCount) && !aborted; i++) {
+        const Entry_t &entry = entries[i];
+        if (entry.kind == ENTRY_SERVICE) {
+            serviceMatches = matches(matchingServiceUUID, entry.uuid);
+            if (serviceMatches && serviceCallback && isWildcard(matchingCharacteristicUUID)) {
+                DiscoveredService service;
+                service.setup(entry.uuid, entry.handle, entry.endHandle);
+                serviceCallback(&service);
+            }
+        } else if ((entry.kind == ENTRY_CHARACTERISTIC) && serviceMatches && characteristicCallback &&
+                   matches(matchingCharacteristicUUID, entry.uuid)) {
+            CachedCharacteristic characteristic;
+            characteristic.setup(&client, connHandle, entry);
+            characteristicCallback(&characteristic);
+        }
+    }
+
+    finish();
+}
+
+void
+GattAttributeCache::finish(void)
+{
+    state = STATE_IDLE;
+    if (terminationCallback) {
+        terminationCallback(connHandle);
+    }
+}
+
+void
+GattAttributeCache::CachedCharacteristic::setup(GattClient *gattcIn, Gap::Handle_t connHandleIn, const Entry_t &entry)
+{
+    gattc       = gattcIn;
+    connHandle  = connHandleIn;
+    uuid        = entry.uuid;
+    declHandle  = entry.handle;
+    valueHandle = entry.endHandle;
+
+    props._broadcast       = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_BROADCAST) ? 1 : 0;
+    props._read            = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ) ? 1 : 0;
+    props._writeWoResp     = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE) ? 1 : 0;
+    props._write           = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE) ? 1 : 0;
+    props._notify          = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY) ? 1 : 0;
+    props._indicate        = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE) ? 1 : 0;
+    props._authSignedWrite = (entry.properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_AUTHENTICATED_SIGNED_WRITES) ? 1 : 0;
+}
@@ -0,0 +1,647 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/GattAttributeDatabase.h"
+
+static bool
+isShortUUID(const UUID &uuid, UUID::ShortUUIDBytes_t shortUUID)
+{
+    return uuid == UUID(shortUUID);
+}
+
+/* The Database Hash is a CMAC with a key of zero. */
+static const uint8_t DATABASE_HASH_KEY[AesCmac::KEY_SIZE] = {0};
+
+GattAttributeDatabase::GattAttributeDatabase(GattAttribute::Handle_t firstHandleIn) :
+    firstHandle(firstHandleIn),
+    attributeCount(0),
+    uuidCount(0),
+    serviceCount(0),
+    arenaUsed(0),
+    hash(DATABASE_HASH_KEY)
+{
+    /* empty */
+}
+
+void
+GattAttributeDatabase::reset(void)
+{
+    attributeCount = 0;
+    uuidCount      = 0;
+    serviceCount   = 0;
+    arenaUsed      = 0;
+    hash.reset();
+}
+
+void
+GattAttributeDatabase::getHash(uint8_t hashOut[AesCmac::BLOCK_SIZE]) const
+{
+    uint8_t mac[AesCmac::BLOCK_SIZE];
+    hash.getMac(mac);
+    for (unsigned i = 0; i < AesCmac::BLOCK_SIZE; i++) {
+        hashOut[i] = mac[AesCmac::BLOCK_SIZE - 1 - i];
+    }
+}
+
+ble_error_t
+GattAttributeDatabase::addService(GattService &service)
+{
+    /* Check that the service fits before touching any of the tables. */
+    unsigned requiredAttributes = 1;
+    for (uint8_t i = 0; i < service.getCharacteristicCount(); i++) {
+        GattCharacteristic *characteristic = service.getCharacteristic(i);
+        requiredAttributes += getRequiredAttributes(characteristic->getProperties(), characteristic->getDescriptorCount());
+    }
+    if (!hasRoomFor(requiredAttributes)) {
+        return BLE_ERROR_NO_MEM;
+    }
+
+    unsigned savedAttributeCount = attributeCount;
+    unsigned savedUUIDCount      = uuidCount;
+    unsigned savedArenaUsed      = arenaUsed;
+
+    GattAttribute::Handle_t serviceHandle = firstHandle + attributeCount;
+    if (!appendServiceDeclaration(service.getUUID())) {
+        rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+        return BLE_ERROR_NO_MEM;
+    }
+
+    for (uint8_t i = 0; i < service.getCharacteristicCount(); i++) {
+        GattCharacteristic *characteristic = service.getCharacteristic(i);
+        GattAttribute      &valueAttribute = characteristic->getValueAttribute();
+        uint8_t             props          = characteristic->getProperties();
+
+        if (!valueAttribute.getCompactUUID().isValid() ||
+            !appendCharacteristicDeclaration(props) ||
+            !appendValue(valueAttribute.getUUID(), valueAttribute.getValuePtr(), valueAttribute.getInitialLength(),
+                         valueAttribute.getMaxLength(), props, false /* constant */)) {
+            rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+            clearHandles(service);
+            return BLE_ERROR_NO_MEM;
+        }
+        valueAttribute.setHandle(firstHandle + attributeCount - 1);
+
+        bool hasCCCD = false;
+        for (uint8_t j = 0; j < characteristic->getDescriptorCount(); j++) {
+            GattAttribute *descriptor = characteristic->getDescriptor(j);
+            if (!descriptor->getCompactUUID().isValid() ||
+                !appendValue(descriptor->getUUID(), descriptor->getValuePtr(), descriptor->getInitialLength(),
+                             descriptor->getMaxLength(), GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ, false /* constant */)) {
+                rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+                clearHandles(service);
+                return BLE_ERROR_NO_MEM;
+            }
+            descriptor->setHandle(firstHandle + attributeCount - 1);
+            hasCCCD |= isShortUUID(descriptor->getUUID(), BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG);
+        }
+
+        if (!hasCCCD && !appendImplicitCCCD(props)) {
+            rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+            clearHandles(service);
+            return BLE_ERROR_NO_MEM;
+        }
+    }
+
+    commitService(serviceHandle);
+    service.setHandle(serviceHandle);
+    return BLE_ERROR_NONE;
+}
+
+/**
+ * The same layout as for a GattService, built from a constant table. Only
+ * the value handles are written back, to the caller's array; the definition
+ * itself may live in flash.
+ */
+ble_error_t
+GattAttributeDatabase::addService(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles)
+{
+    unsigned requiredAttributes = 1;
+    for (uint8_t i = 0; i < definition.characteristicCount; i++) {
+        const GattCharacteristicDefinition &characteristic = definition.characteristics[i];
+        requiredAttributes += getRequiredAttributes(characteristic.properties, characteristic.descriptorCount);
+    }
+    if (!hasRoomFor(requiredAttributes)) {
+        return BLE_ERROR_NO_MEM;
+    }
+
+    unsigned savedAttributeCount = attributeCount;
+    unsigned savedUUIDCount      = uuidCount;
+    unsigned savedArenaUsed      = arenaUsed;
+
+    GattAttribute::Handle_t serviceHandle = firstHandle + attributeCount;
+    if (!appendServiceDeclaration(definition.getUUID())) {
+        rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+        return BLE_ERROR_NO_MEM;
+    }
+
+    for (uint8_t i = 0; i < definition.characteristicCount; i++) {
+        const GattCharacteristicDefinition &characteristic = definition.characteristics[i];
+
+        if (!appendCharacteristicDeclaration(characteristic.properties) ||
+            !appendValue(characteristic.getUUID(), characteristic.initialValue, characteristic.initialLength,
+                         characteristic.maxLength, characteristic.properties, characteristic.maxLength == 0)) {
+            rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+            clearHandles(definition, valueHandles);
+            return BLE_ERROR_NO_MEM;
+        }
+        if (valueHandles != NULL) {
+            valueHandles[i] = firstHandle + attributeCount - 1;
+        }
+
+        bool hasCCCD = false;
+        for (uint8_t j = 0; j < characteristic.descriptorCount; j++) {
+            const GattDescriptorDefinition &descriptor = characteristic.descriptors[j];
+            UUID                            type       = descriptor.getUUID();
+            if (!appendValue(type, descriptor.initialValue, descriptor.initialLength, descriptor.maxLength,
+                             GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ, descriptor.maxLength == 0)) {
+                rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+                clearHandles(definition, valueHandles);
+                return BLE_ERROR_NO_MEM;
+            }
+            hasCCCD |= isShortUUID(type, BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG);
+        }
+
+        if (!hasCCCD && !appendImplicitCCCD(characteristic.properties)) {
+            rollback(savedAttributeCount, savedUUIDCount, savedArenaUsed);
+            clearHandles(definition, valueHandles);
+            return BLE_ERROR_NO_MEM;
+        }
+    }
+
+    commitService(serviceHandle);
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+GattAttributeDatabase::read(GattAttribute::Handle_t handle, uint16_t offset, uint8_t *buffer, uint16_t *lengthP) const
+{
+    if (!isValidHandle(handle)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    AttributeIndex_t index = indexOf(handle);
+    const UUID      &type  = uuids[types[index]];
+
+    uint8_t        declaration[1 + sizeof(GattAttribute::Handle_t) + UUID::LENGTH_OF_LONG_UUID];
+    const uint8_t *source;
+    uint16_t       length;
+    if (isShortUUID(type, BLE_UUID_SERVICE_PRIMARY)) {
+        unsigned service = 0;
+        while (serviceStart[service] != index) {
+            service++;
+        }
+        length = encodeUUID(uuids[serviceUUIDs[service]], declaration);
+        source = declaration;
+    } else if (isShortUUID(type, BLE_UUID_CHARACTERISTIC)) {
+        GattAttribute::Handle_t valueHandle = handle + 1;
+        declaration[0] = properties[index + 1];
+        declaration[1] = (uint8_t)(valueHandle & 0xFF);
+        declaration[2] = (uint8_t)(valueHandle >> 8);
+        length = 3 + encodeUUID(uuids[types[index + 1]], &declaration[3]);
+        source = declaration;
+    } else {
+        length = lengths[index];
+        source = values[index];
+    }
+
+    if (offset > length) {
+        return BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+    length -= offset;
+
+    uint16_t toCopy = (length < *lengthP) ? length : *lengthP;
+    if ((toCopy > 0) && (source != NULL)) {
+        memcpy(buffer, source + offset, toCopy);
+    }
+    *lengthP = length;
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+GattAttributeDatabase::write(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t length)
+{
+    if (!isValidHandle(handle)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    AttributeIndex_t index = indexOf(handle);
+    if (values[index] == NULL) {
+        return BLE_ERROR_INVALID_PARAM; /* declarations and connection-specific descriptors */
+    }
+    if ((maxLengths[index] == 0) && (lengths[index] != 0)) {
+        return BLE_ERROR_OPERATION_NOT_PERMITTED; /* a constant from a GattServiceDefinition */
+    }
+    if (length > maxLengths[index]) {
+        return BLE_ERROR_BUFFER_OVERFLOW;
+    }
+
+    memcpy(values[index], value, length);
+    lengths[index] = length;
+
+    return BLE_ERROR_NONE;
+}
+
+GattAttribute::Handle_t
+GattAttributeDatabase::findAttribute(const UUID              &type,
+                                     GattAttribute::Handle_t  startHandle,
+                                     GattAttribute::Handle_t  endHandle) const
+{
+    UUIDIndex_t typeIndex = lookupUUID(type);
+    if ((typeIndex == INVALID_UUID_INDEX) || (attributeCount == 0)) {
+        return GattAttribute::INVALID_HANDLE;
+    }
+
+    if (startHandle < firstHandle) {
+        startHandle = firstHandle;
+    }
+    if (startHandle > getLastHandle()) {
+        return GattAttribute::INVALID_HANDLE;
+    }
+    AttributeIndex_t startIndex = indexOf(startHandle);
+
+    /* lower bound of (typeIndex, startIndex) within attributesByType */
+    unsigned low  = 0;
+    unsigned high = attributeCount;
+    while (low < high) {
+        unsigned         mid       = (low + high) / 2;
+        AttributeIndex_t candidate = attributesByType[mid];
+        if ((types[candidate] < typeIndex) || ((types[candidate] == typeIndex) && (candidate < startIndex))) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if ((low < attributeCount) && (types[attributesByType[low]] == typeIndex)) {
+        GattAttribute::Handle_t handle = firstHandle + attributesByType[low];
+        if (handle <= endHandle) {
+            return handle;
+        }
+    }
+
+    return GattAttribute::INVALID_HANDLE;
+}
+
+ble_error_t
+GattAttributeDatabase::getServiceRange(GattAttribute::Handle_t  handle,
+                                       GattAttribute::Handle_t *startHandleP,
+                                       GattAttribute::Handle_t *endHandleP) const
+{
+    if (!isValidHandle(handle) || (serviceCount == 0)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    /* services are stored in handle order; find the last one starting at or before the attribute */
+    AttributeIndex_t index = indexOf(handle);
+    unsigned         low   = 0;
+    unsigned         high  = serviceCount;
+    while (high - low > 1) {
+        unsigned mid = (low + high) / 2;
+        if (serviceStart[mid] <= index) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    *startHandleP = firstHandle + serviceStart[low];
+    *endHandleP   = firstHandle + serviceEnd[low];
+    return BLE_ERROR_NONE;
+}
+
+GattAttributeDatabase::UUIDIndex_t
+GattAttributeDatabase::lookupUUID(const UUID &uuid) const
+{
+    unsigned low  = 0;
+    unsigned high = uuidCount;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        int      cmp = compareUUIDs(uuids[uuidsSorted[mid]], uuid);
+        if (cmp == 0) {
+            return uuidsSorted[mid];
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return INVALID_UUID_INDEX;
+}
+
+uint8_t
+GattAttributeDatabase::encodeUUID(const UUID &uuid, uint8_t *buffer)
+{
+    if (uuid.shortOrLong() == UUID::UUID_TYPE_SHORT) {
+        buffer[0] = (uint8_t)(uuid.getShortUUID() & 0xFF);
+        buffer[1] = (uint8_t)(uuid.getShortUUID() >> 8);
+        return sizeof(UUID::ShortUUIDBytes_t);
+    }
+
+    /* long UUIDs are held MSB first; ATT transfers them LSB first */
+    const uint8_t *longUUID = uuid.getBaseUUID();
+    for (unsigned i = 0; i < UUID::LENGTH_OF_LONG_UUID; i++) {
+        buffer[i] = longUUID[UUID::LENGTH_OF_LONG_UUID - 1 - i];
+    }
+    return UUID::LENGTH_OF_LONG_UUID;
+}
+
+GattAttributeDatabase::UUIDIndex_t
+GattAttributeDatabase::internUUID(const UUID &uuid)
+{
+    /* binary search for the insertion point in the sorted view */
+    unsigned low  = 0;
+    unsigned high = uuidCount;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        int      cmp = compareUUIDs(uuids[uuidsSorted[mid]], uuid);
+        if (cmp == 0) {
+            return uuidsSorted[mid];
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if ((uuidCount >= MAX_UUIDS) || (uuidCount >= INVALID_UUID_INDEX)) {
+        return INVALID_UUID_INDEX;
+    }
+
+    UUIDIndex_t index = uuidCount++;
+    uuids[index] = uuid;
+    memmove(&uuidsSorted[low + 1], &uuidsSorted[low], (index - low) * sizeof(UUIDIndex_t));
+    uuidsSorted[low] = index;
+
+    return index;
+}
+
+void
+GattAttributeDatabase::appendAttribute(UUIDIndex_t type, uint8_t *value, uint16_t length, uint16_t maxLength, uint8_t props)
+{
+    AttributeIndex_t index = (AttributeIndex_t)attributeCount++;
+    types[index]      = type;
+    values[index]     = value;
+    lengths[index]    = length;
+    maxLengths[index] = maxLength;
+    properties[index] = props;
+
+    /* keep attributesByType ordered by (type, index); the new index is the largest so far */
+    unsigned low  = 0;
+    unsigned high = index;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        if (types[attributesByType[mid]] <= type) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    memmove(&attributesByType[low + 1], &attributesByType[low], (index - low) * sizeof(AttributeIndex_t));
+    attributesByType[low] = index;
+}
+
+unsigned
+GattAttributeDatabase::getRequiredAttributes(uint8_t props, unsigned descriptorCount)
+{
+    unsigned required = 2 + descriptorCount; /* declaration, value and descriptors */
+    if (props & (GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE)) {
+        required++; /* possibly an implicit CCCD */
+    }
+    return required;
+}
+
+bool
+GattAttributeDatabase::hasRoomFor(unsigned requiredAttributes) const
+{
+    return (serviceCount < MAX_SERVICES) &&
+           (attributeCount + requiredAttributes <= MAX_ATTRIBUTES) &&
+           ((unsigned)firstHandle + attributeCount + requiredAttributes - 1 <= 0xFFFF);
+}
+
+bool
+GattAttributeDatabase::appendServiceDeclaration(const UUID &uuid)
+{
+    UUIDIndex_t primaryServiceType = internUUID(UUID(BLE_UUID_SERVICE_PRIMARY));
+    UUIDIndex_t serviceUUID        = internUUID(uuid);
+    if ((primaryServiceType == INVALID_UUID_INDEX) || (serviceUUID == INVALID_UUID_INDEX)) {
+        return false;
+    }
+
+    serviceUUIDs[serviceCount] = serviceUUID; /* takes effect with commitService() */
+    appendAttribute(primaryServiceType, NULL, 0, 0, GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ);
+    return true;
+}
+
+bool
+GattAttributeDatabase::appendCharacteristicDeclaration(uint8_t props)
+{
+    UUIDIndex_t characteristicType = internUUID(UUID(BLE_UUID_CHARACTERISTIC));
+    if (characteristicType == INVALID_UUID_INDEX) {
+        return false;
+    }
+
+    appendAttribute(characteristicType, NULL, 0, 0, props);
+    return true;
+}
+
+/**
+ * Append a value or descriptor attribute. Its value is copied into the
+ * arena, with room for maxLength bytes (or initialLength, if larger), unless
+ * it is a constant: constants are referred to where they are.
+ */
+bool
+GattAttributeDatabase::appendValue(const UUID    &type,
+                                   const uint8_t *initialValue,
+                                   uint16_t       initialLength,
+                                   uint16_t       maxLength,
+                                   uint8_t        props,
+                                   bool           constant)
+{
+    UUIDIndex_t typeIndex = internUUID(type);
+    if (typeIndex == INVALID_UUID_INDEX) {
+        return false;
+    }
+
+    uint8_t *value;
+    if (constant) {
+        value     = const_cast<uint8_t *>(initialValue);
+        maxLength = 0;
+    } else {
+        if (maxLength < initialLength) {
+            maxLength = initialLength;
+        }
+        value = allocateValue(maxLength);
+        if ((maxLength > 0) && (value == NULL)) {
+            return false;
+        }
+        if (initialValue != NULL) {
+            memcpy(value, initialValue, initialLength);
+        }
+    }
+
+    appendAttribute(typeIndex, value, initialLength, maxLength, props);
+    return true;
+}
+
+bool
+GattAttributeDatabase::appendImplicitCCCD(uint8_t props)
+{
+    if (!(props & (GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE))) {
+        return true;
+    }
+
+    /* CCCD values are connection specific; they are left to the owner of the database. */
+    UUIDIndex_t cccdType = internUUID(UUID(BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG));
+    if (cccdType == INVALID_UUID_INDEX) {
+        return false;
+    }
+    appendAttribute(cccdType, NULL, 0, sizeof(uint16_t),
+                    GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE);
+    return true;
+}
+
+void
+GattAttributeDatabase::commitService(GattAttribute::Handle_t serviceHandle)
+{
+    serviceStart[serviceCount] = indexOf(serviceHandle);
+    serviceEnd[serviceCount]   = (AttributeIndex_t)(attributeCount - 1);
+    serviceCount++;
+
+    updateHash(serviceHandle, getLastHandle());
+}
+
+/**
+ * Extend the Database Hash with a range of attributes. Declarations
+ * contribute their handle, type and value; descriptors of the types listed
+ * in the specification their handle and type. Services are appended in
+ * handle order, which is what lets the hash be computed incrementally.
+ */
+void
+GattAttributeDatabase::updateHash(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle)
+{
+    for (GattAttribute::Handle_t handle = startHandle; handle <= endHandle; handle++) {
+        const UUID &type = getType(handle);
+        if (type != UUID(type.getShortUUID())) {
+            continue; /* not one of the 16-bit types below, whatever its width */
+        }
+
+        bool withValue;
+        switch (type.getShortUUID()) {
+            case BLE_UUID_SERVICE_PRIMARY:
+            case BLE_UUID_SERVICE_SECONDARY:
+            case BLE_UUID_SERVICE_INCLUDE:
+            case BLE_UUID_CHARACTERISTIC:
+            case BLE_UUID_DESCRIPTOR_CHAR_EXT_PROP:
+                withValue = true;
+                break;
+            case BLE_UUID_DESCRIPTOR_CHAR_USER_DESC:
+            case BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG:
+            case BLE_UUID_DESCRIPTOR_SERVER_CHAR_CONFIG:
+            case BLE_UUID_DESCRIPTOR_CHAR_PRESENTATION_FORMAT:
+            case BLE_UUID_DESCRIPTOR_CHAR_AGGREGATE_FORMAT:
+                withValue = false;
+                break;
+            default:
+                continue;
+        }
+
+        uint8_t  entry[2 * sizeof(uint16_t) + 1 + sizeof(GattAttribute::Handle_t) + UUID::LENGTH_OF_LONG_UUID];
+        uint16_t length = 0;
+        if (withValue) {
+            length = sizeof(entry) - 2 * sizeof(uint16_t);
+            read(handle, &entry[2 * sizeof(uint16_t)], &length);
+        }
+        entry[0] = (uint8_t)(handle & 0xFF);
+        entry[1] = (uint8_t)(handle >> 8);
+        encodeUUID(UUID(type.getShortUUID()), &entry[2]);
+        hash.update(entry, 2 * sizeof(uint16_t) + length);
+    }
+}
+
+/**
+ * After a service failed to fit, leave none of its attributes with a handle
+ * which may be reused by the next service.
+ */
+void
+GattAttributeDatabase::clearHandles(GattService &service)
+{
+    for (uint8_t i = 0; i < service.getCharacteristicCount(); i++) {
+        GattCharacteristic *characteristic = service.getCharacteristic(i);
+        characteristic->getValueAttribute().setHandle(GattAttribute::INVALID_HANDLE);
+        for (uint8_t j = 0; j < characteristic->getDescriptorCount(); j++) {
+            characteristic->getDescriptor(j)->setHandle(GattAttribute::INVALID_HANDLE);
+        }
+    }
+}
+
+void
+GattAttributeDatabase::clearHandles(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles)
+{
+    if (valueHandles == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < definition.characteristicCount; i++) {
+        valueHandles[i] = GattAttribute::INVALID_HANDLE;
+    }
+}
+
+void
+GattAttributeDatabase::rollback(unsigned attributes, unsigned uuidTableSize, unsigned arena)
+{
+    unsigned kept = 0;
+    for (unsigned i = 0; i < attributeCount; i++) {
+        if (attributesByType[i] < attributes) {
+            attributesByType[kept++] = attributesByType[i];
+        }
+    }
+    attributeCount = attributes;
+
+    kept = 0;
+    for (unsigned i = 0; i < uuidCount; i++) {
+        if (uuidsSorted[i] < uuidTableSize) {
+            uuidsSorted[kept++] = uuidsSorted[i];
+        }
+    }
+    uuidCount = uuidTableSize;
+
+    arenaUsed = arena;
+}
+
+uint8_t *
+GattAttributeDatabase::allocateValue(uint16_t maxLength)
+{
+    if (maxLength == 0) {
+        return NULL;
+    }
+    if (arenaUsed + maxLength > VALUE_ARENA_SIZE) {
+        return NULL;
+    }
+
+    uint8_t *value = &valueArena[arenaUsed];
+    memset(value, 0, maxLength);
+    arenaUsed += maxLength;
+
+    return value;
+}
+
+/* UUIDs are ordered by their 128-bit form, so equal values of different widths compare equal. */
+int
+GattAttributeDatabase::compareUUIDs(const UUID &a, const UUID &b)
+{
+    return memcmp(a.getLongUUID(), b.getLongUUID(), UUID::LENGTH_OF_LONG_UUID);
+}
@@ -0,0 +1,649 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/GattDiscoveryEngine.h"
+#include "ble/GattCharacteristic.h"
+#include "ble/AttPdu.h"
+
+/* The largest request the engine sends: a Read By Type Request for a 16-bit type. */
+static const unsigned MAX_REQUEST_LENGTH = 5 + sizeof(UUID::ShortUUIDBytes_t);
+
+/* The value of a characteristic declaration: properties(1) valueHandle(2) uuid(2 or 16) */
+static const unsigned DECLARATION_HEADER_LENGTH = 3;
+
+static bool
+isWildcard(const UUID &filter)
+{
+    return (filter.shortOrLong() == UUID::UUID_TYPE_SHORT) && (filter.getShortUUID() == BLE_UUID_UNKNOWN);
+}
+
+static bool
+matches(const UUID &filter, const UUID &uuid)
+{
+    return isWildcard(filter) || (filter == uuid);
+}
+
+/* An empty filter doesn't track what has been found: nothing counts as found, and there is never all of it. */
+static bool
+isFound(const UUIDSet &filter, uint32_t found, const UUID &uuid)
+{
+    int index = filter.find(uuid);
+    return (index != UUIDSet::NOT_FOUND) && ((found & ((uint32_t)1 << index)) != 0);
+}
+
+static void
+markFound(const UUIDSet &filter, uint32_t *foundP, const UUID &uuid)
+{
+    int index = filter.find(uuid);
+    if (index != UUIDSet::NOT_FOUND) {
+        *foundP |= (uint32_t)1 << index;
+    }
+}
+
+static bool
+isAllFound(const UUIDSet &filter, uint32_t found)
+{
+    return !filter.isEmpty() && (found == filter.getMembers());
+}
+
+/* service, include and characteristic declarations */
+static bool
+isDeclaration(const UUID &type)
+{
+    return (type == UUID(type.getShortUUID())) &&
+           (type.getShortUUID() >= BLE_UUID_SERVICE_PRIMARY) && (type.getShortUUID() <= BLE_UUID_CHARACTERISTIC);
+}
+
+GattDiscoveryEngine::GattDiscoveryEngine(GattClient &clientIn) :
+    client(clientIn),
+    defaultTerminationCallback(NULL),
+    contexts()
+{
+    reset();
+}
+
+ble_error_t
+GattDiscoveryEngine::launch(Gap::Handle_t                               connectionHandle,
+                            ServiceDiscovery::ServiceCallback_t         sc,
+                            ServiceDiscovery::CharacteristicCallback_t  cc,
+                            const UUID                                 &matchingServiceUUID,
+                            const UUID                                 &matchingCharacteristicUUID,
+                            ServiceDiscovery::TerminationCallback_t     tc)
+{
+    ble_error_t error;
+    Context_t  *context = allocateContext(connectionHandle, &error);
+    if (context == NULL) {
+        return error;
+    }
+
+    context->matchingServiceUUID        = matchingServiceUUID;
+    context->matchingCharacteristicUUID = matchingCharacteristicUUID;
+    return startServiceDiscovery(*context, sc, cc,
+                                 UUIDSet(&context->matchingServiceUUID, isWildcard(matchingServiceUUID) ? 0 : 1),
+                                 UUIDSet(&context->matchingCharacteristicUUID, isWildcard(matchingCharacteristicUUID) ? 0 : 1),
+                                 tc);
+}
+
+ble_error_t
+GattDiscoveryEngine::launch(Gap::Handle_t                               connectionHandle,
+                            ServiceDiscovery::ServiceCallback_t         sc,
+                            ServiceDiscovery::CharacteristicCallback_t  cc,
+                            const UUIDSet                              &matchingServiceUUIDs,
+                            const UUIDSet                              &matchingCharacteristicUUIDs,
+                            ServiceDiscovery::TerminationCallback_t     tc)
+{
+    if (matchingServiceUUIDs.isTruncated() || matchingCharacteristicUUIDs.isTruncated()) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    ble_error_t error;
+    Context_t  *context = allocateContext(connectionHandle, &error);
+    if (context == NULL) {
+        return error;
+    }
+
+    return startServiceDiscovery(*context, sc, cc, matchingServiceUUIDs, matchingCharacteristicUUIDs, tc);
+}
+
+ble_error_t
+GattDiscoveryEngine::launchDescriptorDiscovery(const DiscoveredCharacteristic          &characteristic,
+                                               ServiceDiscovery::DescriptorCallback_t   callback,
+                                               const UUID                              &matchingUUID,
+                                               ServiceDiscovery::TerminationCallback_t  tc)
+{
+    if (characteristic.getValueHandle() == GattAttribute::INVALID_HANDLE) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    ble_error_t error;
+    Context_t  *context = allocateContext(characteristic.getConnectionHandle(), &error);
+    if (context == NULL) {
+        return error;
+    }
+
+    context->descriptors            = true;
+    context->singleCharacteristic   = true;
+    context->descriptorCallback     = callback;
+    context->terminationCallback    = tc;
+    context->matchingDescriptorUUID = matchingUUID;
+    context->descriptorSearchHandle = characteristic.getValueHandle() + 1; /* 0 if the value is the last attribute */
+    context->descriptorEndHandle    = 0xFFFF;
+    context->descriptorOwner        = characteristic.getValueHandle();
+    return start(*context);
+}
+
+ble_error_t
+GattDiscoveryEngine::launchDescriptorDiscovery(Gap::Handle_t                            connectionHandle,
+                                               GattAttribute::Handle_t                  startHandle,
+                                               GattAttribute::Handle_t                  endHandle,
+                                               ServiceDiscovery::DescriptorCallback_t   callback,
+                                               const UUID                              &matchingUUID,
+                                               ServiceDiscovery::TerminationCallback_t  tc)
+{
+    if ((startHandle == GattAttribute::INVALID_HANDLE) || (endHandle < startHandle)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    ble_error_t error;
+    Context_t  *context = allocateContext(connectionHandle, &error);
+    if (context == NULL) {
+        return error;
+    }
+
+    context->descriptors            = true;
+    context->singleCharacteristic   = false;
+    context->descriptorCallback     = callback;
+    context->terminationCallback    = tc;
+    context->matchingDescriptorUUID = matchingUUID;
+    context->descriptorSearchHandle = startHandle;
+    context->descriptorEndHandle    = endHandle;
+    context->descriptorOwner        = GattAttribute::INVALID_HANDLE;
+    return start(*context);
+}
+
+bool
+GattDiscoveryEngine::isActive(void) const
+{
+    for (unsigned i = 0; i < MAX_CONTEXTS; i++) {
+        if (contexts[i].active) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+GattDiscoveryEngine::isActive(Gap::Handle_t connectionHandle) const
+{
+    const Context_t *context = findContext(connectionHandle);
+    return (context != NULL) && context->active;
+}
+
+void
+GattDiscoveryEngine::terminate(void)
+{
+    for (unsigned i = 0; i < MAX_CONTEXTS; i++) {
+        if (contexts[i].active) {
+            finish(contexts[i]);
+        }
+    }
+}
+
+void
+GattDiscoveryEngine::terminate(Gap::Handle_t connectionHandle)
+{
+    Context_t *context = findContext(connectionHandle);
+    if ((context != NULL) && context->active) {
+        finish(*context);
+    }
+}
+
+void
+GattDiscoveryEngine::reset(void)
+{
+    for (unsigned i = 0; i < MAX_CONTEXTS; i++) {
+        contexts[i].active           = false;
+        contexts[i].awaitingResponse = false;
+        contexts[i].discardResponse  = false;
+    }
+}
+
+/**
+ * A response belongs to the engine if it answers, or reports an error for,
+ * the request outstanding on the connection.
+ */
+bool
+GattDiscoveryEngine::processResponse(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length)
+{
+    Context_t *context = findContext(connectionHandle);
+    if ((context == NULL) || !context->awaitingResponse || (length == 0)) {
+        return false;
+    }
+
+    AttErrorResponseView error(pdu, length);
+    bool                 isError = error.isValid() && (error.getRequestOpcode() == context->requestOpcode);
+    if (!isError && (pdu[0] != context->requestOpcode + 1)) {
+        return false;
+    }
+
+    context->awaitingResponse = false;
+    if (context->discardResponse) {
+        context->discardResponse = false;
+        advance(*context);
+        return true;
+    }
+    if (!context->active) {
+        return true;
+    }
+
+    /* An error, typically Attribute Not Found, ends the search at hand. */
+    if (context->requestOpcode == AttPdu::FIND_INFORMATION_REQ) {
+        if (isError) {
+            context->descriptorSearchHandle = 0;
+        } else {
+            processDescriptors(*context, pdu, length);
+        }
+    } else if (context->requestOpcode == AttPdu::READ_BY_GROUP_TYPE_REQ) {
+        if (isError) {
+            context->servicesDone = true;
+        } else {
+            processServices(*context, pdu, length);
+        }
+    } else {
+        if (isError) {
+            context->characteristicSearchHandle = 0;
+        } else {
+            processCharacteristics(*context, pdu, length);
+        }
+    }
+
+    advance(*context);
+    return true;
+}
+
+void
+GattDiscoveryEngine::processDisconnection(Gap::Handle_t connectionHandle)
+{
+    Context_t *context = findContext(connectionHandle);
+    if (context == NULL) {
+        return;
+    }
+
+    context->awaitingResponse = false;
+    context->discardResponse  = false;
+    if (context->active) {
+        finish(*context);
+    }
+}
+
+/**
+ * A context for a new discovery on a connection. One whose discovery has
+ * ended may still await a response; it is reused.
+ */
+GattDiscoveryEngine::Context_t *
+GattDiscoveryEngine::allocateContext(Gap::Handle_t connectionHandle, ble_error_t *errorP)
+{
+    Context_t *context = findContext(connectionHandle);
+    if ((context != NULL) && context->active) {
+        *errorP = BLE_STACK_BUSY;
+        return NULL;
+    }
+    for (unsigned i = 0; (context == NULL) && (i < MAX_CONTEXTS); i++) {
+        if (!contexts[i].active && !contexts[i].awaitingResponse) {
+            context = &contexts[i];
+        }
+    }
+    if (context == NULL) {
+        *errorP = BLE_ERROR_NO_MEM;
+        return NULL;
+    }
+
+    context->connHandle = connectionHandle;
+    return context;
+}
+
+ble_error_t
+GattDiscoveryEngine::startServiceDiscovery(Context_t                                  &context,
+                                           ServiceDiscovery::ServiceCallback_t         sc,
+                                           ServiceDiscovery::CharacteristicCallback_t  cc,
+                                           const UUIDSet                              &matchingServiceUUIDs,
+                                           const UUIDSet                              &matchingCharacteristicUUIDs,
+                                           ServiceDiscovery::TerminationCallback_t     tc)
+{
+    context.descriptors                = false;
+    context.serviceCallback            = sc;
+    context.characteristicCallback     = cc;
+    context.terminationCallback        = tc;
+    context.serviceFilter              = matchingServiceUUIDs;
+    context.characteristicFilter       = matchingCharacteristicUUIDs;
+    context.servicesFound              = 0;
+    context.characteristicsFound       = 0;
+    context.servicesDone               = false;
+    context.serviceSearchHandle        = 0x0001;
+    context.serviceCount               = 0;
+    context.serviceIndex               = 0;
+    context.serviceStarted             = false;
+    context.characteristicSearchHandle = 0;
+    return start(context);
+}
+
+/**
+ * Activate a context set up for a new discovery, and send its first request;
+ * if it still awaits a response, the request goes out once the stale
+ * response has been discarded.
+ */
+ble_error_t
+GattDiscoveryEngine::start(Context_t &context)
+{
+    context.active = true;
+    if (context.awaitingResponse) {
+        context.discardResponse = true;
+        return BLE_ERROR_NONE;
+    }
+
+    uint8_t  pdu[MAX_REQUEST_LENGTH];
+    uint16_t length;
+    if (!context.descriptors) {
+        length = AttPdu::buildReadByTypeRequest(pdu, sizeof(pdu), AttPdu::READ_BY_GROUP_TYPE_REQ,
+                                                0x0001, 0xFFFF, UUID(BLE_UUID_SERVICE_PRIMARY));
+    } else if (context.descriptorSearchHandle != 0) {
+        length = AttPdu::buildFindInformationRequest(pdu, sizeof(pdu), context.descriptorSearchHandle, context.descriptorEndHandle);
+    } else {
+        /* nothing to search */
+        finish(context);
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t error = send(context, pdu, length);
+    if (error != BLE_ERROR_NONE) {
+        context.active = false;
+    }
+    return error;
+}
+
+GattDiscoveryEngine::Context_t *
+GattDiscoveryEngine::findContext(Gap::Handle_t connectionHandle)
+{
+    for (unsigned i = 0; i < MAX_CONTEXTS; i++) {
+        if ((contexts[i].active || contexts[i].awaitingResponse) && (contexts[i].connHandle == connectionHandle)) {
+            return &contexts[i];
+        }
+    }
+    return NULL;
+}
+
+const GattDiscoveryEngine::Context_t *
+GattDiscoveryEngine::findContext(Gap::Handle_t connectionHandle) const
+{
+    return const_cast<GattDiscoveryEngine *>(this)->findContext(connectionHandle);
+}
+
+/**
+ * Matching services are held until their characteristics have been
+ * discovered, unless characteristics aren't wanted, in which case they are
+ * reported straight away. If more match than can be held, the next search
+ * starts again from the first which didn't fit. With a set of services, only
+ * the first instance of each matches, and the search ends once all of them
+ * have been found.
+ */
+void
+GattDiscoveryEngine::processServices(Context_t &context, const uint8_t *pdu, uint16_t length)
+{
+    AttListResponseView view(pdu, length);
+    if (!view.isValid() || (view.getOpcode() != AttPdu::READ_BY_GROUP_TYPE_RSP)) {
+        context.servicesDone = true;
+        return;
+    }
+
+    context.serviceCount   = 0;
+    context.serviceIndex   = 0;
+    context.serviceStarted = false;
+    for (unsigned i = 0; i < view.getCount(); i++) {
+        GattAttribute::Handle_t startHandle = view.getHandle(i);
+        GattAttribute::Handle_t endHandle   = view.getEndHandle(i);
+        UUID                    uuid        = view.getUUID(i);
+        if ((startHandle < context.serviceSearchHandle) || (endHandle < startHandle)) {
+            /* out of order; stop rather than search the same range again */
+            context.servicesDone = true;
+            return;
+        }
+
+        if (context.serviceFilter.matches(uuid) && !isFound(context.serviceFilter, context.servicesFound, uuid)) {
+            if (context.characteristicCallback) {
+                if (context.serviceCount == MAX_PENDING_SERVICES) {
+                    return;
+                }
+                PendingService_t &service = context.services[context.serviceCount++];
+                service.startHandle = startHandle;
+                service.endHandle   = endHandle;
+                service.uuid        = uuid;
+            } else if (context.serviceCallback && context.characteristicFilter.isEmpty()) {
+                DiscoveredService service;
+                service.setup(uuid, startHandle, endHandle);
+                context.serviceCallback(&service);
+                if (!isRunning(context)) {
+                    return;
+                }
+            }
+            markFound(context.serviceFilter, &context.servicesFound, uuid);
+        }
+
+        context.serviceSearchHandle = endHandle + 1;
+        if ((endHandle == 0xFFFF) || isAllFound(context.serviceFilter, context.servicesFound)) {
+            context.servicesDone = true;
+            return;
+        }
+    }
+}
+
+void
+GattDiscoveryEngine::processCharacteristics(Context_t &context, const uint8_t *pdu, uint16_t length)
+{
+    AttListResponseView     view(pdu, length);
+    const PendingService_t &service = context.services[context.serviceIndex];
+    if (!view.isValid() || (view.getOpcode() != AttPdu::READ_BY_TYPE_RSP) ||
+        ((view.getValueLength() != DECLARATION_HEADER_LENGTH + sizeof(UUID::ShortUUIDBytes_t)) &&
+         (view.getValueLength() != DECLARATION_HEADER_LENGTH + UUID::LENGTH_OF_LONG_UUID))) {
+        context.characteristicSearchHandle = 0;
+        return;
+    }
+
+    for (unsigned i = 0; i < view.getCount(); i++) {
+        GattAttribute::Handle_t declHandle = view.getHandle(i);
+        if ((declHandle < context.characteristicSearchHandle) || (declHandle > service.endHandle)) {
+            context.characteristicSearchHandle = 0;
+            return;
+        }
+        context.characteristicSearchHandle = declHandle + 1;
+
+        const uint8_t *declaration = view.getValue(i);
+        UUID           uuid        = AttPdu::decodeUUID(&declaration[DECLARATION_HEADER_LENGTH],
+                                                        view.getValueLength() - DECLARATION_HEADER_LENGTH);
+        if (!context.characteristicFilter.matches(uuid)) {
+            continue;
+        }
+
+        /* With both filters set, one instance of each characteristic is wanted. */
+        bool isSingular = !context.serviceFilter.isEmpty() && !context.characteristicFilter.isEmpty();
+        if (isSingular) {
+            if (isFound(context.characteristicFilter, context.characteristicsFound, uuid)) {
+                continue;
+            }
+            markFound(context.characteristicFilter, &context.characteristicsFound, uuid);
+        }
+
+        EngineCharacteristic characteristic;
+        characteristic.setup(&client, context.connHandle, uuid, declaration[0], declHandle, AttPdu::readUint16(&declaration[1]));
+        context.characteristicCallback(&characteristic);
+        if (!isRunning(context)) {
+            return;
+        }
+
+        if (isSingular && isAllFound(context.characteristicFilter, context.characteristicsFound)) {
+            finish(context);
+            return;
+        }
+    }
+}
+
+/**
+ * Descriptors are attributed to the characteristic declared before them;
+ * the characteristic's value, which follows its declaration, isn't one.
+ * Attributes before the first characteristic declaration in the range, and
+ * after a service declaration, belong to no characteristic and are skipped.
+ */
+void
+GattDiscoveryEngine::processDescriptors(Context_t &context, const uint8_t *pdu, uint16_t length)
+{
+    AttListResponseView view(pdu, length);
+    if (!view.isValid() || (view.getOpcode() != AttPdu::FIND_INFORMATION_RSP)) {
+        context.descriptorSearchHandle = 0;
+        return;
+    }
+
+    for (unsigned i = 0; i < view.getCount(); i++) {
+        GattAttribute::Handle_t handle = view.getHandle(i);
+        if ((handle < context.descriptorSearchHandle) || (handle > context.descriptorEndHandle)) {
+            context.descriptorSearchHandle = 0;
+            return;
+        }
+        context.descriptorSearchHandle = handle + 1; /* 0 past the last handle */
+
+        UUID type = view.getUUID(i);
+        if (isDeclaration(type)) {
+            if (context.singleCharacteristic) {
+                context.descriptorSearchHandle = 0;
+                return;
+            }
+            context.descriptorOwner = (type == UUID(BLE_UUID_CHARACTERISTIC)) ? handle + 1 : GattAttribute::INVALID_HANDLE;
+            continue;
+        }
+        if ((context.descriptorOwner == GattAttribute::INVALID_HANDLE) || (handle == context.descriptorOwner) ||
+            !matches(context.matchingDescriptorUUID, type) || !context.descriptorCallback) {
+            continue;
+        }
+
+        DiscoveredDescriptor descriptor;
+        descriptor.handle      = handle;
+        descriptor.uuid        = type;
+        descriptor.connHandle  = context.connHandle;
+        descriptor.valueHandle = context.descriptorOwner;
+        context.descriptorCallback(&descriptor);
+        if (!isRunning(context)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Issue the next request: for descriptors, for the characteristics of the
+ * pending service at hand, or for more services. Services are reported as they are reached,
+ * so their characteristics follow them.
+ */
+void
+GattDiscoveryEngine::advance(Context_t &context)
+{
+    while (isRunning(context)) {
+        uint8_t  pdu[MAX_REQUEST_LENGTH];
+        uint16_t length;
+
+        if (context.descriptors) {
+            if ((context.descriptorSearchHandle == 0) || (context.descriptorSearchHandle > context.descriptorEndHandle)) {
+                finish(context);
+                return;
+            }
+            length = AttPdu::buildFindInformationRequest(pdu, sizeof(pdu), context.descriptorSearchHandle, context.descriptorEndHandle);
+        } else if (context.serviceIndex < context.serviceCount) {
+            const PendingService_t &service = context.services[context.serviceIndex];
+            if (!context.serviceStarted) {
+                context.serviceStarted             = true;
+                context.characteristicSearchHandle = service.startHandle + 1;
+                if (context.serviceCallback && context.characteristicFilter.isEmpty()) {
+                    DiscoveredService discoveredService;
+                    discoveredService.setup(service.uuid, service.startHandle, service.endHandle);
+                    context.serviceCallback(&discoveredService);
+                }
+                continue;
+            }
+            if ((context.characteristicSearchHandle == 0) || (context.characteristicSearchHandle > service.endHandle)) {
+                context.serviceIndex++;
+                context.serviceStarted = false;
+                continue;
+            }
+            length = AttPdu::buildReadByTypeRequest(pdu, sizeof(pdu), AttPdu::READ_BY_TYPE_REQ,
+                                                    context.characteristicSearchHandle, service.endHandle,
+                                                    UUID(BLE_UUID_CHARACTERISTIC));
+        } else if (!context.servicesDone) {
+            length = AttPdu::buildReadByTypeRequest(pdu, sizeof(pdu), AttPdu::READ_BY_GROUP_TYPE_REQ,
+                                                    context.serviceSearchHandle, 0xFFFF,
+                                                    UUID(BLE_UUID_SERVICE_PRIMARY));
+        } else {
+            finish(context);
+            return;
+        }
+
+        if (send(context, pdu, length) != BLE_ERROR_NONE) {
+            finish(context);
+        }
+        return;
+    }
+}
+
+ble_error_t
+GattDiscoveryEngine::send(Context_t &context, const uint8_t *pdu, uint16_t length)
+{
+    ble_error_t error = sendRequest(context.connHandle, pdu, length);
+    if (error == BLE_ERROR_NONE) {
+        context.awaitingResponse = true;
+        context.requestOpcode    = pdu[0];
+    }
+    return error;
+}
+
+void
+GattDiscoveryEngine::finish(Context_t &context)
+{
+    ServiceDiscovery::TerminationCallback_t callback = context.terminationCallback ? context.terminationCallback
+                                                                                   : defaultTerminationCallback;
+    context.active          = false;
+    context.discardResponse = context.awaitingResponse;
+    if (callback) {
+        callback(context.connHandle);
+    }
+}
+
+void
+GattDiscoveryEngine::EngineCharacteristic::setup(GattClient              *gattcIn,
+                                                 Gap::Handle_t            connHandleIn,
+                                                 const UUID              &uuidIn,
+                                                 uint8_t                  propertiesIn,
+                                                 GattAttribute::Handle_t  declHandleIn,
+                                                 GattAttribute::Handle_t  valueHandleIn)
+{
+    gattc       = gattcIn;
+    connHandle  = connHandleIn;
+    uuid        = uuidIn;
+    declHandle  = declHandleIn;
+    valueHandle = valueHandleIn;
+
+    props._broadcast       = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_BROADCAST) ? 1 : 0;
+    props._read            = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ) ? 1 : 0;
+    props._writeWoResp     = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE) ? 1 : 0;
+    props._write           = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE) ? 1 : 0;
+    props._notify          = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY) ? 1 : 0;
+    props._indicate        = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE) ? 1 : 0;
+    props._authSignedWrite = (propertiesIn & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_AUTHENTICATED_SIGNED_WRITES) ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/GattHVXBuffer.h"
+
+GattHVXBuffer::GattHVXBuffer(uint8_t *storageIn, uint16_t sizeIn) :
+    storage(storageIn),
+    size(sizeIn),
+    head(0),
+    tail(0),
+    droppedCount(0)
+{
+    /* empty */
+}
+
+/**
+ * The head never catches up with the tail, as that would make the buffer
+ * look empty; a value which doesn't fit before the end of the storage goes
+ * to the start, and the remainder is marked as unused.
+ */
+bool
+GattHVXBuffer::push(const uint8_t *data, uint16_t length)
+{
+    uint16_t currentTail = tail;
+    uint32_t required    = (uint32_t)LENGTH_SIZE + length;
+    uint16_t offset      = head;
+
+    if (offset >= currentTail) {
+        if ((offset + required > size) || ((offset + required == size) && (currentTail == 0))) {
+            /* wrap around, if there is room at the start */
+            if (required >= currentTail) {
+                droppedCount++;
+                return false;
+            }
+            if (size - offset >= LENGTH_SIZE) {
+                writeLength(offset, WRAP_MARKER);
+            }
+            offset = 0;
+        }
+    } else if (offset + required >= currentTail) {
+        droppedCount++;
+        return false;
+    }
+
+    writeLength(offset, length);
+    memcpy(&storage[offset + LENGTH_SIZE], data, length);
+    head = (uint16_t)((offset + required == size) ? 0 : offset + required);
+    return true;
+}
+
+bool
+GattHVXBuffer::front(const uint8_t **dataP, uint16_t *lengthP) const
+{
+    if (isEmpty()) {
+        return false;
+    }
+
+    uint16_t offset = getFrontOffset();
+    *lengthP = readLength(offset);
+    *dataP   = &storage[offset + LENGTH_SIZE];
+    return true;
+}
+
+void
+GattHVXBuffer::pop(void)
+{
+    if (isEmpty()) {
+        return;
+    }
+
+    uint16_t offset = getFrontOffset();
+    uint32_t next   = (uint32_t)offset + LENGTH_SIZE + readLength(offset);
+    tail = (uint16_t)((next == size) ? 0 : next);
+}
+
+uint16_t
+GattHVXBuffer::readLength(uint16_t offset) const
+{
+    return (uint16_t)(storage[offset] | (storage[offset + 1] << 8));
+}
+
+void
+GattHVXBuffer::writeLength(uint16_t offset, uint16_t length)
+{
+    storage[offset]     = (uint8_t)(length & 0xFF);
+    storage[offset + 1] = (uint8_t)(length >> 8);
+}
+
+/* Skip the unused end of the storage, if the oldest value has wrapped around. */
+uint16_t
+GattHVXBuffer::getFrontOffset(void) const
+{
+    uint16_t offset = tail;
+    if ((size - offset < LENGTH_SIZE) || (readLength(offset) == WRAP_MARKER)) {
+        return 0;
+    }
+    return offset;
+}
@@ -0,0 +1,153 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/BLE.h"
+#include "ble/GattLongRead.h"
+
+GattLongRead::GattLongRead(BLE &bleIn, uint8_t *bufferIn, uint16_t capacityIn) :
+    ble(bleIn),
+    buffer(bufferIn),
+    capacity(capacityIn),
+    connHandle(0),
+    handle(GattAttribute::INVALID_HANDLE),
+    completionCallback(NULL),
+    active(false),
+    status(BLE_ERROR_NONE),
+    length(0),
+    nextOffset(0),
+    outstanding(0),
+    roundTrips(0)
+{
+    /* empty */
+}
+
+ble_error_t
+GattLongRead::read(Gap::Handle_t connHandleIn, GattAttribute::Handle_t attributeHandle, CompletionCallback_t callback)
+{
+    if (active) {
+        return BLE_STACK_BUSY;
+    }
+
+    connHandle         = connHandleIn;
+    handle             = attributeHandle;
+    completionCallback = callback;
+    active             = true;
+    status             = BLE_STACK_BUSY;
+    length             = 0;
+    nextOffset         = 0;
+    roundTrips         = 0;
+
+    /* Most values fit in one response, so the Read Blob Requests wait until the first response shows otherwise. */
+    outstanding = 1;
+    ble_error_t error = ble.gattClient().queueRead(connHandle, handle, 0, onRead, this);
+    if (error != BLE_ERROR_NONE) {
+        active      = false;
+        outstanding = 0;
+        status      = error;
+    }
+    return error;
+}
+
+/**
+ * Responses arrive in the order of the requests. One at an offset other than
+ * the end of what has been received (after the ATT MTU has changed in the
+ * middle of a read) is dropped, and reading resumes from the end. Servers
+ * differ in how they answer a Read Blob Request at the very end of a value
+ * which is a multiple of ATT_MTU - 1 bytes long: with an empty response, or
+ * with an Invalid Offset or Attribute Not Long error; each ends the value.
+ */
+void
+GattLongRead::onRead(const GattClient::RequestResult_t *result)
+{
+    GattLongRead *read = static_cast<GattLongRead *>(result->context);
+    if (!read->active || (result->connHandle != read->connHandle) || (result->handle != read->handle)) {
+        return;
+    }
+    read->outstanding--;
+    read->roundTrips++;
+
+    if (result->status != BLE_ERROR_NONE) {
+        bool endOfValue = (result->offset == read->length) && (result->offset != 0) &&
+                          ((result->attError == AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET) ||
+                           (result->attError == AUTH_CALLBACK_REPLY_ATTERR_ATTRIBUTE_NOT_LONG));
+        read->finish(endOfValue ? BLE_ERROR_NONE : result->status);
+        return;
+    }
+    if (result->offset != read->length) {
+        read->nextOffset = read->length;
+        read->fillWindow();
+        return;
+    }
+
+    uint16_t room = read->capacity - read->length;
+    if (result->len > room) {
+        memcpy(&read->buffer[read->length], result->data, room);
+        read->length = read->capacity;
+        read->finish(BLE_ERROR_BUFFER_OVERFLOW);
+        return;
+    }
+    memcpy(&read->buffer[read->length], result->data, result->len);
+    read->length += result->len;
+
+    if (result->len < read->ble.gap().getAttMtu(read->connHandle) - 1) {
+        read->finish(BLE_ERROR_NONE);
+        return;
+    }
+    read->fillWindow();
+}
+
+/**
+ * Queue Read Blob Requests ahead, each assuming the responses before it to
+ * be full. A full buffer is followed by one more request, which tells a
+ * value that fits exactly from one which is too long.
+ */
+void
+GattLongRead::fillWindow(void)
+{
+    uint16_t chunk = ble.gap().getAttMtu(connHandle) - 1;
+    if (nextOffset < length) {
+        nextOffset = length;
+    }
+
+    while (active && (outstanding < BLE_GATT_LONG_READ_WINDOW) && (nextOffset <= capacity)) {
+        outstanding++;
+        ble_error_t error = ble.gattClient().queueRead(connHandle, handle, (uint16_t)nextOffset, onRead, this);
+        if (error != BLE_ERROR_NONE) {
+            /* The queue is full; unless nothing is left to bring the next response, the window is refilled then. */
+            outstanding--;
+            if (outstanding == 0) {
+                finish(error);
+            }
+            return;
+        }
+        nextOffset += chunk;
+    }
+}
+
+void
+GattLongRead::finish(ble_error_t statusIn)
+{
+    active       = false;
+    status       = statusIn;
+    outstanding -= ble.gattClient().cancelQueuedRequests(connHandle, this);
+
+    if (completionCallback != NULL) {
+        CompletionCallback_t callback = completionCallback;
+        completionCallback = NULL;
+        callback(this);
+    }
+}
@@ -0,0 +1,217 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/BLE.h"
+#include "ble/GattReadBatch.h"
+#include "ble/AttPdu.h"
+
+GattReadBatch::GattReadBatch(BLE &bleIn) :
+    ble(bleIn),
+    connHandle(0),
+    completionCallback(NULL),
+    count(0),
+    pending(0),
+    roundTrips(0),
+    multipleCount(0),
+    fixedLengths(false),
+    issuing(false),
+    arenaUsed(0)
+{
+    /* empty */
+}
+
+ble_error_t
+GattReadBatch::read(Gap::Handle_t                  connHandleIn,
+                    const GattAttribute::Handle_t *handlesIn,
+                    uint8_t                        countIn,
+                    CompletionCallback_t           callback,
+                    const uint16_t                *lengthsIn)
+{
+    if (pending != 0) {
+        return BLE_STACK_BUSY;
+    }
+    if ((countIn == 0) || (countIn > MAX_HANDLES)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    connHandle         = connHandleIn;
+    completionCallback = callback;
+    count              = countIn;
+    roundTrips         = 0;
+    multipleCount      = 0;
+    fixedLengths       = (lengthsIn != NULL);
+    arenaUsed          = 0;
+    for (unsigned i = 0; i < count; i++) {
+        handles[i]             = handlesIn[i];
+        lengths[i]             = fixedLengths ? lengthsIn[i] : 0;
+        results[i].status      = BLE_STACK_BUSY;
+        results[i].length      = 0;
+        results[i].arenaOffset = 0;
+    }
+    pending = count;
+
+    /* Read Multiple carries as many values as fit in a response of ATT_MTU - 1 bytes. */
+    if (fixedLengths) {
+        unsigned responseLength = 0;
+        unsigned maxLength      = ble.gap().getMaxPayload(connHandle) + 2;
+        while ((multipleCount < count) && (responseLength + lengths[multipleCount] <= maxLength)) {
+            responseLength += lengths[multipleCount++];
+        }
+    } else {
+        multipleCount = count;
+    }
+
+    if (multipleCount < 2) {
+        multipleCount = 0;
+        readRemaining();
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t error = ble.gattClient().queueReadMultiple(connHandle, handles, multipleCount, !fixedLengths, onReadMultiple, this);
+    if (error != BLE_ERROR_NONE) {
+        pending = 0;
+    }
+    return error;
+}
+
+/**
+ * Take what the response holds. If the request failed for any reason other
+ * than the loss of the connection, the values are read one by one instead.
+ */
+void
+GattReadBatch::onReadMultiple(const GattClient::RequestResult_t *result)
+{
+    GattReadBatch *batch = static_cast<GattReadBatch *>(result->context);
+    batch->roundTrips++;
+
+    if (result->status == BLE_ERROR_INVALID_STATE) {
+        for (unsigned i = 0; i < batch->count; i++) {
+            batch->store(i, BLE_ERROR_INVALID_STATE, NULL, 0);
+        }
+        batch->finishIfDone();
+        return;
+    }
+
+    if (result->status == BLE_ERROR_NONE) {
+        if (batch->fixedLengths) {
+            batch->parseFixed(result->data, result->len);
+        } else {
+            batch->parseVariable(result->data, result->len);
+        }
+    }
+    batch->readRemaining();
+}
+
+void
+GattReadBatch::onRead(const GattClient::RequestResult_t *result)
+{
+    GattReadBatch *batch = static_cast<GattReadBatch *>(result->context);
+    batch->roundTrips++;
+
+    for (unsigned i = 0; i < batch->count; i++) {
+        if ((batch->handles[i] == result->handle) && (batch->results[i].status == BLE_STACK_BUSY)) {
+            batch->store(i, result->status, result->data, result->len);
+            break;
+        }
+    }
+    batch->finishIfDone();
+}
+
+/* The values, concatenated; anything but the expected total is rejected. */
+bool
+GattReadBatch::parseFixed(const uint8_t *data, uint16_t len)
+{
+    unsigned expected = 0;
+    for (unsigned i = 0; i < multipleCount; i++) {
+        expected += lengths[i];
+    }
+    if (len != expected) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < multipleCount; i++) {
+        store(i, BLE_ERROR_NONE, data, lengths[i]);
+        data += lengths[i];
+    }
+    return true;
+}
+
+/* Length and value pairs, in the order requested; the last may be cut short by the ATT MTU. */
+void
+GattReadBatch::parseVariable(const uint8_t *data, uint16_t len)
+{
+    unsigned offset = 0;
+    for (unsigned i = 0; (i < multipleCount) && (offset + 2 <= len); i++) {
+        uint16_t valueLength = AttPdu::readUint16(&data[offset]);
+        if (offset + 2 + valueLength > len) {
+            break;
+        }
+        store(i, BLE_ERROR_NONE, &data[offset + 2], valueLength);
+        offset += 2 + valueLength;
+    }
+}
+
+void
+GattReadBatch::store(unsigned index, ble_error_t status, const uint8_t *value, uint16_t length)
+{
+    Result_t &result = results[index];
+    if (result.status != BLE_STACK_BUSY) {
+        return;
+    }
+
+    if ((status == BLE_ERROR_NONE) && (arenaUsed + length > ARENA_SIZE)) {
+        status = BLE_ERROR_BUFFER_OVERFLOW;
+    }
+    result.status      = status;
+    result.length      = 0;
+    result.arenaOffset = arenaUsed;
+    if (status == BLE_ERROR_NONE) {
+        memcpy(&arena[arenaUsed], value, length);
+        result.length  = length;
+        arenaUsed     += length;
+    }
+    pending--;
+}
+
+/* Values still missing are read one by one, back to back through the request queue. */
+void
+GattReadBatch::readRemaining(void)
+{
+    issuing = true;
+    for (unsigned i = 0; i < count; i++) {
+        if (results[i].status != BLE_STACK_BUSY) {
+            continue;
+        }
+        ble_error_t error = ble.gattClient().queueRead(connHandle, handles[i], 0, onRead, this);
+        if (error != BLE_ERROR_NONE) {
+            store(i, error, NULL, 0);
+        }
+    }
+    issuing = false;
+
+    finishIfDone();
+}
+
+void
+GattReadBatch::finishIfDone(void)
+{
+    if (!issuing && (pending == 0) && (completionCallback != NULL)) {
+        CompletionCallback_t callback = completionCallback;
+        completionCallback = NULL;
+        callback(this);
+    }
+}
@@ -0,0 +1,267 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/BLE.h"
+#include "ble/GattSubscriptionBatch.h"
+
+GattSubscriptionBatch *GattSubscriptionBatch::discoveringBatches = NULL;
+
+GattSubscriptionBatch::GattSubscriptionBatch(BLE &bleIn) :
+    ble(bleIn),
+    connHandle(0),
+    completionCallback(NULL),
+    count(0),
+    pending(0),
+    unfound(0),
+    outstanding(0),
+    issuing(false),
+    next(NULL)
+{
+    /* empty */
+}
+
+ble_error_t
+GattSubscriptionBatch::subscribe(const DiscoveredCharacteristic *characteristics,
+                                 uint8_t                         countIn,
+                                 Mode_t                          mode,
+                                 CompletionCallback_t            callback)
+{
+    if (pending != 0) {
+        return BLE_STACK_BUSY;
+    }
+    if ((countIn == 0) || (countIn > MAX_CHARACTERISTICS)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    for (unsigned i = 1; i < countIn; i++) {
+        if (characteristics[i].getConnectionHandle() != characteristics[0].getConnectionHandle()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+    }
+
+    connHandle         = characteristics[0].getConnectionHandle();
+    completionCallback = callback;
+    count              = countIn;
+    pending            = count;
+    unfound            = 0;
+    outstanding        = 0;
+
+    GattAttribute::Handle_t startHandle = 0xFFFF;
+    for (unsigned i = 0; i < count; i++) {
+        const DiscoveredCharacteristic &characteristic = characteristics[i];
+        const DiscoveredCharacteristic::Properties_t &properties = characteristic.getProperties();
+
+        Entry_t &entry    = entries[i];
+        entry.declHandle  = characteristic.getDeclHandle();
+        entry.valueHandle = characteristic.getValueHandle();
+        entry.cccdHandle  = GattAttribute::INVALID_HANDLE;
+        entry.status      = BLE_STACK_BUSY;
+        entry.queued      = false;
+
+        uint16_t value = cccdValue(properties, mode);
+        entry.value[0] = (uint8_t)(value & 0xFF);
+        entry.value[1] = (uint8_t)(value >> 8);
+
+        if (!properties.notify() && !properties.indicate()) {
+            store(i, BLE_ERROR_OPERATION_NOT_PERMITTED);
+            continue;
+        }
+        unfound++;
+        if (entry.declHandle < startHandle) {
+            startHandle = entry.declHandle;
+        }
+    }
+
+    if (unfound == 0) {
+        writeAll();
+        return BLE_ERROR_NONE;
+    }
+
+    /* Registered first, as discovery may terminate before launching returns. */
+    next               = discoveringBatches;
+    discoveringBatches = this;
+
+    ble_error_t error = ble.gattClient().discoverDescriptors(connHandle, startHandle, 0xFFFF, onDescriptor,
+                                                             UUID(BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG), onTermination);
+    if (error != BLE_ERROR_NONE) {
+        for (GattSubscriptionBatch **link = &discoveringBatches; *link != NULL; link = &(*link)->next) {
+            if (*link == this) {
+                *link = next;
+                break;
+            }
+        }
+        pending = 0;
+    }
+    return error;
+}
+
+ble_error_t
+GattSubscriptionBatch::subscribe(Gap::Handle_t                  connHandleIn,
+                                 const GattAttribute::Handle_t *cccdHandles,
+                                 uint8_t                        countIn,
+                                 Mode_t                         mode,
+                                 CompletionCallback_t           callback)
+{
+    if (pending != 0) {
+        return BLE_STACK_BUSY;
+    }
+    if ((countIn == 0) || (countIn > MAX_CHARACTERISTICS)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    connHandle         = connHandleIn;
+    completionCallback = callback;
+    count              = countIn;
+    unfound            = 0;
+    outstanding        = 0;
+
+    uint16_t value = (mode == NOTIFICATIONS) ? CCCD_NOTIFICATIONS_ENABLED :
+                     (mode == INDICATIONS)   ? CCCD_INDICATIONS_ENABLED   : 0;
+    for (unsigned i = 0; i < count; i++) {
+        Entry_t &entry    = entries[i];
+        entry.declHandle  = GattAttribute::INVALID_HANDLE;
+        entry.valueHandle = GattAttribute::INVALID_HANDLE;
+        entry.cccdHandle  = cccdHandles[i];
+        entry.status      = BLE_STACK_BUSY;
+        entry.queued      = false;
+        entry.value[0]    = (uint8_t)(value & 0xFF);
+        entry.value[1]    = (uint8_t)(value >> 8);
+    }
+    pending = count;
+
+    writeAll();
+    return BLE_ERROR_NONE;
+}
+
+/* CCCDs are taken in handle order; each belongs to the characteristic declared before it. */
+void
+GattSubscriptionBatch::onDescriptor(const DiscoveredDescriptor *descriptor)
+{
+    GattSubscriptionBatch *batch = discoveringBatches;
+    while ((batch != NULL) && (batch->connHandle != descriptor->connHandle)) {
+        batch = batch->next;
+    }
+    if (batch == NULL) {
+        return;
+    }
+
+    for (unsigned i = 0; i < batch->count; i++) {
+        Entry_t &entry = batch->entries[i];
+        if ((entry.valueHandle == descriptor->valueHandle) && (entry.cccdHandle == GattAttribute::INVALID_HANDLE)) {
+            entry.cccdHandle = descriptor->handle;
+            batch->unfound--;
+        }
+    }
+
+    /* No need to sweep the rest of the table. */
+    if (batch->unfound == 0) {
+        batch->ble.gattClient().terminateServiceDiscovery(batch->connHandle);
+    }
+}
+
+void
+GattSubscriptionBatch::onTermination(Gap::Handle_t connectionHandle)
+{
+    for (GattSubscriptionBatch **link = &discoveringBatches; *link != NULL; link = &(*link)->next) {
+        GattSubscriptionBatch *batch = *link;
+        if (batch->connHandle == connectionHandle) {
+            *link = batch->next;
+            batch->writeAll();
+            return;
+        }
+    }
+}
+
+void
+GattSubscriptionBatch::onWritten(const GattClient::RequestResult_t *result)
+{
+    GattSubscriptionBatch *batch = static_cast<GattSubscriptionBatch *>(result->context);
+    batch->outstanding--;
+
+    for (unsigned i = 0; i < batch->count; i++) {
+        Entry_t &entry = batch->entries[i];
+        if (entry.queued && (entry.cccdHandle == result->handle) && (entry.status == BLE_STACK_BUSY)) {
+            batch->store(i, result->status);
+            break;
+        }
+    }
+    batch->writeAll();
+}
+
+uint16_t
+GattSubscriptionBatch::cccdValue(const DiscoveredCharacteristic::Properties_t &properties, Mode_t mode)
+{
+    if (mode == UNSUBSCRIBE) {
+        return 0;
+    }
+    if (properties.notify() && ((mode == NOTIFICATIONS) || !properties.indicate())) {
+        return CCCD_NOTIFICATIONS_ENABLED;
+    }
+    return properties.indicate() ? CCCD_INDICATIONS_ENABLED : 0;
+}
+
+/**
+ * Queue the writes which haven't been, back to back. Should the request
+ * queue fill up, the rest are queued as earlier writes complete.
+ */
+void
+GattSubscriptionBatch::writeAll(void)
+{
+    issuing = true;
+    for (unsigned i = 0; i < count; i++) {
+        Entry_t &entry = entries[i];
+        if ((entry.status != BLE_STACK_BUSY) || entry.queued) {
+            continue;
+        }
+        if (entry.cccdHandle == GattAttribute::INVALID_HANDLE) {
+            store(i, BLE_ERROR_UNSPECIFIED);
+            continue;
+        }
+
+        entry.queued = true;
+        outstanding++;
+        ble_error_t error = ble.gattClient().queueWrite(GattClient::GATT_OP_WRITE_REQ, connHandle, entry.cccdHandle,
+                                                        sizeof(entry.value), entry.value, onWritten, this);
+        if (error != BLE_ERROR_NONE) {
+            entry.queued = false;
+            outstanding--;
+            if ((error != BLE_ERROR_NO_MEM) || (outstanding == 0)) {
+                store(i, error);
+                continue;
+            }
+            break;
+        }
+    }
+    issuing = false;
+
+    finishIfDone();
+}
+
+void
+GattSubscriptionBatch::store(unsigned index, ble_error_t status)
+{
+    entries[index].status = status;
+    pending--;
+}
+
+void
+GattSubscriptionBatch::finishIfDone(void)
+{
+    if (!issuing && (pending == 0) && (completionCallback != NULL)) {
+        CompletionCallback_t callback = completionCallback;
+        completionCallback = NULL;
+        callback(this);
+    }
+}
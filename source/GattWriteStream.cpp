@@ -0,0 +1,177 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/BLE.h"
+#include "ble/GattWriteStream.h"
+
+GattWriteStream::GattWriteStream(BLE &bleIn) :
+    ble(bleIn),
+    active(false),
+    connHandle(0),
+    valueHandle(GattAttribute::INVALID_HANDLE),
+    completionCallback(NULL),
+    data(NULL),
+    length(0),
+    producer(NULL),
+    producerContext(NULL),
+    chunkLength(0),
+    bytesSent(0),
+    packetsSent(0),
+    bursts(0)
+{
+    ble.gattServer().onDataSent(this, &GattWriteStream::onDataSent);
+    ble.gap().addToDisconnectionCallChain(this, &GattWriteStream::onDisconnection);
+}
+
+ble_error_t
+GattWriteStream::start(Gap::Handle_t            connHandleIn,
+                       GattAttribute::Handle_t  valueHandleIn,
+                       const uint8_t           *dataIn,
+                       uint32_t                 lengthIn,
+                       CompletionCallback_t     callback)
+{
+    if (active) {
+        return BLE_STACK_BUSY;
+    }
+
+    data     = dataIn;
+    length   = lengthIn;
+    producer = NULL;
+    return begin(connHandleIn, valueHandleIn, callback);
+}
+
+ble_error_t
+GattWriteStream::start(Gap::Handle_t            connHandleIn,
+                       GattAttribute::Handle_t  valueHandleIn,
+                       Producer_t               producerIn,
+                       void                    *context,
+                       CompletionCallback_t     callback)
+{
+    if (active) {
+        return BLE_STACK_BUSY;
+    }
+
+    data            = NULL;
+    length          = 0;
+    producer        = producerIn;
+    producerContext = context;
+    return begin(connHandleIn, valueHandleIn, callback);
+}
+
+void
+GattWriteStream::abort(void)
+{
+    active = false;
+}
+
+void
+GattWriteStream::onDataSent(unsigned count)
+{
+    (void)count; /* avoid compiler warnings about unused variables */
+
+    if (active) {
+        send();
+    }
+}
+
+void
+GattWriteStream::onDisconnection(const Gap::DisconnectionCallbackParams_t *params)
+{
+    if (active && (params->handle == connHandle)) {
+        finish(BLE_ERROR_INVALID_STATE);
+    }
+}
+
+ble_error_t
+GattWriteStream::begin(Gap::Handle_t connHandleIn, GattAttribute::Handle_t valueHandleIn, CompletionCallback_t callback)
+{
+    active             = true;
+    connHandle         = connHandleIn;
+    valueHandle        = valueHandleIn;
+    completionCallback = callback;
+    chunkLength        = 0;
+    bytesSent          = 0;
+    packetsSent        = 0;
+    bursts             = 0;
+
+    send();
+    return BLE_ERROR_NONE;
+}
+
+/**
+ * Hand chunks to the stack until it runs out of transmit buffers. A chunk
+ * from a producer is kept until the stack accepts it; a chunk of the buffer
+ * is simply sent from the buffer, as write commands are copied by the stack.
+ * The chunk size follows the ATT MTU, should it change during the transfer.
+ */
+void
+GattWriteStream::send(void)
+{
+    GattClient &client  = ble.gattClient();
+    bool        sentAny = false;
+
+    while (active) {
+        uint16_t maxLength = ble.gap().getMaxPayload(connHandle);
+        if (maxLength > sizeof(chunk)) {
+            maxLength = sizeof(chunk);
+        }
+
+        const uint8_t *next;
+        uint16_t       nextLength;
+        if (producer != NULL) {
+            if (chunkLength == 0) {
+                chunkLength = producer(chunk, maxLength, producerContext);
+            }
+            next       = chunk;
+            nextLength = chunkLength;
+        } else {
+            next       = &data[bytesSent];
+            nextLength = ((length - bytesSent) < maxLength) ? (uint16_t)(length - bytesSent) : maxLength;
+        }
+
+        if (nextLength == 0) {
+            finish(BLE_ERROR_NONE);
+            return;
+        }
+
+        ble_error_t error = client.write(GattClient::GATT_OP_WRITE_CMD, connHandle, valueHandle, nextLength, next);
+        if ((error == BLE_ERROR_NO_MEM) || (error == BLE_STACK_BUSY)) {
+            return; /* resume on the next data-sent event */
+        }
+        if (error != BLE_ERROR_NONE) {
+            finish(error);
+            return;
+        }
+
+        if (!sentAny) {
+            sentAny = true;
+            bursts++;
+        }
+        bytesSent  += nextLength;
+        packetsSent++;
+        chunkLength = 0;
+    }
+}
+
+/* The callback may start another transfer. */
+void
+GattWriteStream::finish(ble_error_t status)
+{
+    active = false;
+    if (completionCallback) {
+        completionCallback(this, status);
+    }
+}
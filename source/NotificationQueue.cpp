@@ -0,0 +1,215 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ble/NotificationQueue.h"
+
+NotificationQueue::NotificationQueue(BLE &bleIn, Entry *storage, unsigned capacityIn, unsigned txCreditsIn) :
+    ble(bleIn),
+    entries(storage),
+    capacity(capacityIn),
+    pendingCount(0),
+    droppedCount(0),
+    nextSequence(0),
+    flushing(false),
+    txCreditsReleasedCallback(NULL),
+    disconnectionCallback(NULL)
+{
+    for (unsigned i = 0; i < capacity; i++) {
+        entries[i].flags = 0;
+    }
+
+    if (ble.gattServer().getMaxTxCredits() == 0) {
+        ble.gattServer().setTxCredits(txCreditsIn);
+    }
+
+    txCreditsReleasedCallback = ble.gattServer().onTxCreditsReleased(this, &NotificationQueue::onTxCreditsReleased);
+    disconnectionCallback     = ble.gap().addToDisconnectionCallChain(this, &NotificationQueue::onDisconnection);
+}
+
+NotificationQueue::~NotificationQueue(void)
+{
+    ble.gattServer().detachTxCreditsReleased(txCreditsReleasedCallback);
+    ble.gap().removeFromDisconnectionCallChain(disconnectionCallback);
+}
+
+ble_error_t
+NotificationQueue::enqueue(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len, Mode_t mode)
+{
+    return enqueue((mode == MODE_STATE) ? FLAG_STATE : 0, 0, handle, value, len);
+}
+
+ble_error_t
+NotificationQueue::enqueue(Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len, Mode_t mode)
+{
+    return enqueue(((mode == MODE_STATE) ? FLAG_STATE : 0) | FLAG_HAS_CONN_HANDLE, connHandle, handle, value, len);
+}
+
+ble_error_t
+NotificationQueue::enqueue(uint8_t flags, Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len)
+{
+    if (len > MAX_VALUE_LEN) {
+        return BLE_ERROR_BUFFER_OVERFLOW;
+    }
+
+    /* Fast path: nothing pending which would have to go first, so try to send right away without copying. */
+    if ((pendingCount == 0) && (getTxCredits() > 0)) {
+        ble_error_t error = send(flags, connHandle, handle, value, len);
+        if (!isOutOfBuffers(error)) {
+            return error;
+        }
+    }
+
+    /* A state update replaces a pending value for the same attribute. */
+    Entry *entry = NULL;
+    if (flags & FLAG_STATE) {
+        for (unsigned i = 0; i < capacity; i++) {
+            if ((entries[i].flags == (flags | FLAG_USED)) &&
+                (entries[i].handle == handle) &&
+                (entries[i].connHandle == connHandle)) {
+                entry = &entries[i];
+                break;
+            }
+        }
+    }
+
+    if (entry == NULL) {
+        for (unsigned i = 0; i < capacity; i++) {
+            if (!(entries[i].flags & FLAG_USED)) {
+                entry = &entries[i];
+                break;
+            }
+        }
+        if (entry == NULL) {
+            return BLE_ERROR_NO_MEM;
+        }
+
+        entry->sequence   = nextSequence++;
+        entry->flags      = flags | FLAG_USED;
+        entry->connHandle = connHandle;
+        entry->handle     = handle;
+        pendingCount++;
+    }
+
+    memcpy(entry->value, value, len);
+    entry->len = len;
+
+    /* Keep the local copy of the value current while the notification is held back. */
+    if (flags & FLAG_HAS_CONN_HANDLE) {
+        ble.gattServer().write(connHandle, handle, value, len, true /* localOnly */);
+    } else {
+        ble.gattServer().write(handle, value, len, true /* localOnly */);
+    }
+
+    if (getTxCredits() > 0) {
+        flush();
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+void
+NotificationQueue::flush(void)
+{
+    if (flushing) {
+        return; /* guard against re-entry from a synchronous data-sent event */
+    }
+    flushing = true;
+
+    while ((pendingCount > 0) && (getTxCredits() > 0)) {
+        Entry *entry = findOldest();
+
+        ble_error_t error = send(entry->flags, entry->connHandle, entry->handle, entry->value, entry->len);
+        if (isOutOfBuffers(error)) {
+            break;
+        }
+        if (error != BLE_ERROR_NONE) {
+            droppedCount++;
+        }
+
+        entry->flags = 0;
+        pendingCount--;
+    }
+
+    flushing = false;
+}
+
+void
+NotificationQueue::clear(void)
+{
+    for (unsigned i = 0; i < capacity; i++) {
+        entries[i].flags = 0;
+    }
+    pendingCount = 0;
+}
+
+void
+NotificationQueue::onTxCreditsReleased(unsigned credits)
+{
+    (void)credits;
+
+    flush();
+}
+
+void
+NotificationQueue::onDisconnection(const Gap::DisconnectionCallbackParams_t *params)
+{
+    for (unsigned i = 0; i < capacity; i++) {
+        if ((entries[i].flags & FLAG_USED) &&
+            (entries[i].flags & FLAG_HAS_CONN_HANDLE) &&
+            (entries[i].connHandle == params->handle)) {
+            entries[i].flags = 0;
+            pendingCount--;
+        }
+    }
+
+    /* The GattServer may have returned the credits of the terminated link before its entries were purged. */
+    if (getTxCredits() > 0) {
+        flush();
+    }
+}
+
+ble_error_t
+NotificationQueue::send(uint8_t flags, Gap::Handle_t connHandle, GattAttribute::Handle_t handle, const uint8_t *value, uint16_t len)
+{
+    ble_error_t error;
+    if (flags & FLAG_HAS_CONN_HANDLE) {
+        error = ble.gattServer().write(connHandle, handle, value, len);
+    } else {
+        error = ble.gattServer().write(handle, value, len);
+    }
+
+    if (error == BLE_ERROR_NONE) {
+        ble.gattServer().takeTxCredit();
+    } else if (isOutOfBuffers(error)) {
+        ble.gattServer().dropTxCredits(); /* the estimate was too optimistic; wait for the next data-sent event or confirmation */
+    }
+
+    return error;
+}
+
+NotificationQueue::Entry *
+NotificationQueue::findOldest(void)
+{
+    Entry *oldest = NULL;
+    for (unsigned i = 0; i < capacity; i++) {
+        if ((entries[i].flags & FLAG_USED) &&
+            ((oldest == NULL) || ((int32_t)(entries[i].sequence - oldest->sequence) < 0))) {
+            oldest = &entries[i];
+        }
+    }
+
+    return oldest;
+}
@@ -0,0 +1,205 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "ble/BLE.h"
+#include "ble/PreparedWriteQueue.h"
+
+PreparedWriteQueue::PreparedWriteQueue(BLE &ble, uint16_t maxBytesPerConnectionIn, uint8_t maxSegmentsPerConnectionIn) :
+    maxBytesPerConnection(maxBytesPerConnectionIn),
+    maxSegmentsPerConnection(maxSegmentsPerConnectionIn),
+    arenaUsed(0),
+    segmentCount(0)
+{
+    ble.gattServer().setPreparedWriteQueue(this);
+    ble.gap().addToDisconnectionCallChain(this, &PreparedWriteQueue::onDisconnection);
+}
+
+GattAuthCallbackReply_t
+PreparedWriteQueue::prepare(const GattWriteCallbackParams *params)
+{
+    unsigned connSegments = 0;
+    unsigned connBytes    = 0;
+    for (unsigned i = 0; i < segmentCount; i++) {
+        if (segments[i].connHandle == params->connHandle) {
+            connSegments++;
+            connBytes += segments[i].len;
+        }
+    }
+
+    if ((segmentCount >= MAX_SEGMENTS) ||
+        ((unsigned)arenaUsed + params->len > ARENA_SIZE) ||
+        (connSegments >= maxSegmentsPerConnection) ||
+        (connBytes + params->len > maxBytesPerConnection)) {
+        return AUTH_CALLBACK_REPLY_ATTERR_PREPARE_QUEUE_FULL;
+    }
+
+    Segment &segment    = segments[segmentCount++];
+    segment.connHandle  = params->connHandle;
+    segment.handle      = params->handle;
+    segment.offset      = params->offset;
+    segment.len         = params->len;
+    segment.arenaOffset = arenaUsed;
+
+    memcpy(&arena[arenaUsed], params->data, params->len);
+    arenaUsed += params->len;
+
+    return AUTH_CALLBACK_REPLY_SUCCESS;
+}
+
+GattAuthCallbackReply_t
+PreparedWriteQueue::execute(Gap::Handle_t connHandle, GattServer &server, WriteDelivery_t &deliver)
+{
+    /* Two passes over the attributes written by this connection: the first
+     * validates every resulting value, the second applies them. */
+    for (unsigned pass = 0; pass < 2; pass++) {
+        for (unsigned i = 0; i < segmentCount; i++) {
+            if (segments[i].connHandle != connHandle) {
+                continue;
+            }
+
+            /* Visit each attribute once, at the first segment written to it. */
+            bool seen = false;
+            for (unsigned j = 0; j < i; j++) {
+                if ((segments[j].connHandle == connHandle) && (segments[j].handle == segments[i].handle)) {
+                    seen = true;
+                    break;
+                }
+            }
+            if (seen) {
+                continue;
+            }
+
+            uint16_t                length;
+            GattAuthCallbackReply_t status = reassemble(connHandle, server, i, &length);
+            if (status != AUTH_CALLBACK_REPLY_SUCCESS) {
+                release(connHandle);
+                return status;
+            }
+
+            GattAttribute::Handle_t handle = segments[i].handle;
+            if (pass == 0) {
+                uint16_t maxLength;
+                if ((server.getMaxLength(handle, &maxLength) == BLE_ERROR_NONE) && (length > maxLength)) {
+                    release(connHandle);
+                    return AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+                }
+            } else {
+                if ((server.write(connHandle, handle, value, length, true /* localOnly */) != BLE_ERROR_NONE) &&
+                    (server.write(handle, value, length, true /* localOnly */) != BLE_ERROR_NONE)) {
+                    /* a value the server refuses isn't delivered as if it had been applied */
+                    release(connHandle);
+                    return AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+                }
+
+                GattWriteCallbackParams params;
+                params.connHandle = connHandle;
+                params.handle     = handle;
+                params.writeOp    = GattWriteCallbackParams::OP_WRITE_REQ;
+                params.offset     = 0;
+                params.len        = length;
+                params.data       = value;
+                deliver.call(&params);
+            }
+        }
+    }
+
+    release(connHandle);
+    return AUTH_CALLBACK_REPLY_SUCCESS;
+}
+
+void
+PreparedWriteQueue::cancel(Gap::Handle_t connHandle)
+{
+    release(connHandle);
+}
+
+void
+PreparedWriteQueue::onDisconnection(const Gap::DisconnectionCallbackParams_t *params)
+{
+    release(params->handle);
+}
+
+/**
+ * Build the new value of the attribute written by segments[first] in the
+ * scratch buffer: start from the current value and apply, in order of arrival,
+ * every segment for the same connection and attribute. Each segment must start
+ * within the value built so far, and the value ends where the last segment
+ * ends; so a long write starting at offset 0 replaces the value entirely.
+ */
+GattAuthCallbackReply_t
+PreparedWriteQueue::reassemble(Gap::Handle_t connHandle, GattServer &server, unsigned first, uint16_t *lengthP)
+{
+    GattAttribute::Handle_t handle = segments[first].handle;
+
+    uint16_t length = MAX_VALUE_LEN;
+    if (server.read(connHandle, handle, value, &length) != BLE_ERROR_NONE) {
+        length = MAX_VALUE_LEN;
+        if (server.read(handle, value, &length) != BLE_ERROR_NONE) {
+            length = 0;
+        }
+    }
+    if (length > MAX_VALUE_LEN) {
+        length = MAX_VALUE_LEN; /* only the leading part was read */
+    }
+
+    for (unsigned i = first; i < segmentCount; i++) {
+        const Segment &segment = segments[i];
+        if ((segment.connHandle != connHandle) || (segment.handle != handle)) {
+            continue;
+        }
+
+        if (segment.offset > length) {
+            return AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET;
+        }
+        if ((unsigned)segment.offset + segment.len > MAX_VALUE_LEN) {
+            return AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+        }
+
+        memcpy(&value[segment.offset], &arena[segment.arenaOffset], segment.len);
+        length = segment.offset + segment.len;
+    }
+
+    *lengthP = length;
+    return AUTH_CALLBACK_REPLY_SUCCESS;
+}
+
+/**
+ * Drop the segments of a connection and compact the remaining ones, keeping
+ * both the segment table and the arena in order of arrival.
+ */
+void
+PreparedWriteQueue::release(Gap::Handle_t connHandle)
+{
+    unsigned kept      = 0;
+    uint16_t arenaNext = 0;
+    for (unsigned i = 0; i < segmentCount; i++) {
+        if (segments[i].connHandle == connHandle) {
+            continue;
+        }
+
+        Segment segment = segments[i];
+        if (segment.arenaOffset != arenaNext) {
+            memmove(&arena[arenaNext], &arena[segment.arenaOffset], segment.len);
+            segment.arenaOffset = arenaNext;
+        }
+        arenaNext        += segment.len;
+        segments[kept++]  = segment;
+    }
+
+    segmentCount = kept;
+    arenaUsed    = arenaNext;
+}
@@ -0,0 +1,102 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(TARGET_LIKE_LINUX)
+
+#include <stdio.h>
+#include "ble/host/FileGattCacheStorage.h"
+
+FileGattCacheStorage::FileGattCacheStorage(const char *directoryIn) :
+    GattCacheStorage(),
+    directory(directoryIn)
+{
+    /* empty */
+}
+
+ble_error_t
+FileGattCacheStorage::load(const Key_t key, uint8_t *buffer, uint16_t *lengthP)
+{
+    char path[BLE_FILE_GATT_CACHE_MAX_PATH];
+    if (!makePath(key, "", path)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    /* Read one byte more than fits, to tell a full buffer from an oversized record. */
+    uint8_t extra;
+    size_t  length = fread(buffer, 1, *lengthP, file);
+    bool    fits   = (length < *lengthP) || (fread(&extra, 1, 1, file) == 0);
+    bool    failed = (ferror(file) != 0);
+    fclose(file);
+
+    if (failed) {
+        return BLE_ERROR_UNSPECIFIED;
+    }
+    if (!fits) {
+        return BLE_ERROR_BUFFER_OVERFLOW;
+    }
+    *lengthP = (uint16_t)length;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+FileGattCacheStorage::store(const Key_t key, const uint8_t *data, uint16_t length)
+{
+    char path[BLE_FILE_GATT_CACHE_MAX_PATH];
+    char temporaryPath[BLE_FILE_GATT_CACHE_MAX_PATH];
+    if (!makePath(key, "", path) || !makePath(key, ".tmp", temporaryPath)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    FILE *file = fopen(temporaryPath, "wb");
+    if (file == NULL) {
+        return BLE_ERROR_UNSPECIFIED;
+    }
+    bool written = (fwrite(data, 1, length, file) == length);
+    if ((fclose(file) != 0) || !written || (rename(temporaryPath, path) != 0)) {
+        remove(temporaryPath);
+        return BLE_ERROR_UNSPECIFIED;
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+FileGattCacheStorage::erase(const Key_t key)
+{
+    char path[BLE_FILE_GATT_CACHE_MAX_PATH];
+    if (!makePath(key, "", path)) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    remove(path);
+    return BLE_ERROR_NONE;
+}
+
+/* The address is written most significant byte first, as it is usually shown. */
+bool
+FileGattCacheStorage::makePath(const Key_t key, const char *suffix, char *path) const
+{
+    int length = snprintf(path, BLE_FILE_GATT_CACHE_MAX_PATH, "%s/gatt-%u-%02x%02x%02x%02x%02x%02x.bin%s",
+                          directory, key[0], key[6], key[5], key[4], key[3], key[2], key[1], suffix);
+    return (length > 0) && (length < BLE_FILE_GATT_CACHE_MAX_PATH);
+}
+
+#endif // TARGET_LIKE_LINUX
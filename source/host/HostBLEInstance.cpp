@@ -0,0 +1,407 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(TARGET_LIKE_LINUX)
+
+#include <string.h>
+#include "ble/host/HostBLEInstance.h"
+
+HostBLEInstance         *HostBLEInstance::instances[BLE_HOST_MAX_INSTANCES];
+HostBLEInstance::Link_t  HostBLEInstance::links[BLE_HOST_MAX_LINKS];
+Gap::Handle_t            HostBLEInstance::nextConnectionHandle = 1;
+
+/* Reported to connection callbacks; the simulated links don't have timing. */
+static const Gap::ConnectionParams_t hostConnectionParams = {
+    6,   /* minConnectionInterval: 7.5ms */
+    6,   /* maxConnectionInterval: 7.5ms */
+    0,   /* slaveLatency */
+    100  /* connectionSupervisionTimeout: 1s */
+};
+
+BLEInstanceBase *
+createBLEInstance(void)
+{
+    static HostBLEInstance instance;
+    return &instance;
+}
+
+HostBLEInstance::HostBLEInstance() :
+    gap(*this),
+    gattServer(*this),
+    gattClient(*this),
+    securityManager(),
+    txBuffersFree(BLE_HOST_TX_BUFFERS),
+    eventHead(0),
+    eventCount(0)
+{
+    unsigned index;
+    for (index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+        if (instances[index] == NULL) {
+            instances[index] = this;
+            break;
+        }
+    }
+
+    /* A random static address derived from the slot, so that instances can find each other. */
+    Gap::Address_t address = {(uint8_t)(index + 1), 0x00, 0x00, 0x00, 0x00, 0xC0};
+    gap.setAddress(Gap::ADDR_TYPE_RANDOM_STATIC, address);
+}
+
+HostBLEInstance::~HostBLEInstance()
+{
+    shutdown();
+    for (unsigned index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+        if (instances[index] == this) {
+            instances[index] = NULL;
+        }
+    }
+}
+
+ble_error_t
+HostBLEInstance::init(void)
+{
+    /* An instance constructed while all slots were taken can't be found by its peers. */
+    for (unsigned index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+        if (instances[index] == this) {
+            return BLE_ERROR_NONE;
+        }
+    }
+
+    return BLE_ERROR_NO_MEM;
+}
+
+ble_error_t
+HostBLEInstance::shutdown(void)
+{
+    gap.stopAdvertising();
+    gap.stopScan();
+
+    /* Drop pending events, but report the termination of every link. */
+    eventHead     = 0;
+    eventCount    = 0;
+    txBuffersFree = BLE_HOST_TX_BUFFERS;
+    for (unsigned i = 0; i < BLE_HOST_MAX_LINKS; i++) {
+        if ((links[i].central == this) || (links[i].peripheral == this)) {
+            closeLink(links[i].handle, Gap::LOCAL_HOST_TERMINATED_CONNECTION);
+        }
+    }
+    waitForEvent();
+
+    gattServer.reset();
+    gattClient.reset();
+
+    return BLE_ERROR_NONE;
+}
+
+const char *
+HostBLEInstance::getVersion(void)
+{
+    return "host";
+}
+
+void
+HostBLEInstance::waitForEvent(void)
+{
+    gap.processScan();
+
+    /* Events posted while dispatching wait for the next call, as if for the
+     * next connection event: the peer gets to run in between, so a sender
+     * resuming on data-sent can't flood it. */
+    for (unsigned pending = eventCount; (pending != 0) && (eventCount != 0); pending--) {
+        /* Dequeue before dispatching, so that callbacks may post further events. */
+        Event_t event = events[eventHead];
+        eventHead = (eventHead + 1) % BLE_HOST_EVENT_QUEUE_DEPTH;
+        eventCount--;
+
+        dispatch(event);
+    }
+}
+
+ble_error_t
+HostBLEInstance::post(const Event_t &event)
+{
+    if (eventCount >= BLE_HOST_EVENT_QUEUE_DEPTH) {
+        return BLE_STACK_BUSY;
+    }
+
+    events[(eventHead + eventCount) % BLE_HOST_EVENT_QUEUE_DEPTH] = event;
+    eventCount++;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostBLEInstance::transmit(HostBLEInstance &peer, const Event_t &event)
+{
+    /* Consecutive completions are reported together, as controllers do. */
+    Event_t *lastEvent = (eventCount != 0) ? &events[(eventHead + eventCount - 1) % BLE_HOST_EVENT_QUEUE_DEPTH] : NULL;
+    bool     coalesce  = (lastEvent != NULL) && (lastEvent->type == EVENT_DATA_SENT);
+
+    if ((txBuffersFree == 0) ||
+        (peer.eventCount >= BLE_HOST_EVENT_QUEUE_DEPTH) ||
+        (!coalesce && (eventCount >= BLE_HOST_EVENT_QUEUE_DEPTH))) {
+        return BLE_ERROR_NO_MEM;
+    }
+
+    peer.post(event);
+    txBuffersFree--;
+
+    if (coalesce) {
+        lastEvent->offset++;
+    } else {
+        Event_t dataSent;
+        dataSent.type       = EVENT_DATA_SENT;
+        dataSent.connHandle = event.connHandle;
+        dataSent.offset     = 1;
+        post(dataSent);
+    }
+
+    return BLE_ERROR_NONE;
+}
+
+HostBLEInstance *
+HostBLEInstance::getPeer(Gap::Handle_t connectionHandle) const
+{
+    Link_t *link = findLink(connectionHandle);
+    if (link == NULL) {
+        return NULL;
+    }
+
+    if (link->central == this) {
+        return link->peripheral;
+    }
+    if (link->peripheral == this) {
+        return link->central;
+    }
+    return NULL;
+}
+
+unsigned
+HostBLEInstance::getLinks(Gap::Handle_t *handles, unsigned maxHandles) const
+{
+    unsigned count = 0;
+    for (unsigned i = 0; (i < BLE_HOST_MAX_LINKS) && (count < maxHandles); i++) {
+        if ((links[i].central == this) || (links[i].peripheral == this)) {
+            handles[count++] = links[i].handle;
+        }
+    }
+    return count;
+}
+
+unsigned
+HostBLEInstance::processAll(unsigned maxRounds)
+{
+    unsigned rounds;
+    for (rounds = 0; rounds < maxRounds; rounds++) {
+        bool processed = false;
+        for (unsigned index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+            HostBLEInstance *instance = instances[index];
+            if ((instance != NULL) && (instance->hasPendingEvents() || instance->gap.isScanning())) {
+                processed |= instance->hasPendingEvents();
+                instance->waitForEvent();
+            }
+        }
+        if (!processed) {
+            break;
+        }
+    }
+    return rounds;
+}
+
+ble_error_t
+HostBLEInstance::openLink(HostBLEInstance &central, HostBLEInstance &peripheral)
+{
+    if ((&central == &peripheral) || !peripheral.gap.isAdvertising()) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    if ((central.eventCount >= BLE_HOST_EVENT_QUEUE_DEPTH) || (peripheral.eventCount >= BLE_HOST_EVENT_QUEUE_DEPTH)) {
+        return BLE_STACK_BUSY;
+    }
+
+    Link_t *link = findLink(GattAttribute::INVALID_HANDLE); /* a free slot */
+    if (link == NULL) {
+        return BLE_ERROR_NO_MEM;
+    }
+    link->handle     = nextConnectionHandle++;
+    link->central    = &central;
+    link->peripheral = &peripheral;
+    if (nextConnectionHandle == GattAttribute::INVALID_HANDLE) {
+        nextConnectionHandle = 1;
+    }
+
+    peripheral.gap.stopAdvertising();
+
+    Gap::AddressType_t addressType;
+    Event_t            event;
+    event.type       = EVENT_CONNECTION;
+    event.connHandle = link->handle;
+    event.len        = Gap::ADDR_LEN + 1;
+
+    /* Each end learns the address of the other. */
+    event.op = Gap::CENTRAL;
+    peripheral.gap.getAddress(&addressType, event.data);
+    event.data[Gap::ADDR_LEN] = addressType;
+    central.post(event);
+
+    event.op = Gap::PERIPHERAL;
+    central.gap.getAddress(&addressType, event.data);
+    event.data[Gap::ADDR_LEN] = addressType;
+    peripheral.post(event);
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostBLEInstance::closeLink(Gap::Handle_t connectionHandle, Gap::DisconnectionReason_t reason)
+{
+    Link_t *link = findLink(connectionHandle);
+    if (link == NULL) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+
+    Event_t event;
+    event.type       = EVENT_DISCONNECTION;
+    event.connHandle = connectionHandle;
+    event.op         = reason;
+    link->central->post(event);
+    link->peripheral->post(event);
+
+    link->handle     = GattAttribute::INVALID_HANDLE;
+    link->central    = NULL;
+    link->peripheral = NULL;
+
+    return BLE_ERROR_NONE;
+}
+
+HostBLEInstance::Link_t *
+HostBLEInstance::findLink(Gap::Handle_t connectionHandle)
+{
+    for (unsigned i = 0; i < BLE_HOST_MAX_LINKS; i++) {
+        if (connectionHandle == GattAttribute::INVALID_HANDLE) {
+            if (links[i].central == NULL) {
+                return &links[i];
+            }
+        } else if ((links[i].central != NULL) && (links[i].handle == connectionHandle)) {
+            return &links[i];
+        }
+    }
+    return NULL;
+}
+
+void
+HostBLEInstance::dispatch(const Event_t &event)
+{
+    switch (event.type) {
+        case EVENT_CONNECTION: {
+            Gap::AddressType_t ownAddressType;
+            Gap::Address_t     ownAddress;
+            gap.getAddress(&ownAddressType, ownAddress);
+            gap.processConnectionEvent(event.connHandle,
+                                       (Gap::Role_t)event.op,
+                                       (Gap::AddressType_t)event.data[Gap::ADDR_LEN],
+                                       event.data,
+                                       ownAddressType,
+                                       ownAddress,
+                                       &hostConnectionParams);
+            break;
+        }
+
+        case EVENT_DISCONNECTION:
+            gap.processDisconnectionEvent(event.connHandle, (Gap::DisconnectionReason_t)event.op);
+            gattClient.processDisconnection(event.connHandle);
+            break;
+
+        case EVENT_ATT_MTU_CHANGE:
+            gap.processAttMtuChangeEvent(event.connHandle, event.offset);
+            break;
+
+        case EVENT_WRITE_REQUEST:
+            gattServer.processWriteRequest(event.connHandle,
+                                           event.handle,
+                                           (GattWriteCallbackParams::WriteOp_t)event.op,
+                                           event.offset,
+                                           event.data,
+                                           event.len);
+            break;
+
+        case EVENT_READ_REQUEST:
+            gattServer.processReadRequest(event.connHandle, event.handle, event.offset);
+            break;
+
+        case EVENT_DATA_SENT:
+            txBuffersFree += event.offset;
+            gattServer.processDataSentEvent(event.offset);
+            break;
+
+        case EVENT_READ_RESPONSE: {
+            GattReadCallbackParams params;
+            params.connHandle = event.connHandle;
+            params.handle     = event.handle;
+            params.offset     = event.offset;
+            params.len        = event.len;
+            params.data       = event.data;
+            gattClient.processReadResponse(&params);
+            break;
+        }
+
+        case EVENT_WRITE_RESPONSE: {
+            GattWriteCallbackParams params;
+            params.connHandle = event.connHandle;
+            params.handle     = event.handle;
+            params.writeOp    = (GattWriteCallbackParams::WriteOp_t)event.op;
+            params.offset     = event.offset;
+            params.len        = event.len;
+            params.data       = NULL;
+            gattClient.processWriteResponse(&params);
+            break;
+        }
+
+        case EVENT_ERROR_RESPONSE:
+            gattClient.processRequestError(event.connHandle, event.handle, (GattAuthCallbackReply_t)(0x0100 | event.op));
+            break;
+
+        case EVENT_HVX: {
+            GattHVXCallbackParams params;
+            params.connHandle = event.connHandle;
+            params.handle     = event.handle;
+            params.type       = (HVXType_t)event.op;
+            params.len        = event.len;
+            params.data       = event.data;
+            gattClient.processHVXEvent(&params);
+            break;
+        }
+
+        case EVENT_ATT_REQUEST:
+            gattServer.processAttRequest(event.connHandle, event.data, event.len);
+            break;
+
+        case EVENT_READ_MULTIPLE_REQUEST:
+            gattServer.processReadMultipleRequest(event.connHandle, event.data, event.len / 2, (event.op != 0));
+            break;
+
+        case EVENT_READ_MULTIPLE_RESPONSE:
+            gattClient.processReadMultipleResponse(event.connHandle, (ble_error_t)event.op, event.data, event.len);
+            break;
+
+        case EVENT_ATT_RESPONSE:
+            gattClient.processAttResponse(event.connHandle, event.data, event.len);
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif // TARGET_LIKE_LINUX
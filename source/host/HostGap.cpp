@@ -0,0 +1,178 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(TARGET_LIKE_LINUX)
+
+#include <string.h>
+#include "ble/host/HostBLEInstance.h"
+
+/* Signal strength reported for every simulated advertisement. */
+static const int8_t HOST_ADVERTISEMENT_RSSI = -40;
+
+HostGap::HostGap(HostBLEInstance &instanceIn) :
+    Gap(),
+    instance(instanceIn),
+    addressType(ADDR_TYPE_RANDOM_STATIC),
+    address(),
+    advertisingType(GapAdvertisingParams::ADV_CONNECTABLE_UNDIRECTED),
+    advertisedPayload(),
+    advertisedScanResponse()
+{
+    /* empty */
+}
+
+ble_error_t
+HostGap::setAddress(AddressType_t type, const Address_t addressIn)
+{
+    addressType = type;
+    memcpy(address, addressIn, ADDR_LEN);
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGap::getAddress(AddressType_t *typeP, Address_t addressOut)
+{
+    *typeP = addressType;
+    memcpy(addressOut, address, ADDR_LEN);
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGap::stopAdvertising(void)
+{
+    state.advertising = 0;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGap::stopScan(void)
+{
+    scanningActive = false;
+    return BLE_ERROR_NONE;
+}
+
+/**
+ * Connect to the instance advertising connectably with the given address.
+ * There is no waiting for the peer to show up: if it isn't advertising at the
+ * time of the call, BLE_ERROR_INVALID_PARAM is returned.
+ */
+ble_error_t
+HostGap::connect(const Address_t           peerAddr,
+                 Gap::AddressType_t        peerAddrType,
+                 const ConnectionParams_t *connectionParams,
+                 const GapScanningParams  *scanParams)
+{
+    (void)peerAddrType;
+    (void)connectionParams;
+    (void)scanParams;
+
+    for (unsigned index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+        HostBLEInstance *peer = HostBLEInstance::getInstance(index);
+        if ((peer == NULL) || (peer == &instance)) {
+            continue;
+        }
+
+        const HostGap &peerGap = peer->getHostGap();
+        if (peerGap.isAdvertising() &&
+            ((peerGap.advertisingType == GapAdvertisingParams::ADV_CONNECTABLE_UNDIRECTED) ||
+             (peerGap.advertisingType == GapAdvertisingParams::ADV_CONNECTABLE_DIRECTED)) &&
+            (memcmp(peerGap.address, peerAddr, ADDR_LEN) == 0)) {
+            stopScan();
+            return HostBLEInstance::openLink(instance, *peer);
+        }
+    }
+
+    return BLE_ERROR_INVALID_PARAM;
+}
+
+ble_error_t
+HostGap::disconnect(Handle_t connectionHandle, DisconnectionReason_t reason)
+{
+    if (instance.getPeer(connectionHandle) == NULL) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    return HostBLEInstance::closeLink(connectionHandle, reason);
+}
+
+ble_error_t
+HostGap::disconnect(DisconnectionReason_t reason)
+{
+    Handle_t connectionHandle;
+    if (instance.getLinks(&connectionHandle, 1) == 0) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    return HostBLEInstance::closeLink(connectionHandle, reason);
+}
+
+void
+HostGap::processScan(void)
+{
+    if (!scanningActive) {
+        return;
+    }
+
+    for (unsigned index = 0; index < BLE_HOST_MAX_INSTANCES; index++) {
+        HostBLEInstance *peer = HostBLEInstance::getInstance(index);
+        if ((peer == NULL) || (peer == &instance) || !peer->getHostGap().isAdvertising()) {
+            continue;
+        }
+
+        const HostGap &peerGap = peer->getHostGap();
+        processAdvertisementReport(peerGap.address,
+                                   HOST_ADVERTISEMENT_RSSI,
+                                   false /* isScanResponse */,
+                                   peerGap.advertisingType,
+                                   peerGap.advertisedPayload.getPayloadLen(),
+                                   peerGap.advertisedPayload.getPayload());
+
+        if (_scanningParams.getActiveScanning() &&
+            (peerGap.advertisingType != GapAdvertisingParams::ADV_NON_CONNECTABLE_UNDIRECTED) &&
+            (peerGap.advertisedScanResponse.getPayloadLen() != 0)) {
+            processAdvertisementReport(peerGap.address,
+                                       HOST_ADVERTISEMENT_RSSI,
+                                       true /* isScanResponse */,
+                                       peerGap.advertisingType,
+                                       peerGap.advertisedScanResponse.getPayloadLen(),
+                                       peerGap.advertisedScanResponse.getPayload());
+        }
+    }
+}
+
+ble_error_t
+HostGap::startRadioScan(const GapScanningParams &scanningParams)
+{
+    (void)scanningParams;
+
+    return BLE_ERROR_NONE; /* reports are produced by processScan() */
+}
+
+ble_error_t
+HostGap::setAdvertisingData(const GapAdvertisingData &advData, const GapAdvertisingData &scanResponse)
+{
+    advertisedPayload      = advData;
+    advertisedScanResponse = scanResponse;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGap::startAdvertising(const GapAdvertisingParams &params)
+{
+    advertisingType   = params.getAdvertisingType();
+    state.advertising = 1;
+    return BLE_ERROR_NONE;
+}
+
+#endif // TARGET_LIKE_LINUX
@@ -0,0 +1,276 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(TARGET_LIKE_LINUX)
+
+#include <string.h>
+#include "ble/host/HostBLEInstance.h"
+#include "ble/AttPdu.h"
+
+HostGattClient::HostGattClient(HostBLEInstance &instanceIn) :
+    GattClient(),
+    instance(instanceIn),
+    discovery(*this, instanceIn)
+{
+    onDataReadCallback  = NULL;
+    onDataWriteCallback = NULL;
+    onHVXCallback       = NULL;
+}
+
+ble_error_t
+HostGattClient::launchServiceDiscovery(Gap::Handle_t                               connectionHandle,
+                                       ServiceDiscovery::ServiceCallback_t         sc,
+                                       ServiceDiscovery::CharacteristicCallback_t  cc,
+                                       const UUID                                 &matchingServiceUUIDIn,
+                                       const UUID                                 &matchingCharacteristicUUIDIn,
+                                       ServiceDiscovery::TerminationCallback_t     tc)
+{
+    if (instance.getPeer(connectionHandle) == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    return discovery.launch(connectionHandle, sc, cc, matchingServiceUUIDIn, matchingCharacteristicUUIDIn, tc);
+}
+
+ble_error_t
+HostGattClient::launchServiceDiscovery(Gap::Handle_t                               connectionHandle,
+                                       ServiceDiscovery::ServiceCallback_t         sc,
+                                       ServiceDiscovery::CharacteristicCallback_t  cc,
+                                       const UUIDSet                              &matchingServiceUUIDs,
+                                       const UUIDSet                              &matchingCharacteristicUUIDs,
+                                       ServiceDiscovery::TerminationCallback_t     tc)
+{
+    if (instance.getPeer(connectionHandle) == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    return discovery.launch(connectionHandle, sc, cc, matchingServiceUUIDs, matchingCharacteristicUUIDs, tc);
+}
+
+bool
+HostGattClient::isServiceDiscoveryActive(void) const
+{
+    return discovery.isActive();
+}
+
+bool
+HostGattClient::isServiceDiscoveryActive(Gap::Handle_t connectionHandle) const
+{
+    return discovery.isActive(connectionHandle);
+}
+
+void
+HostGattClient::terminateServiceDiscovery(void)
+{
+    discovery.terminate();
+}
+
+void
+HostGattClient::terminateServiceDiscovery(Gap::Handle_t connectionHandle)
+{
+    discovery.terminate(connectionHandle);
+}
+
+void
+HostGattClient::onServiceDiscoveryTermination(ServiceDiscovery::TerminationCallback_t callback)
+{
+    discovery.onTermination(callback);
+}
+
+ble_error_t
+HostGattClient::discoverCharacteristicDescriptors(const DiscoveredCharacteristic          &characteristic,
+                                                  ServiceDiscovery::DescriptorCallback_t   callback,
+                                                  const UUID                              &matchingUUID,
+                                                  ServiceDiscovery::TerminationCallback_t  tc)
+{
+    if (instance.getPeer(characteristic.getConnectionHandle()) == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    return discovery.launchDescriptorDiscovery(characteristic, callback, matchingUUID, tc);
+}
+
+ble_error_t
+HostGattClient::discoverDescriptors(Gap::Handle_t                            connectionHandle,
+                                    GattAttribute::Handle_t                  startHandle,
+                                    GattAttribute::Handle_t                  endHandle,
+                                    ServiceDiscovery::DescriptorCallback_t   callback,
+                                    const UUID                              &matchingUUID,
+                                    ServiceDiscovery::TerminationCallback_t  tc)
+{
+    if (instance.getPeer(connectionHandle) == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    return discovery.launchDescriptorDiscovery(connectionHandle, startHandle, endHandle, callback, matchingUUID, tc);
+}
+
+ble_error_t
+HostGattClient::read(Gap::Handle_t connHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset) const
+{
+    HostBLEInstance *peer = instance.getPeer(connHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_READ_REQUEST;
+    event.connHandle = connHandle;
+    event.handle     = attributeHandle;
+    event.offset     = offset;
+    event.len        = 0;
+
+    return peer->post(event);
+}
+
+/**
+ * Both kinds of Read Multiple are supported; the handles must fit in a
+ * request of ATT_MTU bytes.
+ */
+ble_error_t
+HostGattClient::readMultiple(Gap::Handle_t                  connHandle,
+                             const GattAttribute::Handle_t *handles,
+                             uint8_t                        count,
+                             bool                           variableLength) const
+{
+    HostBLEInstance *peer = instance.getPeer(connHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    if ((count < 2) || (1 + 2 * count > instance.getGap().getAttMtu(connHandle))) {
+        return BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_READ_MULTIPLE_REQUEST;
+    event.op         = variableLength ? 1 : 0;
+    event.connHandle = connHandle;
+    event.handle     = GattAttribute::INVALID_HANDLE;
+    event.offset     = 0;
+    event.len        = 2 * count;
+    for (unsigned i = 0; i < count; i++) {
+        AttPdu::writeUint16(&event.data[2 * i], handles[i]);
+    }
+
+    return peer->post(event);
+}
+
+/**
+ * Write requests are queued for the peer; write commands also take one of the
+ * local transmit buffers, as notifications do.
+ */
+ble_error_t
+HostGattClient::write(GattClient::WriteOp_t    cmd,
+                      Gap::Handle_t            connHandle,
+                      GattAttribute::Handle_t  attributeHandle,
+                      size_t                   length,
+                      const uint8_t           *value) const
+{
+    HostBLEInstance *peer = instance.getPeer(connHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    if (length > instance.getGap().getMaxPayload(connHandle)) {
+        return BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_WRITE_REQUEST;
+    event.connHandle = connHandle;
+    event.handle     = attributeHandle;
+    event.offset     = 0;
+    event.len        = length;
+    memcpy(event.data, value, length);
+
+    if (cmd == GATT_OP_WRITE_CMD) {
+        event.op = GattWriteCallbackParams::OP_WRITE_CMD;
+        return instance.transmit(*peer, event);
+    }
+
+    event.op = GattWriteCallbackParams::OP_WRITE_REQ;
+    return peer->post(event);
+}
+
+/**
+ * Both ends support BLE_GATT_MTU_SIZE_MAX, so the exchange settles on the
+ * client's offer; it is reported to both when they next process events.
+ */
+ble_error_t
+HostGattClient::exchangeMtu(Gap::Handle_t connHandle, uint16_t clientRxMtu)
+{
+    HostBLEInstance *peer = instance.getPeer(connHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+    if (clientRxMtu > BLE_GATT_MTU_SIZE_MAX) {
+        clientRxMtu = BLE_GATT_MTU_SIZE_MAX;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_ATT_MTU_CHANGE;
+    event.connHandle = connHandle;
+    event.offset     = clientRxMtu;
+
+    ble_error_t err = peer->post(event);
+    if (err != BLE_ERROR_NONE) {
+        return err;
+    }
+    return instance.post(event);
+}
+
+void
+HostGattClient::processAttResponse(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length)
+{
+    discovery.processResponse(connectionHandle, pdu, length);
+}
+
+void
+HostGattClient::processDisconnection(Gap::Handle_t connectionHandle)
+{
+    discovery.processDisconnection(connectionHandle);
+}
+
+void
+HostGattClient::reset(void)
+{
+    discovery.reset();
+}
+
+HostGattClient::HostDiscoveryEngine::HostDiscoveryEngine(HostGattClient &client, HostBLEInstance &instanceIn) :
+    GattDiscoveryEngine(client),
+    instance(instanceIn)
+{
+    /* empty */
+}
+
+ble_error_t
+HostGattClient::HostDiscoveryEngine::sendRequest(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_ATT_REQUEST;
+    event.connHandle = connectionHandle;
+    event.len        = length;
+    memcpy(event.data, pdu, length);
+
+    return peer->post(event);
+}
+
+#endif // TARGET_LIKE_LINUX
@@ -0,0 +1,621 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(TARGET_LIKE_LINUX)
+
+#include <string.h>
+#include "ble/host/HostBLEInstance.h"
+#include "ble/AttPdu.h"
+
+HostGattServer::HostGattServer(HostBLEInstance &instanceIn) :
+    GattServer(),
+    instance(instanceIn),
+    database(),
+    characteristicTableSize(0)
+{
+    /* empty */
+}
+
+ble_error_t
+HostGattServer::addService(GattService &service)
+{
+    if (characteristicTableSize + service.getCharacteristicCount() > BLE_HOST_MAX_CHARACTERISTICS) {
+        return BLE_ERROR_NO_MEM;
+    }
+
+    ble_error_t err = database.addService(service);
+    if (err != BLE_ERROR_NONE) {
+        return err;
+    }
+
+    for (unsigned i = 0; i < service.getCharacteristicCount(); i++) {
+        characteristics[characteristicTableSize++] = service.getCharacteristic(i);
+    }
+    serviceCount++;
+    characteristicCount += service.getCharacteristicCount();
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGattServer::addService(const GattServiceDefinition &definition, GattAttribute::Handle_t *valueHandles)
+{
+    ble_error_t err = database.addService(definition, valueHandles);
+    if (err != BLE_ERROR_NONE) {
+        return err;
+    }
+
+    serviceCount++;
+    characteristicCount += definition.characteristicCount;
+
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGattServer::read(GattAttribute::Handle_t attributeHandle, uint8_t buffer[], uint16_t *lengthP)
+{
+    return database.read(attributeHandle, buffer, lengthP);
+}
+
+ble_error_t
+HostGattServer::read(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint8_t *buffer, uint16_t *lengthP)
+{
+    (void)connectionHandle; /* values aren't kept per connection */
+
+    return database.read(attributeHandle, buffer, lengthP);
+}
+
+/**
+ * Update a value and notify every subscribed link. If some link has no
+ * transmit buffer left, the error is returned after trying the others.
+ */
+ble_error_t
+HostGattServer::write(GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size, bool localOnly)
+{
+    ble_error_t err = database.write(attributeHandle, value, size);
+    if ((err != BLE_ERROR_NONE) || localOnly) {
+        return err;
+    }
+
+    Gap::Handle_t connectionHandles[BLE_HOST_MAX_LINKS];
+    unsigned      linkCount = instance.getLinks(connectionHandles, BLE_HOST_MAX_LINKS);
+    for (unsigned i = 0; i < linkCount; i++) {
+        if (isSubscribed(connectionHandles[i], attributeHandle)) {
+            ble_error_t sendErr = sendNotification(connectionHandles[i], attributeHandle, value, size);
+            if (sendErr != BLE_ERROR_NONE) {
+                err = sendErr;
+            }
+        }
+    }
+
+    return err;
+}
+
+ble_error_t
+HostGattServer::write(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size, bool localOnly)
+{
+    ble_error_t err = database.write(attributeHandle, value, size);
+    if ((err != BLE_ERROR_NONE) || localOnly || !isSubscribed(connectionHandle, attributeHandle)) {
+        return err;
+    }
+
+    return sendNotification(connectionHandle, attributeHandle, value, size);
+}
+
+ble_error_t
+HostGattServer::sendUpdate(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size)
+{
+    if (!isSubscribed(connectionHandle, attributeHandle)) {
+        return BLE_ERROR_NONE;
+    }
+
+    return sendNotification(connectionHandle, attributeHandle, value, size);
+}
+
+ble_error_t
+HostGattServer::areUpdatesEnabled(const GattCharacteristic &characteristic, bool *enabledP)
+{
+    *enabledP = (getSubscriberCount(characteristic.getValueHandle()) != 0);
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t
+HostGattServer::areUpdatesEnabled(Gap::Handle_t connectionHandle, const GattCharacteristic &characteristic, bool *enabledP)
+{
+    *enabledP = isSubscribed(connectionHandle, characteristic.getValueHandle());
+    return BLE_ERROR_NONE;
+}
+
+void
+HostGattServer::reset(void)
+{
+    database.reset();
+    characteristicTableSize = 0;
+    serviceCount            = 0;
+    characteristicCount     = 0;
+}
+
+void
+HostGattServer::processWriteRequest(Gap::Handle_t                       connectionHandle,
+                                    GattAttribute::Handle_t             attributeHandle,
+                                    GattWriteCallbackParams::WriteOp_t  writeOp,
+                                    uint16_t                            offset,
+                                    const uint8_t                      *data,
+                                    uint16_t                            len)
+{
+    GattWriteCallbackParams params;
+    params.connHandle = connectionHandle;
+    params.handle     = attributeHandle;
+    params.writeOp    = writeOp;
+    params.offset     = offset;
+    params.len        = len;
+    params.data       = data;
+
+    bool                    applied = false;
+    GattAuthCallbackReply_t reply   = AUTH_CALLBACK_REPLY_SUCCESS;
+    if ((writeOp == GattWriteCallbackParams::OP_PREP_WRITE_REQ) ||
+        (writeOp == GattWriteCallbackParams::OP_EXEC_WRITE_REQ_CANCEL) ||
+        (writeOp == GattWriteCallbackParams::OP_EXEC_WRITE_REQ_NOW)) {
+        reply = handlePreparedWriteEvent(&params);
+    } else if (!database.isValidHandle(attributeHandle)) {
+        reply = AUTH_CALLBACK_REPLY_ATTERR_INVALID_HANDLE;
+    } else if (database.getType(attributeHandle) == UUID(BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG)) {
+        /* CCCD values are per connection; GattServer keeps track of them as subscriptions. */
+        if (offset != 0) {
+            reply = AUTH_CALLBACK_REPLY_ATTERR_ATTRIBUTE_NOT_LONG;
+        } else if (len != sizeof(uint16_t)) {
+            reply = AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+        } else {
+            uint16_t cccdValue = data[0] | (data[1] << 8);
+            if (handleSubscriptionEvent(connectionHandle, findValueHandleOfDescriptor(attributeHandle), cccdValue) != BLE_ERROR_NONE) {
+                reply = AUTH_CALLBACK_REPLY_ATTERR_INSUF_RESOURCES;
+            }
+        }
+    } else {
+        /* Properties apply to value attributes, which follow their characteristic's declaration. */
+        uint8_t required = (writeOp == GattWriteCallbackParams::OP_WRITE_CMD) ?
+                               GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE :
+                               GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE;
+        bool isValue    = (attributeHandle > database.getFirstHandle()) &&
+                          (database.getType(attributeHandle - 1) == UUID(BLE_UUID_CHARACTERISTIC));
+        bool authorized = !isValue || ((database.getProperties(attributeHandle) & required) != 0);
+
+        GattCharacteristic *characteristic = findCharacteristic(attributeHandle);
+        if ((characteristic != NULL) && authorized && characteristic->isWriteAuthorizationEnabled()) {
+            GattWriteAuthCallbackParams authParams;
+            authParams.connHandle         = connectionHandle;
+            authParams.handle             = attributeHandle;
+            authParams.offset             = offset;
+            authParams.len                = len;
+            authParams.data               = data;
+            authParams.authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS;
+            reply      = characteristic->authorizeWrite(&authParams);
+            authorized = (reply == AUTH_CALLBACK_REPLY_SUCCESS);
+        }
+
+        if (!authorized) {
+            if (reply == AUTH_CALLBACK_REPLY_SUCCESS) {
+                reply = AUTH_CALLBACK_REPLY_ATTERR_WRITE_NOT_PERMITTED;
+            }
+        } else if (offset == 0) {
+            applied = (database.write(attributeHandle, data, len) == BLE_ERROR_NONE);
+        } else if (offset > database.getLength(attributeHandle)) {
+            reply = AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET;
+        } else if ((unsigned)offset + len <= GattAttributeDatabase::VALUE_ARENA_SIZE) {
+            uint8_t value[GattAttributeDatabase::VALUE_ARENA_SIZE];
+            memcpy(value, database.getValuePtr(attributeHandle), offset);
+            memcpy(&value[offset], data, len);
+            applied = (database.write(attributeHandle, value, offset + len) == BLE_ERROR_NONE);
+        }
+        if (authorized && !applied && (reply == AUTH_CALLBACK_REPLY_SUCCESS)) {
+            reply = AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH;
+        }
+    }
+
+    if (applied) {
+        /* Place the value from the event buffer into the application's receive buffer, if it registered one. */
+        uint8_t *span = getReceiveSpan(attributeHandle, offset, len);
+        if (span != NULL) {
+            memcpy(span, data, len);
+            params.data = span;
+        }
+        handleDataWrittenEvent(&params);
+    }
+
+    /* Everything but a write command gets a response. */
+    if (writeOp == GattWriteCallbackParams::OP_WRITE_CMD) {
+        return;
+    }
+    if (reply != AUTH_CALLBACK_REPLY_SUCCESS) {
+        sendErrorResponse(connectionHandle, attributeHandle, reply);
+        return;
+    }
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer != NULL) {
+        HostBLEInstance::Event_t response;
+        response.type       = HostBLEInstance::EVENT_WRITE_RESPONSE;
+        response.op         = writeOp;
+        response.connHandle = connectionHandle;
+        response.handle     = attributeHandle;
+        response.offset     = offset;
+        response.len        = len;
+        peer->post(response);
+    }
+}
+
+void
+HostGattServer::processReadRequest(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return;
+    }
+
+    HostBLEInstance::Event_t response;
+    response.type       = HostBLEInstance::EVENT_READ_RESPONSE;
+    response.connHandle = connectionHandle;
+    response.handle     = attributeHandle;
+    response.offset     = offset;
+    response.len        = 0;
+
+    /* A Read Response carries up to ATT_MTU - 1 bytes. */
+    uint16_t maxLength = instance.getGap().getAttMtu(connectionHandle) - 1;
+    if (maxLength > HostBLEInstance::MAX_EVENT_DATA_LEN) {
+        maxLength = HostBLEInstance::MAX_EVENT_DATA_LEN;
+    }
+    response.len = maxLength;
+    GattAuthCallbackReply_t reply = readValue(connectionHandle, attributeHandle, offset, response.data, &response.len);
+    if (reply != AUTH_CALLBACK_REPLY_SUCCESS) {
+        sendErrorResponse(connectionHandle, attributeHandle, reply);
+        return;
+    }
+
+    peer->post(response);
+}
+
+/**
+ * Values are packed into a response of up to ATT_MTU - 1 bytes: whole, for
+ * Read Multiple, or each preceded by its length for Read Multiple Variable,
+ * where the last may be cut short. A value which can't be read fails the
+ * request, as an Error Response would.
+ */
+void
+HostGattServer::processReadMultipleRequest(Gap::Handle_t connectionHandle, const uint8_t *handles, uint16_t count, bool variableLength)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return;
+    }
+
+    HostBLEInstance::Event_t response;
+    response.type       = HostBLEInstance::EVENT_READ_MULTIPLE_RESPONSE;
+    response.op         = BLE_ERROR_NONE;
+    response.connHandle = connectionHandle;
+    response.handle     = GattAttribute::INVALID_HANDLE;
+    response.offset     = 0;
+    response.len        = 0;
+
+    uint16_t maxLength = instance.getGap().getAttMtu(connectionHandle) - 1;
+    if (maxLength > HostBLEInstance::MAX_EVENT_DATA_LEN) {
+        maxLength = HostBLEInstance::MAX_EVENT_DATA_LEN;
+    }
+
+    uint8_t value[HostBLEInstance::MAX_EVENT_DATA_LEN];
+    for (unsigned i = 0; i < count; i++) {
+        uint16_t length = sizeof(value);
+        GattAuthCallbackReply_t reply = readValue(connectionHandle, AttPdu::readUint16(&handles[2 * i]), 0, value, &length);
+        if (reply != AUTH_CALLBACK_REPLY_SUCCESS) {
+            response.op  = GattClient::getErrorStatus(reply);
+            response.len = 0;
+            break;
+        }
+
+        if (variableLength && (response.len + 2 <= maxLength)) {
+            AttPdu::writeUint16(&response.data[response.len], length);
+            response.len += 2;
+        }
+        uint16_t room = maxLength - response.len;
+        if (length > room) {
+            length = room;
+        }
+        memcpy(&response.data[response.len], value, length);
+        response.len += length;
+    }
+
+    peer->post(response);
+}
+
+/**
+ * The discovery requests: Read By Group Type, for primary services, Read By
+ * Type and Find Information. As many attributes as fit in ATT_MTU are packed
+ * into the response; other requests are refused with Request Not Supported.
+ */
+void
+HostGattServer::processAttRequest(Gap::Handle_t connectionHandle, const uint8_t *pdu, uint16_t length)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return;
+    }
+
+    HostBLEInstance::Event_t response;
+    response.type       = HostBLEInstance::EVENT_ATT_RESPONSE;
+    response.op         = 0;
+    response.connHandle = connectionHandle;
+    response.handle     = GattAttribute::INVALID_HANDLE;
+    response.offset     = 0;
+    response.len        = 0;
+
+    uint16_t capacity = instance.getGap().getAttMtu(connectionHandle);
+    if (capacity > HostBLEInstance::MAX_EVENT_DATA_LEN) {
+        capacity = HostBLEInstance::MAX_EVENT_DATA_LEN;
+    }
+
+    AttHandleRangeRequestView request(pdu, length);
+    uint8_t                   requestOpcode = (length != 0) ? pdu[0] : 0;
+    uint8_t                   errorCode     = AttPdu::ERROR_ATTRIBUTE_NOT_FOUND;
+    GattAttribute::Handle_t   errorHandle   = request.isValid() ? request.getStartHandle() : (GattAttribute::Handle_t)GattAttribute::INVALID_HANDLE;
+    if (!request.isValid()) {
+        errorCode = AttPdu::ERROR_REQUEST_NOT_SUPPORTED;
+    } else if (!request.isRangeValid()) {
+        errorCode = AttPdu::getErrorCode(AUTH_CALLBACK_REPLY_ATTERR_INVALID_HANDLE);
+    } else if (requestOpcode == AttPdu::FIND_INFORMATION_REQ) {
+        response.len = buildInformationList(request.getStartHandle(), request.getEndHandle(), response.data, capacity);
+    } else if (requestOpcode == AttPdu::READ_BY_GROUP_TYPE_REQ) {
+        if (request.getType() != UUID(BLE_UUID_SERVICE_PRIMARY)) {
+            errorCode = AttPdu::ERROR_UNSUPPORTED_GROUP_TYPE;
+        } else {
+            response.len = buildServiceList(request.getStartHandle(), request.getEndHandle(), response.data, capacity);
+        }
+    } else {
+        response.len = buildAttributeList(connectionHandle, request.getStartHandle(), request.getEndHandle(), request.getType(),
+                                          response.data, capacity, &errorHandle, &errorCode);
+    }
+
+    if (response.len == 0) {
+        response.len = AttPdu::buildErrorResponse(response.data, capacity, requestOpcode, errorHandle, errorCode);
+    }
+    peer->post(response);
+}
+
+/**
+ * A Read By Group Type Response listing the primary services in a range.
+ *
+ * @return the length of the response; 0 if there are no services in the range.
+ */
+uint16_t
+HostGattServer::buildServiceList(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle, uint8_t *buffer, uint16_t capacity) const
+{
+    const UUID             serviceType(BLE_UUID_SERVICE_PRIMARY);
+    AttListResponseBuilder builder(buffer, capacity, AttPdu::READ_BY_GROUP_TYPE_RSP);
+
+    GattAttribute::Handle_t handle = database.findAttribute(serviceType, startHandle, endHandle);
+    while (handle != GattAttribute::INVALID_HANDLE) {
+        GattAttribute::Handle_t serviceStart;
+        GattAttribute::Handle_t serviceEnd;
+        uint8_t                 uuid[UUID::LENGTH_OF_LONG_UUID];
+        uint16_t                uuidLength = sizeof(uuid);
+        database.getServiceRange(handle, &serviceStart, &serviceEnd);
+        database.read(handle, uuid, &uuidLength);
+        if (!builder.add(serviceStart, serviceEnd, uuid, uuidLength)) {
+            break;
+        }
+
+        handle = (serviceEnd < endHandle) ? database.findAttribute(serviceType, serviceEnd + 1, endHandle) : (GattAttribute::Handle_t)GattAttribute::INVALID_HANDLE;
+    }
+
+    return builder.getLength();
+}
+
+/**
+ * A Find Information Response listing the handles and types of the
+ * attributes in a range. A response holds types of one size only, so the
+ * list stops short of the first whose type differs in size from the first's.
+ *
+ * @return the length of the response; 0 if there are no attributes in the range.
+ */
+uint16_t
+HostGattServer::buildInformationList(GattAttribute::Handle_t startHandle, GattAttribute::Handle_t endHandle, uint8_t *buffer, uint16_t capacity) const
+{
+    AttListResponseBuilder builder(buffer, capacity, AttPdu::FIND_INFORMATION_RSP);
+    if (database.getAttributeCount() == 0) {
+        return 0;
+    }
+
+    unsigned first = (startHandle > database.getFirstHandle()) ? startHandle : database.getFirstHandle();
+    unsigned last  = (endHandle < database.getLastHandle()) ? endHandle : database.getLastHandle();
+    for (unsigned handle = first; handle <= last; handle++) {
+        if (!builder.add((GattAttribute::Handle_t)handle, database.getType((GattAttribute::Handle_t)handle))) {
+            break;
+        }
+    }
+
+    return builder.getLength();
+}
+
+/**
+ * A Read By Type Response listing the attributes of a type in a range.
+ * Declarations are read directly; other values are subject to read
+ * authorization, and the list stops short of the first which can't be read.
+ *
+ * @return the length of the response; 0 if there is nothing to list, in
+ *         which case *errorHandleP and *errorCodeP describe the Error Response.
+ */
+uint16_t
+HostGattServer::buildAttributeList(Gap::Handle_t            connectionHandle,
+                                   GattAttribute::Handle_t  startHandle,
+                                   GattAttribute::Handle_t  endHandle,
+                                   const UUID              &type,
+                                   uint8_t                 *buffer,
+                                   uint16_t                 capacity,
+                                   GattAttribute::Handle_t *errorHandleP,
+                                   uint8_t                 *errorCodeP)
+{
+    bool isDeclaration = (type == UUID(type.getShortUUID())) &&
+                         (type.getShortUUID() >= BLE_UUID_SERVICE_PRIMARY) && (type.getShortUUID() <= BLE_UUID_CHARACTERISTIC);
+    AttListResponseBuilder builder(buffer, capacity, AttPdu::READ_BY_TYPE_RSP);
+
+    GattAttribute::Handle_t handle = database.findAttribute(type, startHandle, endHandle);
+    while (handle != GattAttribute::INVALID_HANDLE) {
+        uint8_t  value[HostBLEInstance::MAX_EVENT_DATA_LEN];
+        uint16_t valueLength = sizeof(value);
+        if (isDeclaration) {
+            database.read(handle, value, &valueLength);
+        } else {
+            GattAuthCallbackReply_t reply = readValue(connectionHandle, handle, 0, value, &valueLength);
+            if (reply != AUTH_CALLBACK_REPLY_SUCCESS) {
+                if (builder.getCount() == 0) {
+                    *errorHandleP = handle;
+                    *errorCodeP   = AttPdu::getErrorCode(reply);
+                }
+                break;
+            }
+        }
+        if (!builder.add(handle, value, valueLength)) {
+            break;
+        }
+
+        handle = (handle < endHandle) ? database.findAttribute(type, handle + 1, endHandle) : (GattAttribute::Handle_t)GattAttribute::INVALID_HANDLE;
+    }
+
+    return builder.getLength();
+}
+
+/**
+ * Read a value for a peer, subject to read authorization, and report it to
+ * onDataRead() callbacks.
+ *
+ * @return AUTH_CALLBACK_REPLY_SUCCESS, or the error to respond with.
+ */
+GattAuthCallbackReply_t
+HostGattServer::readValue(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint16_t offset, uint8_t *buffer, uint16_t *lengthP)
+{
+    if (!database.isValidHandle(attributeHandle)) {
+        return AUTH_CALLBACK_REPLY_ATTERR_INVALID_HANDLE;
+    }
+
+    GattCharacteristic *characteristic = findCharacteristic(attributeHandle);
+    if ((characteristic != NULL) && characteristic->isReadAuthorizationEnabled()) {
+        GattReadAuthCallbackParams authParams;
+        authParams.connHandle         = connectionHandle;
+        authParams.handle             = attributeHandle;
+        authParams.offset             = offset;
+        authParams.len                = 0;
+        authParams.data               = NULL;
+        authParams.authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS;
+        GattAuthCallbackReply_t reply = characteristic->authorizeRead(&authParams);
+        if (reply != AUTH_CALLBACK_REPLY_SUCCESS) {
+            return reply;
+        }
+        if (authParams.data != NULL) {
+            database.write(attributeHandle, authParams.data, authParams.len);
+        }
+    }
+
+    uint16_t maxLength = *lengthP;
+    if (database.read(attributeHandle, offset, buffer, lengthP) != BLE_ERROR_NONE) {
+        return AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET;
+    }
+    if (*lengthP > maxLength) {
+        *lengthP = maxLength;
+    }
+
+    GattReadCallbackParams params;
+    params.connHandle = connectionHandle;
+    params.handle     = attributeHandle;
+    params.offset     = offset;
+    params.len        = *lengthP;
+    params.data       = buffer;
+    handleDataReadEvent(&params);
+
+    return AUTH_CALLBACK_REPLY_SUCCESS;
+}
+
+void
+HostGattServer::sendErrorResponse(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, GattAuthCallbackReply_t error)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return;
+    }
+
+    HostBLEInstance::Event_t response;
+    response.type       = HostBLEInstance::EVENT_ERROR_RESPONSE;
+    response.op         = AttPdu::getErrorCode(error);
+    response.connHandle = connectionHandle;
+    response.handle     = attributeHandle;
+    response.offset     = 0;
+    response.len        = 0;
+    peer->post(response);
+}
+
+/**
+ * Notifications carry up to ATT_MTU - 3 bytes; longer values are truncated.
+ * Indications aren't simulated: subscribers receive notifications either way.
+ */
+ble_error_t
+HostGattServer::sendNotification(Gap::Handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size)
+{
+    HostBLEInstance *peer = instance.getPeer(connectionHandle);
+    if (peer == NULL) {
+        return BLE_ERROR_INVALID_STATE;
+    }
+
+    uint16_t maxPayload = instance.getGap().getMaxPayload(connectionHandle);
+    if (size > maxPayload) {
+        size = maxPayload;
+    }
+
+    HostBLEInstance::Event_t event;
+    event.type       = HostBLEInstance::EVENT_HVX;
+    event.op         = BLE_HVX_NOTIFICATION;
+    event.connHandle = connectionHandle;
+    event.handle     = attributeHandle;
+    event.offset     = 0;
+    event.len        = size;
+    memcpy(event.data, value, size);
+
+    return instance.transmit(*peer, event);
+}
+
+GattCharacteristic *
+HostGattServer::findCharacteristic(GattAttribute::Handle_t valueHandle)
+{
+    for (unsigned i = 0; i < characteristicTableSize; i++) {
+        if (characteristics[i]->getValueHandle() == valueHandle) {
+            return characteristics[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Descriptors follow their characteristic's value attribute, which in turn
+ * follows the characteristic declaration.
+ */
+GattAttribute::Handle_t
+HostGattServer::findValueHandleOfDescriptor(GattAttribute::Handle_t descriptorHandle) const
+{
+    const UUID declarationType(BLE_UUID_CHARACTERISTIC);
+    for (GattAttribute::Handle_t handle = descriptorHandle - 1; handle > database.getFirstHandle(); handle--) {
+        if (database.getType(handle - 1) == declarationType) {
+            return handle;
+        }
+    }
+    return GattAttribute::INVALID_HANDLE;
+}
+
+#endif // TARGET_LIKE_LINUX